@@ -0,0 +1,240 @@
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <vector>
+
+#include "csdb/internal/endian.h"
+#include "integral_encdec.h"
+
+namespace {
+
+// Предыдущая (побитовая) реализация кодирования, оставлена для сравнения.
+namespace legacy {
+
+std::size_t encode(void *buf, uint64_t value)
+{
+  value = ::csdb::internal::to_little_endian(value);
+  uint8_t bits = (sizeof(uint64_t) * 8);
+  uint64_t mask = (static_cast<uint64_t>(1) << (bits - 1));
+  bool new_bit = (0 != (mask & value)), bit;
+  do {
+    bit = new_bit;
+    mask >>= 1;
+    new_bit = (0 != (mask & value));
+  } while ((bit == new_bit) && (7 < (--bits)));
+
+  uint8_t bytes = 8;
+  uint8_t first = '\xFF';
+  if (57 > bits) {
+    bytes = ((bits - 1) / 7);
+    first = static_cast<char>((value << (bytes + 1)) | ((1 << bytes) - 1));
+    value >>= (7 - bytes);
+  }
+  uint8_t *buffer = static_cast<uint8_t*>(buf);
+  *(buffer++) = first;
+  if (0 < bytes) {
+    memcpy(buffer, &value, bytes);
+  }
+  return bytes + sizeof(uint8_t);
+}
+
+std::size_t decode(const void *buf, std::size_t size, uint64_t& value)
+{
+  if (sizeof(uint8_t) > size) {
+    return 0;
+  }
+  const char* d = static_cast<const char*>(buf);
+  uint8_t first = static_cast<uint8_t>(*d);
+  uint8_t bytes = 0;
+  for (uint8_t mask = first; 0 != (mask & 0x1); ++bytes, mask >>= 1) {}
+  if ((bytes + 1) > size) {
+    return 0;
+  }
+
+  uint64_t val = 0;
+  if (bytes > 0) {
+    memcpy(&val, d + 1, bytes);
+  }
+  if (8 > bytes) {
+    val <<= (7 - bytes);
+    val |= (first >> (bytes + 1));
+    if (0 != (d[bytes] & 0x80)) {
+      val |= static_cast<uint64_t>(-1) << ((bytes + 1) * 7);
+    }
+  }
+  value = ::csdb::internal::from_little_endian(val);
+  return bytes + 1;
+}
+
+} // namespace legacy
+
+const size_t values_count = 4096;
+
+/// Набор значений, типичный для пула: в основном небольшие счётчики и размеры,
+/// реже - дробные части сумм и знаковые значения.
+std::vector<uint64_t> make_values()
+{
+  std::vector<uint64_t> res;
+  res.reserve(values_count);
+  uint64_t x = 0x9E3779B97F4A7C15ULL;
+  for (size_t i = 0; i < values_count; ++i) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    switch (i % 4) {
+    case 0: res.push_back(x & 0x3F); break;
+    case 1: res.push_back(x & 0xFFFF); break;
+    case 2: res.push_back(x >> 4); break;
+    default: res.push_back(static_cast<uint64_t>(-static_cast<int64_t>(x & 0xFFFFFF))); break;
+    }
+  }
+  return res;
+}
+
+/// Однобайтовые значения: количества, типы и длины коротких полей.
+std::vector<uint64_t> make_small_values()
+{
+  std::vector<uint64_t> res;
+  res.reserve(values_count);
+  for (size_t i = 0; i < values_count; ++i) {
+    res.push_back((i * 7) % 64);
+  }
+  return res;
+}
+
+/// Суммы и остатки транзакций в том виде, в котором они записаны в пуле: целая и дробная
+/// части суммы, затем целая и дробная части остатка (как правило, нулевого).
+std::vector<uint64_t> make_amount_values()
+{
+  std::vector<uint64_t> res;
+  res.reserve(values_count);
+  for (size_t i = 0; i < values_count / 4; ++i) {
+    res.push_back(i + 1);
+    res.push_back((i % 4) * 250000000000000000ULL);
+    res.push_back(0);
+    res.push_back(0);
+  }
+  return res;
+}
+
+template<std::size_t (*Encode)(void*, uint64_t)>
+std::vector<uint8_t> encode_all(const std::vector<uint64_t>& values)
+{
+  std::vector<uint8_t> res(values.size() * ::csdb::priv::MAX_INTEGRAL_ENCODED_SIZE);
+  size_t pos = 0;
+  for (uint64_t v : values) {
+    pos += Encode(res.data() + pos, v);
+  }
+  res.resize(pos);
+  return res;
+}
+
+std::size_t current_encode(void *buf, uint64_t value)
+{
+  return ::csdb::priv::encode(buf, value);
+}
+
+std::size_t current_decode(const void *buf, std::size_t size, uint64_t& value)
+{
+  return ::csdb::priv::decode(buf, size, value);
+}
+
+template<std::size_t (*Encode)(void*, uint64_t)>
+void encode_benchmark(benchmark::State &state)
+{
+  const std::vector<uint64_t> values = make_values();
+  std::vector<uint8_t> buf(values.size() * ::csdb::priv::MAX_INTEGRAL_ENCODED_SIZE);
+  for (auto _ : state) {
+    size_t pos = 0;
+    for (uint64_t v : values) {
+      pos += Encode(buf.data() + pos, v);
+    }
+    benchmark::DoNotOptimize(pos);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+template<std::size_t (*Decode)(const void*, std::size_t, uint64_t&)>
+void decode_benchmark(benchmark::State &state, const std::vector<uint64_t>& values)
+{
+  const std::vector<uint8_t> buf = encode_all<current_encode>(values);
+  if (buf != encode_all<legacy::encode>(values)) {
+    state.SkipWithError("Encoded data differs from the legacy implementation.");
+    return;
+  }
+  for (auto _ : state) {
+    size_t pos = 0;
+    uint64_t sum = 0;
+    while (pos < buf.size()) {
+      uint64_t v;
+      pos += Decode(buf.data() + pos, buf.size() - pos, v);
+      sum += v;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * values.size());
+  state.SetBytesProcessed(state.iterations() * buf.size());
+}
+
+/// Декодирование группами по group значений, как это делается при чтении пула.
+void decode_batch_benchmark(benchmark::State &state, const std::vector<uint64_t>& values, size_t group)
+{
+  const std::vector<uint8_t> buf = encode_all<current_encode>(values);
+  std::vector<uint64_t> res(values.size());
+  for (auto _ : state) {
+    size_t pos = 0;
+    for (size_t i = 0; i < values.size(); i += group) {
+      pos += ::csdb::priv::decode_batch(buf.data() + pos, buf.size() - pos, res.data() + i, group);
+    }
+    benchmark::DoNotOptimize(pos);
+    benchmark::ClobberMemory();
+  }
+  if (res != values) {
+    state.SkipWithError("Batch decoding result differs from the source values.");
+    return;
+  }
+  state.SetItemsProcessed(state.iterations() * values.size());
+  state.SetBytesProcessed(state.iterations() * buf.size());
+}
+
+} // namespace
+
+static void BM_VarintEncodeLegacy(benchmark::State &state) { encode_benchmark<legacy::encode>(state); }
+BENCHMARK(BM_VarintEncodeLegacy);
+
+static void BM_VarintEncode(benchmark::State &state) { encode_benchmark<current_encode>(state); }
+BENCHMARK(BM_VarintEncode);
+
+static void BM_VarintDecodeLegacy(benchmark::State &state) { decode_benchmark<legacy::decode>(state, make_values()); }
+BENCHMARK(BM_VarintDecodeLegacy);
+
+static void BM_VarintDecode(benchmark::State &state) { decode_benchmark<current_decode>(state, make_values()); }
+BENCHMARK(BM_VarintDecode);
+
+static void BM_VarintDecodeBatch(benchmark::State &state) { decode_batch_benchmark(state, make_values(), values_count); }
+BENCHMARK(BM_VarintDecodeBatch);
+
+static void BM_VarintDecodeSmall(benchmark::State &state)
+{
+  decode_benchmark<current_decode>(state, make_small_values());
+}
+BENCHMARK(BM_VarintDecodeSmall);
+
+static void BM_VarintDecodeSmallBatch(benchmark::State &state)
+{
+  decode_batch_benchmark(state, make_small_values(), values_count);
+}
+BENCHMARK(BM_VarintDecodeSmallBatch);
+
+static void BM_VarintDecodeAmounts(benchmark::State &state)
+{
+  decode_benchmark<current_decode>(state, make_amount_values());
+}
+BENCHMARK(BM_VarintDecodeAmounts);
+
+static void BM_VarintDecodeAmountsBatch(benchmark::State &state)
+{
+  decode_batch_benchmark(state, make_amount_values(), 4);
+}
+BENCHMARK(BM_VarintDecodeAmountsBatch);
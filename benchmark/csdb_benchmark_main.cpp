@@ -1,11 +1,384 @@
 #include <benchmark/benchmark.h>
 
-static void bench(benchmark::State &state)
+#include <string>
+#include <vector>
+
+#include "csdb/address.h"
+#include "csdb/amount.h"
+#include "csdb/currency.h"
+#include "csdb/database_leveldb.h"
+#include "csdb/pool.h"
+#include "csdb/pool_builder.h"
+#include "csdb/storage.h"
+#include "csdb/transaction.h"
+#include "csdb/wallet.h"
+#include "csdb/internal/utils.h"
+#include "priv_crypto.h"
+
+namespace {
+
+const size_t addresses_count = 256;
+const size_t transactions_per_pool = 100;
+
+::csdb::Address make_address(size_t index)
+{
+  ::csdb::internal::byte_array key(32, 0);
+  for (size_t i = 0; i < sizeof(index); ++i) {
+    key[i] = static_cast<uint8_t>(index >> (i * 8));
+  }
+  key[31] = 0xAA;
+  return ::csdb::Address::from_public_key(key);
+}
+
+::csdb::Pool make_pool(const ::csdb::PoolHash& previous, ::csdb::Pool::sequence_t sequence, size_t transactions,
+                       ::csdb::Pool::Format format = ::csdb::Pool::LegacyFormat)
+{
+  const ::csdb::Currency currency("CS");
+  ::csdb::Pool pool(previous, sequence);
+  pool.set_format(format);
+  for (size_t i = 0; i < transactions; ++i) {
+    ::csdb::Transaction t(make_address((sequence + i) % addresses_count),
+                          make_address((sequence + i + 1) % addresses_count),
+                          currency,
+                          ::csdb::Amount(static_cast<int32_t>(i + 1), 25, 100));
+    pool.add_transaction(t);
+  }
+  return pool;
+}
+
+/// Создаёт в указанной папке хранилище с цепочкой из pools пулов.
+std::string make_storage(size_t pools, ::csdb::Pool::Format format = ::csdb::Pool::LegacyFormat)
+{
+  const std::string path = ::csdb::internal::app_data_path() + "csdb_benchmark_" + std::to_string(pools)
+      + "_" + std::to_string(format);
+  ::csdb::internal::path_remove(path);
+
+  ::csdb::Storage s;
+  s.open(path);
+  ::csdb::PoolHash previous;
+  for (size_t i = 0; i < pools; ++i) {
+    ::csdb::Pool pool = make_pool(previous, i, transactions_per_pool, format);
+    pool.compose();
+    pool.save(s);
+    previous = pool.hash();
+  }
+  return path;
+}
+
+} // namespace
+
+static void BM_StorageOpen(benchmark::State &state)
+{
+  const std::string path = make_storage(static_cast<size_t>(state.range(0)));
+  for (auto _ : state) {
+    ::csdb::Storage s;
+    benchmark::DoNotOptimize(s.open(path));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  ::csdb::internal::path_remove(path);
+}
+BENCHMARK(BM_StorageOpen)->Arg(100)->Arg(1000)->Unit(benchmark::kMillisecond);
+
+// Открытие с проверкой контрольных сумм (0), с полной проверкой хешей (1) и повторное открытие
+// без проверки уже проверенных пулов (2).
+static void BM_StorageOpenVerification(benchmark::State &state)
+{
+  const std::string path = make_storage(static_cast<size_t>(state.range(0)));
+  const auto verification = static_cast<::csdb::Storage::Verification>(state.range(1));
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto db = ::std::make_shared<::csdb::DatabaseLevelDB>();
+    db->open(path);
+    state.ResumeTiming();
+    ::csdb::Storage s;
+    benchmark::DoNotOptimize(s.open(::csdb::Storage::OpenOptions{db, verification}));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  ::csdb::internal::path_remove(path);
+}
+BENCHMARK(BM_StorageOpenVerification)
+  ->ArgsProduct({{1000}, {::csdb::Storage::ChecksumVerification, ::csdb::Storage::FullVerification,
+                          ::csdb::Storage::IncrementalVerification}})
+  ->Unit(benchmark::kMillisecond);
+
+static void BM_WalletGet(benchmark::State &state)
+{
+  const std::string path = make_storage(static_cast<size_t>(state.range(0)),
+                                        static_cast<::csdb::Pool::Format>(state.range(1)));
+  ::csdb::Storage s(::csdb::Storage::get(path));
+  const ::csdb::Address address = make_address(1);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(::csdb::Wallet::get(address, s));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0) * transactions_per_pool);
+  s.close();
+  ::csdb::internal::path_remove(path);
+}
+BENCHMARK(BM_WalletGet)
+  ->Args({100, ::csdb::Pool::LegacyFormat})->Args({1000, ::csdb::Pool::LegacyFormat})
+  ->Args({100, ::csdb::Pool::ColumnarFormat})->Args({1000, ::csdb::Pool::ColumnarFormat})
+  ->Unit(benchmark::kMillisecond);
+
+static void BM_PoolValidateBalance(benchmark::State &state)
+{
+  const size_t pools = static_cast<size_t>(state.range(0));
+  const std::string path = make_storage(pools, static_cast<::csdb::Pool::Format>(state.range(1)));
+  ::csdb::Storage s(::csdb::Storage::get(path));
+  const ::csdb::Pool pool = make_pool(s.last_hash(), pools, 1000);
+  ::csdb::BalanceValidator validator(s);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(pool.validate(validator, static_cast<size_t>(state.range(2))));
+  }
+  state.SetItemsProcessed(state.iterations() * pools * transactions_per_pool);
+  s.close();
+  ::csdb::internal::path_remove(path);
+}
+BENCHMARK(BM_PoolValidateBalance)
+  ->ArgsProduct({{1000}, {::csdb::Pool::LegacyFormat, ::csdb::Pool::ColumnarFormat}, {1, 0}})
+  ->Unit(benchmark::kMillisecond);
+
+static void BM_StoragePoolLoad(benchmark::State &state)
+{
+  const size_t pools = 200;
+  const std::string path = ::csdb::internal::app_data_path() + "csdb_benchmark_compression";
+  ::csdb::internal::path_remove(path);
+
+  auto db = std::make_shared<::csdb::DatabaseLevelDB>();
+  db->open(path);
+  std::shared_ptr<::csdb::Database> database = db;
+  ::csdb::Storage s;
+  s.open(::csdb::Storage::OpenOptions{db});
+  s.set_compression(static_cast<::csdb::Storage::Compression>(state.range(1)));
+
+  std::vector<::csdb::PoolHash> hashes;
+  ::csdb::PoolHash previous;
+  size_t record_bytes = 0;
+  for (size_t i = 0; i < pools; ++i) {
+    if ((pools / 2) == i) {
+      s.train_compression_dictionary();
+    }
+    ::csdb::Pool pool = make_pool(previous, i, transactions_per_pool,
+                                  static_cast<::csdb::Pool::Format>(state.range(0)));
+    pool.compose();
+    s.pool_save(pool);
+    previous = pool.hash();
+    hashes.push_back(previous);
+
+    ::csdb::internal::byte_array record;
+    database->get(previous.to_binary(), &record);
+    record_bytes += record.size();
+  }
+
+  for (auto _ : state) {
+    for (const auto& hash : hashes) {
+      benchmark::DoNotOptimize(s.pool_load(hash));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * pools * transactions_per_pool);
+  state.counters["bytes_per_tx"] = static_cast<double>(record_bytes) / (pools * transactions_per_pool);
+  s.close();
+  ::csdb::internal::path_remove(path);
+}
+BENCHMARK(BM_StoragePoolLoad)
+  ->Args({::csdb::Pool::LegacyFormat, ::csdb::Storage::NoCompression})
+  ->Args({::csdb::Pool::LegacyFormat, ::csdb::Storage::FastCompression})
+  ->Args({::csdb::Pool::LegacyFormat, ::csdb::Storage::DictionaryCompression})
+  ->Args({::csdb::Pool::DictionaryFormat, ::csdb::Storage::NoCompression})
+  ->Args({::csdb::Pool::DictionaryFormat, ::csdb::Storage::FastCompression})
+  ->Args({::csdb::Pool::DictionaryFormat, ::csdb::Storage::DictionaryCompression})
+  ->Unit(benchmark::kMillisecond);
+
+static void BM_PoolBuildCopy(benchmark::State &state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const ::csdb::Currency currency("CS");
+  for (auto _ : state) {
+    ::csdb::Pool pool(::csdb::PoolHash{}, 0);
+    for (size_t i = 0; i < count; ++i) {
+      ::csdb::Transaction t(make_address(i % addresses_count), make_address((i + 1) % addresses_count),
+                            currency, ::csdb::Amount(1));
+      pool.add_transaction(t);
+    }
+    benchmark::DoNotOptimize(pool.transactions_count());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PoolBuildCopy)->Arg(1000)->Arg(50000)->Unit(benchmark::kMillisecond);
+
+static void BM_PoolBuildMove(benchmark::State &state)
 {
-  for(auto _ : state)
-  {
+  const size_t count = static_cast<size_t>(state.range(0));
+  const ::csdb::Currency currency("CS");
+  for (auto _ : state) {
+    ::csdb::Pool pool(::csdb::PoolHash{}, 0);
+    pool.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      pool.add_transaction(::csdb::Transaction(make_address(i % addresses_count),
+                                               make_address((i + 1) % addresses_count),
+                                               currency, ::csdb::Amount(1)));
+    }
+    benchmark::DoNotOptimize(pool.transactions_count());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PoolBuildMove)->Arg(1000)->Arg(50000)->Unit(benchmark::kMillisecond);
+
+// Наполнение пула с проверкой суммы уже добавленных транзакций отправителя перед каждой новой.
+static void BM_PoolBuildCheckDebit(benchmark::State &state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const ::csdb::Currency currency("CS");
+  for (auto _ : state) {
+    ::csdb::Pool pool(::csdb::PoolHash{}, 0);
+    pool.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      const ::csdb::Address source = make_address(i % addresses_count);
+      if (pool.get_last_by_source(source).is_valid()) {
+        benchmark::DoNotOptimize(pool.debit(source, currency));
+      }
+      pool.add_transaction(::csdb::Transaction(source, make_address((i + 1) % addresses_count),
+                                               currency, ::csdb::Amount(1)));
+    }
+    benchmark::DoNotOptimize(pool.transactions_count());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PoolBuildCheckDebit)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+// Время compose() для заранее наполненного пула: сериализация и хеширование целиком.
+static void BM_PoolCompose(benchmark::State &state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    ::csdb::Pool pool = make_pool(::csdb::PoolHash{}, 0, count);
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(pool.compose());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PoolCompose)->Arg(1000)->Arg(50000)->Unit(benchmark::kMicrosecond);
+
+// Время закрытия блока: compose() (threads == 1) против compose(threads) для пулов разного размера.
+static void BM_PoolComposeParallel(benchmark::State &state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const size_t threads = static_cast<size_t>(state.range(1));
+  const ::csdb::Pool::Format format = static_cast<::csdb::Pool::Format>(state.range(2));
+  for (auto _ : state) {
+    state.PauseTiming();
+    ::csdb::Pool pool = make_pool(::csdb::PoolHash{}, 0, count, format);
+    state.ResumeTiming();
+    benchmark::DoNotOptimize((1 == threads) ? pool.compose() : pool.compose(threads));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PoolComposeParallel)
+  ->ArgsProduct({{1000, 10000, 50000, 200000}, {1, 2, 4, 8}, {::csdb::Pool::LegacyFormat, ::csdb::Pool::MerkleFormat}})
+  ->UseRealTime()
+  ->Unit(benchmark::kMicrosecond);
+
+// То же для формата со словарём адресов; bytes_per_tx - размер бинарного представления.
+static void BM_PoolComposeDictionary(benchmark::State &state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  size_t size = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    ::csdb::Pool pool = make_pool(::csdb::PoolHash{}, 0, count, ::csdb::Pool::DictionaryFormat);
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(pool.compose());
+    size = pool.to_binary().size();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["bytes_per_tx"] = static_cast<double>(size) / static_cast<double>(count);
+}
+BENCHMARK(BM_PoolComposeDictionary)->Arg(1000)->Arg(50000)->Unit(benchmark::kMicrosecond);
+
+// Время compose() у PoolBuilder: транзакции сериализованы и захешированы при добавлении.
+static void BM_PoolBuilderCompose(benchmark::State &state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    ::csdb::Pool src = make_pool(::csdb::PoolHash{}, 0, count);
+    ::csdb::PoolBuilder builder(::csdb::PoolHash{}, 0, count);
+    for (auto& it : src.transactions()) {
+      builder.add_transaction(::std::move(it));
+    }
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(builder.compose());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PoolBuilderCompose)->Arg(1000)->Arg(50000)->Unit(benchmark::kMicrosecond);
+
+// Сериализация отдельных транзакций без хеширования.
+static void BM_TransactionToBinary(benchmark::State &state)
+{
+  ::csdb::Pool pool = make_pool(::csdb::PoolHash{}, 0, static_cast<size_t>(state.range(0)));
+  size_t bytes = 0;
+  for (auto _ : state) {
+    bytes = 0;
+    for (auto& it : pool.transactions()) {
+      bytes += it.to_binary().size();
+    }
+    benchmark::DoNotOptimize(bytes);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(bytes));
+}
+BENCHMARK(BM_TransactionToBinary)->Arg(1000)->Unit(benchmark::kMicrosecond);
+
+static void BM_PoolFromBinary(benchmark::State &state)
+{
+  ::csdb::Pool pool = make_pool(::csdb::PoolHash{}, 0, static_cast<size_t>(state.range(0)),
+                                static_cast<::csdb::Pool::Format>(state.range(1)));
+  pool.compose();
+  const ::csdb::internal::byte_array data = pool.to_binary();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(::csdb::Pool::from_binary(data));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(data.size()));
+}
+BENCHMARK(BM_PoolFromBinary)
+  ->Args({1000, ::csdb::Pool::LegacyFormat})->Args({50000, ::csdb::Pool::LegacyFormat})
+  ->Args({1000, ::csdb::Pool::DictionaryFormat})->Args({50000, ::csdb::Pool::DictionaryFormat})
+  ->Args({1000, ::csdb::Pool::ColumnarFormat})->Args({50000, ::csdb::Pool::ColumnarFormat})
+  ->Unit(benchmark::kMicrosecond);
+
+/// Хеши 64 пулов по range(0) транзакций: по одному (range(1) == 0) или пачкой.
+static void BM_PoolHash(benchmark::State &state)
+{
+  std::vector<::csdb::internal::byte_array> data;
+  std::vector<const ::csdb::internal::byte_array*> pointers;
+  int64_t bytes = 0;
+  for (size_t i = 0; i < 64; ++i) {
+    ::csdb::Pool pool = make_pool(::csdb::PoolHash{}, i, static_cast<size_t>(state.range(0)));
+    pool.compose();
+    data.push_back(pool.to_binary());
+    bytes += static_cast<int64_t>(data.back().size());
+  }
+  for (const auto& it : data) {
+    pointers.push_back(&it);
+  }
+
+  const bool batch = (0 != state.range(1));
+  for (auto _ : state) {
+    if (batch) {
+      benchmark::DoNotOptimize(::csdb::priv::crypto::calc_hashes(pointers));
+    } else {
+      for (const auto& it : data) {
+        benchmark::DoNotOptimize(::csdb::priv::crypto::calc_hash(it));
+      }
+    }
   }
+  state.SetItemsProcessed(state.iterations() * data.size());
+  state.SetBytesProcessed(state.iterations() * bytes);
 }
-BENCHMARK(bench);
+BENCHMARK(BM_PoolHash)
+  ->Args({1, 0})->Args({1, 1})->Args({100, 0})->Args({100, 1})->Args({1000, 0})->Args({1000, 1})
+  ->Unit(benchmark::kMicrosecond);
 
 BENCHMARK_MAIN();
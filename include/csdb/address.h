@@ -8,6 +8,7 @@
 #define _CREDITS_CSDB_ADDRESS_H_INCLUDED_
 
 #include <string>
+#include <functional>
 
 #include "csdb/internal/shared_data.h"
 #include "csdb/internal/types.h"
@@ -17,6 +18,7 @@ namespace csdb {
 namespace priv {
 class obstream;
 class ibstream;
+class unchecked_ibstream;
 } // namespace priv
 
 class Address
@@ -45,8 +47,12 @@ public:
 private:
   void put(::csdb::priv::obstream&) const;
   bool get(::csdb::priv::ibstream&);
+  void get(::csdb::priv::unchecked_ibstream&);
+  size_t serialized_size() const noexcept;
   friend class ::csdb::priv::obstream;
   friend class ::csdb::priv::ibstream;
+  friend class ::csdb::priv::unchecked_ibstream;
+  friend struct ::std::hash<Address>;
 };
 
 inline bool Address::operator !=(const Address &other) const noexcept
@@ -56,4 +62,12 @@ inline bool Address::operator !=(const Address &other) const noexcept
 
 } // namespace csdb
 
+namespace std {
+template<>
+struct hash<::csdb::Address>
+{
+  size_t operator()(const ::csdb::Address &value) const noexcept;
+};
+} // namespace std
+
 #endif // _CREDITS_CSDB_ADDRESS_H_INCLUDED_
@@ -68,6 +68,7 @@ namespace csdb {
 namespace priv {
 class obstream;
 class ibstream;
+class unchecked_ibstream;
 } // namespace priv
 
 #pragma pack(push, 1)
@@ -176,6 +177,25 @@ public:
 public:
   void put(priv::obstream&) const;
   bool get(priv::ibstream&);
+  void get(priv::unchecked_ibstream&);
+  size_t serialized_size() const noexcept;
+
+  /**
+   * @brief Компактное представление, используемое форматами пула начиная с
+   *        \ref Pool::DictionaryFormat.
+   *
+   * Записывается целое число integral * 2 + (fraction != 0). Если дробная часть не нулевая,
+   * за ним следует ещё одно число m * 18 + z, где z - количество нулей в конце дробной части
+   * (из 18 десятичных знаков), а m - дробная часть без этих нулей. Целые суммы и суммы
+   * с небольшим количеством знаков после запятой занимают 1-3 байта.
+   */
+  void put_compact(priv::obstream&) const;
+  bool get_compact(priv::ibstream&);
+  void get_compact(priv::unchecked_ibstream&);
+  size_t compact_serialized_size() const noexcept;
+
+private:
+  struct serialization_schema;
 
 private:
   int32_t integral_ = 0;
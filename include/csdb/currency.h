@@ -10,12 +10,14 @@
 #include "csdb/internal/shared_data.h"
 #include <string>
 #include <vector>
+#include <functional>
 
 namespace csdb {
 
 namespace priv {
 class obstream;
 class ibstream;
+class unchecked_ibstream;
 } // namespace priv
 
 class Currency
@@ -34,12 +36,24 @@ public:
 private:
   void put(::csdb::priv::obstream&) const;
   bool get(::csdb::priv::ibstream&);
+  void get(::csdb::priv::unchecked_ibstream&);
+  size_t serialized_size() const noexcept;
   friend class ::csdb::priv::obstream;
   friend class ::csdb::priv::ibstream;
+  friend class ::csdb::priv::unchecked_ibstream;
+  friend struct ::std::hash<Currency>;
 };
 
 typedef std::vector<Currency> CurrencyList;
 
 } // namespace csdb
 
+namespace std {
+template<>
+struct hash<::csdb::Currency>
+{
+  size_t operator()(const ::csdb::Currency &value) const noexcept;
+};
+} // namespace std
+
 #endif // _CREDITS_CSDB_CURRENCY_H_INCLUDED_
@@ -8,6 +8,7 @@
 #define _CREDITS_CSDB_DATABASE_H_INCLUDED_
 
 #include <memory>
+#include <mutex>
 #include <utility>
 #include <vector>
 #include <string>
@@ -66,13 +67,23 @@ public:
   using IteratorPtr = std::shared_ptr<Iterator>;
   virtual IteratorPtr new_iterator() = 0;
 
+  /**
+   * @brief Итератор для однократного последовательного просмотра большого объёма данных.
+   *
+   * Данные, прочитанные через такой итератор, не должны вытеснять из кеша базы данные,
+   * используемые при обычной работе. Реализация по умолчанию возвращает \ref new_iterator.
+   */
+  virtual IteratorPtr new_scan_iterator();
+
 public:
-  Error last_error() const { return last_error_; }
+  /// Последняя ошибка. Операции чтения можно вызывать из нескольких потоков одновременно.
+  Error last_error() const;
   std::string last_error_message() const;
 protected:
   void set_last_error(Error error = NoError, const std::string& message = std::string());
   void set_last_error(Error error, const char* message, ...);
 private:
+  mutable std::mutex error_mutex_;
   Error last_error_;
   std::string last_error_message_;
 };
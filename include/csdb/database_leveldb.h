@@ -35,6 +35,7 @@ private:
   bool remove(const byte_array &key) override final;
   bool write_batch(const ItemList &items) override final;
   IteratorPtr new_iterator() override final;
+  IteratorPtr new_scan_iterator() override final;
 
 private:
   class Iterator;
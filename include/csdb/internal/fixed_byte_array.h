@@ -0,0 +1,125 @@
+/**
+  * @file fixed_byte_array.h
+  *
+  * Массив байт переменной длины с ограниченной сверху ёмкостью, хранящий данные внутри
+  * объекта (без выделения динамической памяти). Предназначен для ключей и хешей,
+  * размер которых известен заранее.
+  */
+
+#pragma once
+#ifndef _CREDITS_CSDB_INTERNAL_FIXED_BYTE_ARRAY_H_INCLUDED_
+#define _CREDITS_CSDB_INTERNAL_FIXED_BYTE_ARRAY_H_INCLUDED_
+
+#include <cstddef>
+#include <cstring>
+#include <cinttypes>
+
+#include "csdb/internal/types.h"
+
+namespace csdb {
+namespace internal {
+
+template<size_t Capacity>
+class fixed_byte_array
+{
+  static_assert((0 < Capacity) && (Capacity <= UINT8_MAX),
+                "fixed_byte_array capacity must fit into one byte.");
+
+public:
+  using value_type = uint8_t;
+  using iterator = uint8_t*;
+  using const_iterator = const uint8_t*;
+
+  static constexpr size_t capacity() noexcept { return Capacity; }
+
+public:
+  inline fixed_byte_array() noexcept : size_(0), data_{} {}
+
+  /**
+   * @brief Замещает содержимое массива.
+   * @return true, если данные помещаются в массив. В противном случае содержимое массива
+   *         не изменяется и возвращается false.
+   */
+  inline bool assign(const void *data, size_t size) noexcept
+  {
+    if (Capacity < size) {
+      return false;
+    }
+    if (0 < size) {
+      std::memcpy(data_, data, size);
+    }
+    std::memset(data_ + size, 0, Capacity - size);
+    size_ = static_cast<uint8_t>(size);
+    return true;
+  }
+
+  inline bool assign(const byte_array &data) noexcept
+  {
+    return assign(data.data(), data.size());
+  }
+
+  inline void clear() noexcept
+  {
+    std::memset(data_, 0, Capacity);
+    size_ = 0;
+  }
+
+  inline size_t size() const noexcept { return size_; }
+  inline bool empty() const noexcept { return (0 == size_); }
+
+  inline uint8_t* data() noexcept { return data_; }
+  inline const uint8_t* data() const noexcept { return data_; }
+
+  inline iterator begin() noexcept { return data_; }
+  inline iterator end() noexcept { return data_ + size_; }
+  inline const_iterator begin() const noexcept { return data_; }
+  inline const_iterator end() const noexcept { return data_ + size_; }
+
+  inline byte_array to_byte_array() const
+  {
+    return byte_array(begin(), end());
+  }
+
+  inline bool operator ==(const fixed_byte_array &other) const noexcept
+  {
+    // Неиспользуемый хвост всегда заполнен нулями, поэтому сравнивать можно весь буфер.
+    return (size_ == other.size_) && (0 == std::memcmp(data_, other.data_, Capacity));
+  }
+
+  inline bool operator !=(const fixed_byte_array &other) const noexcept
+  {
+    return !operator ==(other);
+  }
+
+  /**
+   * @brief Лексикографическое сравнение (как у \ref byte_array).
+   */
+  inline bool operator <(const fixed_byte_array &other) const noexcept
+  {
+    const size_t common = (size_ < other.size_) ? size_ : other.size_;
+    const int res = (0 < common) ? std::memcmp(data_, other.data_, common) : 0;
+    return (0 != res) ? (0 > res) : (size_ < other.size_);
+  }
+
+  /**
+   * @brief Значение хеш-функции для использования в неупорядоченных контейнерах.
+   *
+   * Хранимые данные (публичные ключи, криптографические хеши) уже равномерно распределены,
+   * поэтому в качестве значения используется первое машинное слово данных.
+   */
+  inline size_t hash() const noexcept
+  {
+    size_t res = 0;
+    std::memcpy(&res, data_, (sizeof(size_t) < Capacity) ? sizeof(size_t) : Capacity);
+    return res ^ size_;
+  }
+
+private:
+  uint8_t size_;
+  uint8_t data_[Capacity];
+};
+
+} // namespace internal
+} // namespace csdb
+
+#endif // _CREDITS_CSDB_INTERNAL_FIXED_BYTE_ARRAY_H_INCLUDED_
@@ -0,0 +1,259 @@
+/**
+  * @file small_flat_map.h
+  *
+  * Ассоциативный контейнер на основе упорядоченного по ключу массива с встроенной ёмкостью.
+  * Первые N элементов хранятся внутри объекта (без выделения динамической памяти), при
+  * превышении ёмкости элементы переносятся в динамический буфер.
+  *
+  * Порядок обхода совпадает с порядком обхода ::std::map с тем же ключом.
+  */
+
+#pragma once
+#ifndef _CREDITS_CSDB_INTERNAL_SMALL_FLAT_MAP_H_INCLUDED_
+#define _CREDITS_CSDB_INTERNAL_SMALL_FLAT_MAP_H_INCLUDED_
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+
+namespace csdb {
+namespace internal {
+
+template<typename Key, typename T, size_t N>
+class small_flat_map
+{
+  static_assert(0 < N, "small_flat_map inline capacity must be positive.");
+
+public:
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = ::std::pair<Key, T>;
+  using iterator = value_type*;
+  using const_iterator = const value_type*;
+
+public:
+  inline small_flat_map() noexcept :
+    data_(inline_data()), size_(0), capacity_(N)
+  {}
+
+  inline small_flat_map(const small_flat_map &other) :
+    small_flat_map()
+  {
+    append_copy(other);
+  }
+
+  inline small_flat_map(small_flat_map &&other) noexcept :
+    small_flat_map()
+  {
+    steal(other);
+  }
+
+  inline ~small_flat_map()
+  {
+    clear();
+    release();
+  }
+
+  inline small_flat_map& operator =(const small_flat_map &other)
+  {
+    if (&other != this) {
+      clear();
+      append_copy(other);
+    }
+    return *this;
+  }
+
+  inline small_flat_map& operator =(small_flat_map &&other) noexcept
+  {
+    if (&other != this) {
+      clear();
+      release();
+      steal(other);
+    }
+    return *this;
+  }
+
+public:
+  inline size_t size() const noexcept { return size_; }
+  inline bool empty() const noexcept { return (0 == size_); }
+  inline size_t capacity() const noexcept { return capacity_; }
+
+  inline iterator begin() noexcept { return data_; }
+  inline iterator end() noexcept { return data_ + size_; }
+  inline const_iterator begin() const noexcept { return data_; }
+  inline const_iterator end() const noexcept { return data_ + size_; }
+
+  inline iterator find(const Key &key) noexcept
+  {
+    iterator it = lower_bound(key);
+    return ((end() != it) && (!(key < it->first))) ? it : end();
+  }
+
+  inline const_iterator find(const Key &key) const noexcept
+  {
+    return const_cast<small_flat_map*>(this)->find(key);
+  }
+
+  inline size_t count(const Key &key) const noexcept
+  {
+    return (end() != find(key)) ? 1 : 0;
+  }
+
+  /**
+   * @brief Добавляет элемент, если элемента с таким ключом ещё нет (аналог ::std::map::emplace).
+   * @return true, если элемент добавлен.
+   */
+  bool emplace(const Key &key, const T &value)
+  {
+    iterator it = lower_bound(key);
+    if ((end() != it) && (!(key < it->first))) {
+      return false;
+    }
+    insert_at(static_cast<size_t>(it - begin()), key, value);
+    return true;
+  }
+
+  /**
+   * @brief Добавляет элемент или замещает значение элемента с таким же ключом.
+   */
+  void insert_or_assign(const Key &key, const T &value)
+  {
+    iterator it = lower_bound(key);
+    if ((end() != it) && (!(key < it->first))) {
+      it->second = value;
+      return;
+    }
+    insert_at(static_cast<size_t>(it - begin()), key, value);
+  }
+
+  /**
+   * @brief Добавляет элемент в конец, не проверяя порядок ключей.
+   *
+   * Пока ключи добавляются по возрастанию, порядок контейнера не нарушается. Иначе порядок
+   * необходимо восстановить вызовом \ref sort_unique до обращения к элементам.
+   */
+  void push_back_unordered(const Key &key, const T &value)
+  {
+    if (size_ == capacity_) {
+      reserve(capacity_ * 2);
+    }
+    new (data_ + size_) value_type(key, value);
+    ++size_;
+  }
+
+  /**
+   * @brief Упорядочивает элементы по ключу. Из элементов с одинаковым ключом остаётся
+   *        добавленный первым, как при последовательных вызовах \ref emplace.
+   */
+  void sort_unique()
+  {
+    ::std::stable_sort(begin(), end(), [](const value_type &a, const value_type &b) {
+      return a.first < b.first;
+    });
+    iterator last = ::std::unique(begin(), end(), [](const value_type &a, const value_type &b) {
+      return !(a.first < b.first);
+    });
+    for (iterator it = last; it != end(); ++it) {
+      it->~value_type();
+    }
+    size_ = static_cast<size_t>(last - begin());
+  }
+
+  void reserve(size_t new_capacity)
+  {
+    if (new_capacity <= capacity_) {
+      return;
+    }
+    value_type *buf = static_cast<value_type*>(::operator new(new_capacity * sizeof(value_type)));
+    for (size_t i = 0; i < size_; ++i) {
+      new (buf + i) value_type(::std::move(data_[i]));
+      data_[i].~value_type();
+    }
+    release();
+    data_ = buf;
+    capacity_ = new_capacity;
+  }
+
+  inline void clear() noexcept
+  {
+    for (size_t i = 0; i < size_; ++i) {
+      data_[i].~value_type();
+    }
+    size_ = 0;
+  }
+
+private:
+  inline value_type* inline_data() noexcept
+  {
+    return reinterpret_cast<value_type*>(&inline_);
+  }
+
+  inline bool is_inline() const noexcept
+  {
+    return data_ == reinterpret_cast<const value_type*>(&inline_);
+  }
+
+  inline iterator lower_bound(const Key &key) noexcept
+  {
+    return ::std::lower_bound(begin(), end(), key, [](const value_type &item, const Key &k) {
+      return item.first < k;
+    });
+  }
+
+  void insert_at(size_t pos, const Key &key, const T &value)
+  {
+    push_back_unordered(key, value);
+    ::std::rotate(data_ + pos, data_ + size_ - 1, data_ + size_);
+  }
+
+  void append_copy(const small_flat_map &other)
+  {
+    reserve(other.size_);
+    for (size_t i = 0; i < other.size_; ++i) {
+      new (data_ + i) value_type(other.data_[i]);
+      ++size_;
+    }
+  }
+
+  /// Освобождает динамический буфер. Контейнер должен быть пуст.
+  inline void release() noexcept
+  {
+    if (!is_inline()) {
+      ::operator delete(data_);
+      data_ = inline_data();
+      capacity_ = N;
+    }
+  }
+
+  /// Забирает содержимое other. Контейнер должен быть пуст и использовать встроенный буфер.
+  inline void steal(small_flat_map &other) noexcept
+  {
+    if (other.is_inline()) {
+      for (size_t i = 0; i < other.size_; ++i) {
+        new (data_ + i) value_type(::std::move(other.data_[i]));
+        ++size_;
+      }
+      other.clear();
+    } else {
+      data_ = other.data_;
+      size_ = other.size_;
+      capacity_ = other.capacity_;
+      other.data_ = other.inline_data();
+      other.size_ = 0;
+      other.capacity_ = N;
+    }
+  }
+
+private:
+  value_type *data_;
+  size_t size_;
+  size_t capacity_;
+  typename ::std::aligned_storage<sizeof(value_type) * N, alignof(value_type)>::type inline_;
+};
+
+} // namespace internal
+} // namespace csdb
+
+#endif // _CREDITS_CSDB_INTERNAL_SMALL_FLAT_MAP_H_INCLUDED_
@@ -11,9 +11,11 @@
 #include <vector>
 #include <array>
 #include <string>
+#include <functional>
 
 #include "csdb/transaction.h"
 #include "csdb/storage.h"
+#include "csdb/pool_validator.h"
 #include "csdb/user_field.h"
 #include "csdb/internal/shared_data.h"
 #include "csdb/internal/types.h"
@@ -26,6 +28,7 @@ class TransactionID;
 namespace priv {
 class obstream;
 class ibstream;
+class unchecked_ibstream;
 } // namespace priv
 
 class PoolHash
@@ -47,6 +50,7 @@ public:
   static PoolHash from_string(const ::std::string& str);
 
   ::csdb::internal::byte_array to_binary() const noexcept;
+
   static PoolHash from_binary(const ::csdb::internal::byte_array& data);
 
   bool operator ==(const PoolHash &other) const noexcept;
@@ -65,9 +69,13 @@ public:
 private:
   void put(::csdb::priv::obstream&) const;
   bool get(::csdb::priv::ibstream&);
+  void get(::csdb::priv::unchecked_ibstream&);
+  size_t serialized_size() const noexcept;
   friend class ::csdb::priv::obstream;
   friend class ::csdb::priv::ibstream;
+  friend class ::csdb::priv::unchecked_ibstream;
   friend class Storage;
+  friend struct ::std::hash<PoolHash>;
 };
 
 class Pool
@@ -76,16 +84,119 @@ class Pool
 public:
   typedef uint64_t sequence_t;
 
+  /**
+   * @brief Формат бинарного представления пула.
+   *
+   * Формат выбирается при формировании пула (\ref set_format) и влияет на бинарное
+   * представление и, соответственно, на хеш пула. При чтении (\ref from_binary, \ref load)
+   * формат определяется автоматически.
+   */
+  enum Format : uint8_t {
+    /// Исходный формат: каждая транзакция содержит адреса и валюту целиком.
+    LegacyFormat = 1,
+    /// Адреса и валюты записываются один раз в таблицах пула, транзакции ссылаются на них
+    /// по номеру в таблице.
+    DictionaryFormat = 2,
+    /// Таблицы адресов и валют, как в \ref DictionaryFormat, но поля транзакций записываются
+    /// столбцами: все отправители, все получатели и т.д. Отдельные столбцы можно читать
+    /// через \ref PoolColumns, не декодируя транзакции целиком.
+    ColumnarFormat = 3,
+    /// Транзакции записываются, как в \ref LegacyFormat, после заголовка, содержащего корень
+    /// дерева Меркла по транзакциям (\ref merkle_root). Хеш пула вычисляется только по заголовку,
+    /// поэтому включение транзакции в пул можно проверить по заголовку и доказательству
+    /// (\ref inclusion_proof), не имея всего пула.
+    MerkleFormat = 4,
+  };
+
+  /**
+   * @brief Доказательство включения транзакции в пул формата \ref MerkleFormat.
+   *
+   * Размер доказательства пропорционален логарифму количества транзакций в пуле.
+   */
+  struct InclusionProof
+  {
+    /// Заголовок пула, по которому вычисляется его хеш.
+    ::csdb::internal::byte_array header;
+    /// Бинарное представление транзакции.
+    ::csdb::internal::byte_array transaction;
+    /// Хеши соседних узлов дерева на пути от транзакции к корню.
+    ::std::vector<::csdb::internal::byte_array> path;
+  };
+
 public:
   Pool(PoolHash previous_hash, sequence_t sequence, Storage storage = Storage());
 
   static Pool from_binary(const ::csdb::internal::byte_array& data);
+
+  /**
+   * @brief Пул из бинарного представления с заранее известным хешем.
+   * @param[in] data Бинарное представление пула.
+   * @param[in] hash Хеш пула, например, ключ записи в хранилище.
+   * @return Пул в режиме read-only, как при вызове \ref from_binary, но хеш не вычисляется, а
+   *         берётся из hash. Соответствие хеша данным можно проверить позже (\ref verify_hash).
+   */
+  static Pool from_binary(::csdb::internal::byte_array data, const PoolHash& hash);
+
   static Pool meta_from_binary(const ::csdb::internal::byte_array& data, size_t& cnt);
   static Pool load(PoolHash hash, Storage storage = Storage());
 
+  /**
+   * @brief Пул из бинарного представления для дальнейшего изменения.
+   * @param[in] data Бинарное представление пула.
+   * @param[in] size Размер бинарного представления.
+   * @return Пул не в режиме read-only: его можно изменять (\ref set_sequence,
+   *         \ref add_transaction и т.п.), а перед сохранением необходимо сформировать
+   *         (\ref compose). Данные не сохраняются, и хеш не вычисляется.
+   *
+   * Для приёма готового пула предназначена перегрузка from_byte_stream(byte_array&&).
+   */
   static Pool from_byte_stream(const char* data, size_t size);
+
+  /**
+   * @brief Приём готового пула без копирования данных.
+   * @param[in] data Бинарное представление пула.
+   * @return Пул в режиме read-only, как при вызове \ref from_binary. Если данные разобраны
+   *         успешно, массив становится бинарным представлением пула (\ref to_binary), а data
+   *         после вызова пуст. В противном случае возвращается невалидный пул, а data не изменяется.
+   *
+   * Хеш вычисляется по принятым данным один раз. Формировать такой пул (\ref compose) не
+   * нужно, и при сохранении (\ref save) в хранилище записываются те же данные.
+   */
+  static Pool from_byte_stream(::csdb::internal::byte_array&& data);
+
   char* to_byte_stream(size_t& size);
 
+  /// Участок памяти вызывающей стороны для записи бинарного представления.
+  struct ByteStreamBuffer
+  {
+    void* data;
+    size_t size;
+  };
+
+  /**
+   * @brief Размер бинарного представления, которое запишет \ref to_byte_stream.
+   *
+   * Для пула, не находящегося в режиме read-only, бинарное представление строится при первом
+   * вызове любой из функций to_byte_stream или byte_stream_size и затем используется повторно.
+   */
+  size_t byte_stream_size();
+
+  /**
+   * @brief Записывает бинарное представление пула в буфер вызывающей стороны.
+   * @return Количество записанных байт или 0, если буфер меньше \ref byte_stream_size.
+   */
+  size_t to_byte_stream(void* buffer, size_t size);
+
+  /**
+   * @brief Записывает бинарное представление пула по частям в несколько буферов.
+   * @param[in] buffers Буферы (например, пакеты для отправки), заполняемые по порядку: следующий
+   *                    буфер используется только после того, как полностью заполнен предыдущий.
+   * @param[in] count   Количество буферов.
+   * @return Количество записанных байт или 0, если суммарный размер буферов меньше
+   *         \ref byte_stream_size. Последний использованный буфер может быть заполнен частично.
+   */
+  size_t to_byte_stream(const ByteStreamBuffer* buffers, size_t count);
+
   bool clear()  noexcept;
 
   bool is_valid() const noexcept;
@@ -98,6 +209,24 @@ public:
   void set_previous_hash(PoolHash previous_hash) noexcept;
   void set_sequence(sequence_t sequence) noexcept;
   void set_storage(Storage storage) noexcept;
+
+  /// Формат бинарного представления пула (для прочитанных пулов - формат исходных данных).
+  Format format() const noexcept;
+
+  /**
+   * @brief Задаёт формат, в котором будет сформировано бинарное представление пула.
+   *
+   * Формат можно изменить только для пула, не находящегося в режиме read-only. По умолчанию
+   * используется \ref LegacyFormat.
+   */
+  void set_format(Format format) noexcept;
+
+  /**
+   * @brief Изменяемый список транзакций пула.
+   *
+   * Индекс адресов пула (см. \ref find_by_address) после вызова перестаёт использоваться,
+   * и поиск по адресу выполняется перебором транзакций.
+   */
   std::vector<csdb::Transaction>& transactions();
   /**
    * @brief Добавляет транзакцию в пул.
@@ -107,16 +236,51 @@ public:
    *
    * Добаление возможно только во вновь создаваемый пул (т.е. если \ref is_read_only возвращает false).
    *
-   * Перед добавлением транзакция проходит проверку на валидность по базе данных, указанной для
-   * пула, и по ранее добавленным транзакциям. Если база данных не задана, или она была закрыта,
-   * проверка считается неуспешной.
+   * При добавлении проверяется только валидность самой транзакции. Балансы отправителей и
+   * другие ограничения проверяются для всего пула при формировании (\ref compose с
+   * \ref PoolValidator) или вызовом \ref validate.
+   */
+  bool add_transaction(const Transaction &transaction
+#ifdef CSDB_UNIT_TEST
+                       , bool skip_check
+#endif
+                       );
+
+  /**
+   * @brief Добавляет транзакцию в пул без копирования.
+   * @overload
+   *
+   * Если переданный объект транзакции является единственным владельцем своих данных, пул
+   * забирает эти данные себе без копирования. В противном случае транзакция копируется, как
+   * и при добавлении по константной ссылке.
    */
-  bool add_transaction(Transaction transaction
+  bool add_transaction(Transaction &&transaction
 #ifdef CSDB_UNIT_TEST
                        , bool skip_check
 #endif
                        );
 
+  /**
+   * @brief Добавляет в пул набор транзакций.
+   * @param[in] transactions Транзакции для добавления. После вызова массив пуст.
+   * @return Количество добавленных транзакций. Транзакции, не прошедшие проверку, пропускаются.
+   *
+   * Эквивалентно последовательному вызову \ref add_transaction(Transaction&&) для каждой
+   * транзакции, но место под транзакции в пуле резервируется заранее.
+   */
+  size_t add_transactions(std::vector<Transaction> &&transactions
+#ifdef CSDB_UNIT_TEST
+                          , bool skip_check
+#endif
+                          );
+
+  /**
+   * @brief Резервирует в пуле место под указанное общее количество транзакций.
+   *
+   * Для пулов в режиме read-only функция ничего не делает.
+   */
+  void reserve(size_t count);
+
   /**
    * @brief Закончить формирование пула.
    * @return true, если для пула успешно сформировано бинарное представление.
@@ -129,6 +293,46 @@ public:
    */
   bool compose();
 
+  /**
+   * @brief Закончить формирование пула, используя несколько потоков.
+   * @overload
+   * @param[in] threads Максимальное количество потоков; 0 - по числу ядер процессора.
+   *
+   * Транзакции делятся на непрерывные части, которые сериализуются параллельно и затем
+   * склеиваются по порядку, после чего идентификаторы транзакций также устанавливаются
+   * параллельно. Результат (бинарное представление и хеш) совпадает с результатом \ref compose().
+   *
+   * Параллельно сериализуются пулы в форматах \ref LegacyFormat и \ref MerkleFormat; для
+   * \ref MerkleFormat параллельно вычисляются и листья дерева. Хеш пула в остальных форматах
+   * вычисляется одним проходом по всему представлению. Для небольших пулов используется меньше
+   * потоков, вплоть до одного.
+   */
+  bool compose(size_t threads);
+
+  /**
+   * @brief Проверяет транзакции и формирует пул.
+   * @param[in]  validator Проверка транзакций (см. \ref validate).
+   * @param[out] verdicts  Если не nullptr, сюда записываются вердикты для всех транзакций.
+   * @param[in]  threads   Количество потоков для проверки и формирования; 0 - по числу ядер.
+   * @return true, если все транзакции прошли проверку и пул сформирован. Если хотя бы одна
+   *         транзакция не прошла проверку, пул не формируется. Для пула в режиме read-only
+   *         проверка не выполняется и возвращается true.
+   */
+  bool compose(PoolValidator& validator, ::std::vector<PoolValidator::Verdict>* verdicts = nullptr,
+               size_t threads = 0);
+
+  /**
+   * @brief Проверяет транзакции пула.
+   * @param[in] validator Проверка транзакций.
+   * @param[in] threads   Количество потоков; 0 - по числу ядер.
+   * @return Вердикт для каждой транзакции в порядке транзакций пула.
+   *
+   * Вызывает \ref PoolValidator::prepare, после чего транзакции делятся на непрерывные части,
+   * которые проверяются в отдельных потоках (\ref PoolValidator::validate). Для небольших пулов
+   * используется меньше потоков, вплоть до одного.
+   */
+  ::std::vector<PoolValidator::Verdict> validate(PoolValidator& validator, size_t threads = 0) const;
+
   /**
    * @brief Хеш пула
    * @return Хеш пула, если пул находится в режиме read-only, и пустой хеш в противном
@@ -136,6 +340,15 @@ public:
    */
   PoolHash hash() const noexcept;
 
+  /**
+   * @brief Проверяет, что \ref hash совпадает с хешем бинарного представления.
+   * @return false, если пул не в режиме read-only или хеши не совпадают.
+   *
+   * Имеет смысл для пулов, прочитанных с известным хешем (\ref from_binary(::csdb::internal::byte_array,
+   * const PoolHash&)); хеш остальных пулов вычисляется по их бинарному представлению.
+   */
+  bool verify_hash() const;
+
   /**
    * @brief Бинарное представление пула
    * @return Бинарное представление пула, если пул находится в режиме read-only, и пустой
@@ -191,6 +404,13 @@ public:
    */
   ::std::set<user_field_id_t> user_field_ids() const noexcept;
 
+  /**
+   * @brief Список идентификаторов дополнительных полей без выделения памяти
+   * @return  Диапазон идентификаторов дополнительных полей в порядке возрастания. Диапазон
+   *          действителен, пока объект существует и его дополнительные поля не изменяются.
+   */
+  UserFieldIdRange user_field_id_range() const noexcept;
+
   /// \deprecated Функция будет исключена в последующих версиях.
   Transaction transaction(size_t index ) const;
 
@@ -218,7 +438,61 @@ public:
   */
   Transaction get_last_by_target(Address target) const noexcept;
 
+  /**
+   * @brief Номера транзакций, в которых адрес является отправителем или получателем.
+   * @return Номера транзакций в порядке возрастания.
+   *
+   * Для пула, транзакции которого добавлялись через \ref add_transaction, поиск по адресу
+   * (эта функция, \ref get_last_by_source, \ref get_last_by_target и \ref debit) выполняется
+   * по индексу, который дополняется при добавлении каждой транзакции и сохраняется после
+   * \ref compose. Для пулов, прочитанных из бинарного представления, и после вызова
+   * \ref transactions транзакции перебираются.
+   */
+  std::vector<size_t> find_by_address(const Address& address) const;
+
+  /**
+   * @brief Сумма транзакций пула с отправителем source в валюте currency.
+   *
+   * Позволяет при формировании пула проверить, не превышает ли новая транзакция вместе с
+   * уже добавленными баланс отправителя.
+   */
+  Amount debit(const Address& source, const Currency& currency) const;
+
+  /**
+   * @brief Корень дерева Меркла по транзакциям пула.
+   * @return Корень дерева, если пул в формате \ref MerkleFormat находится в режиме read-only,
+   *         и пустой массив в противном случае.
+   */
+  ::csdb::internal::byte_array merkle_root() const;
+
+  /**
+   * @brief Доказательство включения транзакции в пул.
+   * @param[in] id Идентификатор транзакции этого пула.
+   * @return Доказательство для \ref verify_inclusion_proof. Если пул не в формате
+   *         \ref MerkleFormat, не находится в режиме read-only или не содержит транзакции,
+   *         возвращается доказательство с пустым заголовком.
+   */
+  InclusionProof inclusion_proof(TransactionID id) const;
+
+  /**
+   * @brief Проверяет доказательство включения транзакции в пул.
+   * @param[in] id    Идентификатор транзакции, включая хеш пула.
+   * @param[in] proof Доказательство, полученное от \ref inclusion_proof.
+   * @return Транзакция из доказательства с идентификатором id, если хеш заголовка совпадает
+   *         с хешем пула из id, а путь ведёт от транзакции к корню из заголовка. В противном
+   *         случае возвращается невалидный объект (\ref ::csdb::Transaction::is_valid() == false).
+   *
+   * Для проверки не нужны ни сам пул, ни хранилище.
+   */
+  static Transaction verify_inclusion_proof(TransactionID id, const InclusionProof& proof);
+
+private:
+  /// Бинарное представление для to_byte_stream. Пул копируется, только если его нужно сериализовать.
+  const ::csdb::internal::byte_array& byte_stream();
+
   friend class Storage;
+  friend class PoolBuilder;
+  friend class PoolColumns;
 };
 
 inline bool PoolHash::operator !=(const PoolHash &other) const noexcept
@@ -228,4 +502,12 @@ inline bool PoolHash::operator !=(const PoolHash &other) const noexcept
 
 } // namespace csdb
 
+namespace std {
+template<>
+struct hash<::csdb::PoolHash>
+{
+  size_t operator()(const ::csdb::PoolHash &value) const noexcept;
+};
+} // namespace std
+
 #endif // _CREDITS_CSDB_POOL_H_INCLUDED_
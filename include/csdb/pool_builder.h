@@ -0,0 +1,92 @@
+/**
+  * @file pool_builder.h
+  */
+
+#pragma once
+#ifndef _CREDITS_CSDB_POOL_BUILDER_H_INCLUDED_
+#define _CREDITS_CSDB_POOL_BUILDER_H_INCLUDED_
+
+#include <cinttypes>
+
+#include "csdb/pool.h"
+#include "csdb/storage.h"
+#include "csdb/transaction.h"
+#include "csdb/user_field.h"
+#include "csdb/internal/shared_data.h"
+
+namespace csdb {
+
+/**
+ * @brief Потоковое формирование пула.
+ *
+ * В отличие от \ref Pool::compose, который сериализует и хеширует весь пул за один раз,
+ * построитель сериализует каждую транзакцию в момент её добавления и сразу же передаёт
+ * полученные байты в инкрементальный вычислитель хеша. Метод \ref compose дописывает только
+ * дополнительные поля пула и завершает вычисление хеша.
+ *
+ * Бинарное представление и хеш сформированного пула в точности совпадают с результатом
+ * \ref Pool::compose для того же набора данных.
+ *
+ * Количество транзакций записывается в бинарном представлении перед транзакциями, поэтому
+ * его нужно указать при создании построителя. Если к моменту вызова \ref compose
+ * количество добавленных транзакций отличается от заявленного, заголовок пула формируется
+ * заново и хеш вычисляется по всему представлению (как в \ref Pool::compose).
+ */
+class PoolBuilder
+{
+  SHARED_DATA_CLASS_DECLARE(PoolBuilder)
+
+public:
+  PoolBuilder(PoolHash previous_hash, Pool::sequence_t sequence, size_t expected_transactions_count,
+              Storage storage = Storage());
+
+  /// false для построителя, созданного конструктором по умолчанию или уже сформировавшего пул.
+  bool is_valid() const noexcept;
+
+  /// Количество добавленных транзакций.
+  size_t transactions_count() const noexcept;
+
+  /// Количество транзакций, указанное при создании построителя.
+  size_t expected_transactions_count() const noexcept;
+
+  /**
+   * @brief Добавляет транзакцию в пул и сериализует её.
+   * @return true, если транзакция была добавлена (см. \ref Pool::add_transaction).
+   */
+  bool add_transaction(const Transaction &transaction
+#ifdef CSDB_UNIT_TEST
+                       , bool skip_check
+#endif
+                       );
+
+  /**
+   * @brief Добавляет транзакцию без копирования.
+   * @overload
+   */
+  bool add_transaction(Transaction &&transaction
+#ifdef CSDB_UNIT_TEST
+                       , bool skip_check
+#endif
+                       );
+
+  /**
+   * @brief Добавляет дополнительное поле к пулу (см. \ref Pool::add_user_field).
+   *
+   * Дополнительные поля пула записываются после транзакций, поэтому их можно добавлять
+   * в любой момент до вызова \ref compose.
+   */
+  bool add_user_field(user_field_id_t id, UserField field) noexcept;
+
+  /**
+   * @brief Заканчивает формирование пула.
+   * @return Сформированный пул в режиме read-only. Для невалидного построителя возвращается
+   *         невалидный пул.
+   *
+   * После вызова построитель становится невалидным (\ref is_valid возвращает false).
+   */
+  Pool compose();
+};
+
+} // namespace csdb
+
+#endif // _CREDITS_CSDB_POOL_BUILDER_H_INCLUDED_
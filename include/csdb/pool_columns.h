@@ -0,0 +1,122 @@
+/**
+  * @file pool_columns.h
+  */
+
+#pragma once
+#ifndef _CREDITS_CSDB_POOL_COLUMNS_H_INCLUDED_
+#define _CREDITS_CSDB_POOL_COLUMNS_H_INCLUDED_
+
+#include <cinttypes>
+#include <vector>
+
+#include "csdb/address.h"
+#include "csdb/amount.h"
+#include "csdb/currency.h"
+#include "csdb/pool.h"
+#include "csdb/storage.h"
+#include "csdb/internal/shared_data.h"
+#include "csdb/internal/types.h"
+
+namespace csdb {
+
+/**
+ * @brief Просмотр полей транзакций пула по столбцам.
+ *
+ * Отправители, получатели и валюты транзакций представлены номерами в таблицах адресов
+ * и валют пула. Поиск транзакций по адресу сводится к поиску номера адреса в таблице
+ * (\ref find_address) и сравнению номеров в столбце, без создания объектов транзакций.
+ *
+ * Для пулов в формате \ref Pool::ColumnarFormat столбцы читаются прямо из бинарного
+ * представления: при создании декодируются только таблицы, суммы декодируются при вызове
+ * \ref amounts, остатки и дополнительные поля - только при вызове \ref pool. Для пулов в других
+ * форматах пул декодируется целиком, а столбцы строятся по его транзакциям.
+ */
+class PoolColumns
+{
+  SHARED_DATA_CLASS_DECLARE(PoolColumns)
+
+public:
+  /// Значение, возвращаемое функциями поиска, если ничего не найдено.
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  /// Столбцы пула. Для невалидного пула создаётся невалидный объект.
+  explicit PoolColumns(const Pool& pool);
+
+  static PoolColumns from_binary(const ::csdb::internal::byte_array& data);
+
+  /**
+   * @brief Столбцы пула с заранее известным хешем.
+   *
+   * Как \ref from_binary, но пул (в том числе возвращаемый \ref pool) читается
+   * \ref Pool::from_binary(::csdb::internal::byte_array, const PoolHash&), без вычисления хеша.
+   */
+  static PoolColumns from_binary(::csdb::internal::byte_array data, const PoolHash& hash);
+  static PoolColumns load(PoolHash hash, Storage storage = Storage());
+
+  bool is_valid() const noexcept;
+
+  /// Формат бинарного представления, из которого получены столбцы.
+  Pool::Format format() const noexcept;
+  PoolHash previous_hash() const noexcept;
+  Pool::sequence_t sequence() const noexcept;
+  size_t transactions_count() const noexcept;
+
+  /// Количество различных адресов (отправителей и получателей) в пуле.
+  size_t addresses_count() const noexcept;
+  Address address(size_t index) const noexcept;
+
+  /// Номер адреса в таблице адресов пула или \ref npos, если адреса в пуле нет.
+  size_t find_address(const Address& address) const noexcept;
+
+  /// Количество различных валют в пуле.
+  size_t currencies_count() const noexcept;
+  Currency currency(size_t index) const noexcept;
+
+  /// Номер отправителя транзакции с индексом transaction в таблице адресов.
+  size_t source_index(size_t transaction) const noexcept;
+
+  /// Номер получателя транзакции с индексом transaction в таблице адресов.
+  size_t target_index(size_t transaction) const noexcept;
+
+  /// Номер валюты транзакции с индексом transaction в таблице валют.
+  size_t currency_index(size_t transaction) const noexcept;
+
+  /**
+   * @brief Индексы транзакций, отправителем которых является адрес с номером address.
+   * @return Индексы в порядке возрастания.
+   */
+  std::vector<size_t> find_by_source(size_t address) const;
+
+  /**
+   * @brief Индексы транзакций, получателем которых является адрес с номером address.
+   * @return Индексы в порядке возрастания.
+   */
+  std::vector<size_t> find_by_target(size_t address) const;
+
+  /**
+   * @brief Индексы транзакций, в которых адрес с номером address является отправителем или
+   *        получателем.
+   * @return Индексы в порядке возрастания.
+   */
+  std::vector<size_t> find_by_address(size_t address) const;
+
+  /// Индекс последней транзакции с отправителем address или \ref npos.
+  size_t find_last_by_source(size_t address) const noexcept;
+
+  /// Индекс последней транзакции с получателем address или \ref npos.
+  size_t find_last_by_target(size_t address) const noexcept;
+
+  /// Суммы всех транзакций пула в порядке транзакций.
+  std::vector<Amount> amounts() const;
+
+  /**
+   * @brief Пул целиком.
+   *
+   * Для пулов в формате \ref Pool::ColumnarFormat пул декодируется при каждом вызове.
+   */
+  Pool pool() const;
+};
+
+} // namespace csdb
+
+#endif // _CREDITS_CSDB_POOL_COLUMNS_H_INCLUDED_
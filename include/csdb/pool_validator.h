@@ -0,0 +1,134 @@
+/**
+  * @file pool_validator.h
+  */
+
+#pragma once
+#ifndef _CREDITS_CSDB_POOL_VALIDATOR_H_INCLUDED_
+#define _CREDITS_CSDB_POOL_VALIDATOR_H_INCLUDED_
+
+#include <cinttypes>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "csdb/address.h"
+#include "csdb/amount.h"
+#include "csdb/currency.h"
+#include "csdb/storage.h"
+#include "csdb/transaction.h"
+#include "csdb/user_field.h"
+
+namespace csdb {
+
+class Pool;
+
+/**
+ * @brief Проверка транзакций пула перед формированием.
+ *
+ * Проверка выполняется в два этапа (см. \ref Pool::validate). Сначала из вызывающего потока
+ * вызывается \ref prepare, где проверка может собрать данные по всему пулу, используя до threads
+ * потоков. Затем для каждой
+ * транзакции вызывается \ref validate - одновременно из нескольких потоков, поэтому validate
+ * не должен изменять состояние проверки.
+ */
+class PoolValidator
+{
+public:
+  /// Результат проверки транзакции.
+  enum Verdict : uint8_t {
+    Valid = 0,
+    /// Сумма транзакции превышает баланс отправителя в хранилище.
+    InsufficientFunds,
+    /// Сумма транзакции не превышает баланс отправителя, но вместе с предыдущими транзакциями
+    /// того же отправителя в пуле превышает.
+    DoubleSpend,
+    /// Дополнительные поля транзакции не удовлетворяют ограничениям.
+    UserFieldViolation,
+    /// Транзакция отклонена по другой причине.
+    Rejected,
+  };
+
+  virtual ~PoolValidator();
+
+  /**
+   * @brief Подготовка к проверке транзакций пула. По умолчанию ничего не делает.
+   * @param[in] pool    Проверяемый пул.
+   * @param[in] threads Количество потоков, переданное в \ref Pool::validate.
+   */
+  virtual void prepare(const Pool& pool, size_t threads);
+
+  /**
+   * @brief Проверяет транзакцию пула.
+   * @param[in] transaction Транзакция.
+   * @param[in] index       Номер транзакции в пуле.
+   */
+  virtual Verdict validate(const Transaction& transaction, size_t index) const = 0;
+};
+
+/**
+ * @brief Проверка балансов отправителей.
+ *
+ * Баланс каждого отправителя в каждой валюте вычисляется так же, как в \ref Wallet, но
+ * для всех отправителей пула за один проход по хранилищу; пулы цепочки загружаются и
+ * учитываются параллельно. Транзакции одного отправителя учитываются в порядке пула:
+ * транзакция отклоняется, если вместе с предыдущими принятыми она превышает баланс. Разные
+ * отправители обрабатываются параллельно. Поступления в том же пуле не учитываются.
+ */
+class BalanceValidator : public PoolValidator
+{
+public:
+  /// Если хранилище не открыто, используется хранилище пула или хранилище по умолчанию.
+  explicit BalanceValidator(Storage storage = Storage());
+
+  void prepare(const Pool& pool, size_t threads) override;
+  Verdict validate(const Transaction& transaction, size_t index) const override;
+
+private:
+  void load_balances(const Pool& pool, size_t threads);
+  Amount balance(const Address& source, const Currency& currency) const;
+  static Verdict check(Amount amount, Amount balance, Amount debit);
+
+private:
+  Storage storage_;
+  ::std::unordered_map<Address, ::std::unordered_map<Currency, Amount>> balances_;
+  ::std::vector<Amount> debits_;  // Сумма принятых транзакций отправителя в пуле до транзакции
+};
+
+/// Ограничения на дополнительные поля транзакций.
+class UserFieldValidator : public PoolValidator
+{
+public:
+  /// Ограничение на значение поля. Вызывается одновременно из нескольких потоков.
+  using Constraint = ::std::function<bool(const UserField& field)>;
+
+  /// Поле id обязательно и должно иметь тип type.
+  void require(user_field_id_t id, UserField::Type type);
+
+  /// Поле id, если оно есть, должно удовлетворять ограничению constraint.
+  void add_constraint(user_field_id_t id, Constraint constraint);
+
+  Verdict validate(const Transaction& transaction, size_t index) const override;
+
+private:
+  ::std::vector<::std::pair<user_field_id_t, UserField::Type>> required_;
+  ::std::vector<::std::pair<user_field_id_t, Constraint>> constraints_;
+};
+
+/// Последовательность проверок. Результат - первый вердикт, отличный от \ref Valid.
+class PoolValidatorChain : public PoolValidator
+{
+public:
+  void add(::std::shared_ptr<PoolValidator> validator);
+
+  void prepare(const Pool& pool, size_t threads) override;
+  Verdict validate(const Transaction& transaction, size_t index) const override;
+
+private:
+  ::std::vector<::std::shared_ptr<PoolValidator>> validators_;
+};
+
+} // namespace csdb
+
+#endif // _CREDITS_CSDB_POOL_VALIDATOR_H_INCLUDED_
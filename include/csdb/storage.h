@@ -18,6 +18,7 @@
 namespace csdb {
 
 class Pool;
+class PoolColumns;
 class PoolHash;
 class Address;
 class Wallet;
@@ -81,10 +82,58 @@ public:
   WeakPtr weak_ptr() const noexcept;
 
 public:
+  /**
+   * @brief Проверка записей пулов при открытии хранилища.
+   *
+   * После успешного открытия в базе данных сохраняется граница проверенных пулов - наибольший
+   * номер пула и количество пулов (см. \ref IncrementalVerification).
+   */
+  enum Verification {
+    /**
+     * Проверяются контрольные суммы записей (CRC-32C) и заголовки пулов. Хеш вычисляется и пул
+     * разбирается полностью только для записей без контрольной суммы (сделанных предыдущими
+     * версиями). Обнаруживает случайное повреждение данных.
+     */
+    ChecksumVerification = 0,
+    /**
+     * Для каждого пула вычисляется хеш, который сравнивается с ключом записи, и пул разбирается
+     * полностью. Обнаруживает и намеренное изменение данных, но требует хеширования всего
+     * хранилища.
+     */
+    FullVerification = 1,
+    /**
+     * Пулы, проверенные при предыдущем успешном открытии (с номером не больше сохранённой
+     * границы), не проверяются повторно: из них читаются только заголовки. Остальные записи
+     * проверяются так же, как при \ref ChecksumVerification. Время открытия пропорционально
+     * объёму данных, записанных после предыдущего открытия.
+     *
+     * Если количество пулов в пределах границы изменилось, выполняется \ref ChecksumVerification.
+     * Прогресс при этом не начинается заново: уже сообщённые пулы проверяются повторно без
+     * вызова функции обратного вызова.
+     * Для полной проверки хранилища без учёта границы используется \ref FullVerification.
+     */
+    IncrementalVerification = 2,
+  };
+
+  /**
+   * @brief Параметры открытия хранилища.
+   *
+   * Открытие не только читает базу данных: после успешной проверки в неё записывается граница
+   * проверенных пулов (служебная запись "csdb.verified", см. \ref Verification), если она
+   * изменилась. Ошибка этой записи, например, для базы, открытой только на чтение, не мешает
+   * открытию.
+   */
   struct OpenOptions
   {
+    OpenOptions(::std::shared_ptr<Database> db = nullptr,
+                Verification verification = IncrementalVerification) :
+      db(db), verification(verification)
+    {}
+
     /// Экземпляр драйвера базы данных
     ::std::shared_ptr<Database> db;
+    /// Проверка записей при открытии.
+    Verification verification;
   };
 
   struct OpenProgress
@@ -168,6 +217,73 @@ public:
    */
   PoolHash last_hash() const noexcept;
 
+  /// Сжатие пулов при записи в хранилище.
+  enum Compression {
+    NoCompression = 0,          ///< Пулы записываются без изменений.
+    FastCompression = 1,        ///< Каждый пул сжимается отдельно (LZ77).
+    /**
+     * То же, что \ref FastCompression, но со словарём, полученным
+     * \ref train_compression_dictionary. Пока словаря нет, действует как \ref FastCompression.
+     */
+    DictionaryCompression = 2,
+  };
+
+  /**
+   * @brief Устанавливает сжатие для пулов, записываемых после вызова.
+   *
+   * Сжатие не влияет на бинарное представление и хеш пула: хеш вычисляется по несжатым данным,
+   * а сжатые записи распаковываются при чтении. Записи, которые не удаётся сделать короче,
+   * сохраняются без сжатия. Хранилище может одновременно содержать сжатые и несжатые записи.
+   * По умолчанию сжатие выключено.
+   */
+  void set_compression(Compression compression) noexcept;
+  Compression compression() const noexcept;
+
+  /**
+   * @brief Строит словарь для \ref DictionaryCompression по последним пулам цепочки.
+   * @param[in] pools_count Количество последних пулов, по которым строится словарь.
+   * @param[in] max_size    Максимальный размер словаря в байтах.
+   * @return true, если словарь построен и сохранён в хранилище.
+   *
+   * В словарь попадают адреса, встречающиеся больше чем в одном пуле, начиная с самых частых.
+   * Словарь сохраняется в базе данных и используется для пулов, записываемых после вызова
+   * (в том числе после повторного открытия хранилища). Пулы, сжатые с прежними словарями,
+   * остаются читаемыми.
+   */
+  bool train_compression_dictionary(size_t pools_count = 1000, size_t max_size = 0xFFFF);
+
+  /**
+   * @brief Callback фоновой проверки для повреждённой записи.
+   * @param hash    Ключ записи (пустой хеш, если ключ не является хешем).
+   * @param message Описание ошибки.
+   *
+   * Вызывается из потока фоновой проверки.
+   */
+  typedef ::std::function<void(const PoolHash& hash, const ::std::string& message)> ScrubCallback;
+
+  /**
+   * @brief Запускает фоновую проверку хранилища.
+   * @param[in] bytes_per_second Ограничение скорости чтения записей; 0 - без ограничения.
+   * @param[in] callback         Функция, вызываемая для каждой повреждённой записи.
+   * @return true, если проверка запущена. false, если хранилище не открыто или проверка уже идёт.
+   *
+   * Отдельный поток просматривает записи пулов в порядке ключей и для каждой проверяет то же,
+   * что и открытие с \ref FullVerification: контрольную сумму записи, совпадение хеша с ключом
+   * и разбор пула. Дойдя до конца, проверка начинается заново, пока не будет вызван
+   * \ref stop_scrubber или \ref close. Записи читаются через \ref Database::new_scan_iterator,
+   * поэтому не вытесняют из кеша базы данные, используемые при обычной работе.
+   *
+   * Драйвер базы данных должен допускать чтение из другого потока одновременно с записью
+   * (\ref DatabaseLevelDB допускает).
+   */
+  bool start_scrubber(uint64_t bytes_per_second, ScrubCallback callback);
+
+  /// Останавливает фоновую проверку и дожидается завершения её потока.
+  void stop_scrubber();
+
+  /// Количество полных проходов фоновой проверки с момента её запуска.
+  uint64_t scrubber_passes() const noexcept;
+
   /**
    * @brief Записавает пул в хранилище
    * @param[in] pool Пул для записи в хранилище.
@@ -177,18 +293,68 @@ public:
    */
   bool pool_save(Pool pool);
 
+  /**
+   * @brief Записывает в хранилище пулы, заданные бинарным представлением.
+   * @param[in] pools Бинарные представления пулов (\ref ::csdb::Pool::to_binary).
+   * @return true, если все пулы записаны. При ошибке не записывается ни один пул.
+   *
+   * Предназначена для массового импорта пулов: хеши всех пулов вычисляются одновременно,
+   * а пулы записываются в базу данных одной операцией. Пулы цепочки следует передавать
+   * в порядке возрастания номера, чтобы \ref last_hash указывал на последний из них.
+   */
+  bool pool_save_batch(const ::std::vector<::csdb::internal::byte_array>& pools);
+
+  /**
+   * @brief Задаёт выборочную проверку хеша при чтении пулов (\ref pool_load, \ref pool_load_columns).
+   * @param[in] interval Хеш вычисляется для каждого interval-го пула, прочитанного из записи
+   *                     с контрольной суммой; 0 - никогда, 1 - для каждого пула.
+   *
+   * Хеш пула из записи с верной контрольной суммой по умолчанию не вычисляется, а берётся
+   * из ключа записи (см. \ref Pool::from_binary(::csdb::internal::byte_array, const PoolHash&)).
+   * Контрольная сумма обнаруживает случайное повреждение записи, но не её подмену; для защиты
+   * от подмены используется проверка при открытии (\ref FullVerification) или эта настройка.
+   */
+  void set_load_verification_interval(size_t interval) noexcept;
+  size_t load_verification_interval() const noexcept;
+
   /**
    * @brief Загружает пул из хранилища
    * @param[in] hash Хэш пула, который надо загрузить.
    * @return Загруженный пул. Если пул не найден или данные из хранилища не могут быть
    *         интерпретированы, как пул, возвращается невалидный пул.
-   *         (\ref ::csdb::Pool::is_valid() == false).
+   *         (\ref ::csdb::Pool::is_valid() == false). Невалидный пул возвращается и в том случае,
+   *         если вычисленный хеш пула не совпадает с hash (см. \ref set_load_verification_interval).
    *
    * \sa ::csdb::Pool::load
    */
   Pool pool_load(const PoolHash &hash) const;
   Pool pool_load_meta(const PoolHash &hash, size_t& cnt) const;
 
+  /**
+   * @brief Загружает столбцы пула из хранилища
+   * @param[in] hash Хэш пула, который надо загрузить.
+   * @return Столбцы пула. Если пул не найден или данные из хранилища не могут быть
+   *         интерпретированы, как пул, возвращается невалидный объект. Хеш пула проверяется
+   *         так же, как в \ref pool_load.
+   *
+   * \sa ::csdb::PoolColumns::load
+   */
+  PoolColumns pool_load_columns(const PoolHash &hash) const;
+
+  /**
+   * @brief Загружает пул для перебора транзакций.
+   * @param[in]  hash    Хэш пула, который надо загрузить.
+   * @param[out] columns Столбцы пула в формате \ref Pool::ColumnarFormat.
+   * @param[out] pool    Пул в остальных форматах.
+   * @return true, если пул прочитан; валиден ровно один из объектов columns и pool.
+   *
+   * Для \ref Pool::ColumnarFormat, как и в \ref pool_load_columns, декодируются только
+   * таблицы. Пулы в остальных форматах всё равно декодируются целиком, и перебрать их
+   * транзакции быстрее, чем строить по ним столбцы. Хеш пула проверяется так же, как
+   * в \ref pool_load.
+   */
+  bool pool_load_scan(const PoolHash &hash, PoolColumns &columns, Pool &pool) const;
+
   /**
    * @brief Получение транзакции по идентификатору.
    * @param[in] id Идентификатор транзакции
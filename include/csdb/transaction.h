@@ -8,6 +8,7 @@
 #define _CREDITS_CSDB_TRANSACTION_H_INCLUDED_
 
 #include <set>
+#include <functional>
 
 #include "csdb/user_field.h"
 
@@ -20,6 +21,7 @@ namespace csdb {
 namespace priv {
 class obstream;
 class ibstream;
+class unchecked_ibstream;
 } // namespace priv
 
 class Address;
@@ -81,10 +83,12 @@ public:
 private:
   void put(::csdb::priv::obstream&) const;
   bool get(::csdb::priv::ibstream&);
+  size_t serialized_size() const noexcept;
   friend class ::csdb::priv::obstream;
   friend class ::csdb::priv::ibstream;
   friend class Transaction;
   friend class Pool;
+  friend struct ::std::hash<TransactionID>;
 };
 
 class Transaction
@@ -118,6 +122,17 @@ public:
   static Transaction from_byte_stream(const char* data, size_t m_size);
   std::vector<uint8_t> to_byte_stream() const;
 
+  /// Размер бинарного представления, которое запишет \ref to_byte_stream.
+  size_t byte_stream_size() const noexcept;
+
+  /**
+   * @brief Дописывает бинарное представление транзакции в конец буфера вызывающей стороны.
+   *
+   * Позволяет собрать заголовок пакета и несколько транзакций в одном буфере без промежуточных
+   * массивов. Память под транзакцию резервируется заранее по \ref byte_stream_size.
+   */
+  void to_byte_stream(::csdb::internal::byte_array& buffer) const;
+
   /**
    * @brief Добавляет дополнительное произвольное поле к транзакции
    * @param[in] id    Идентификатор дополнительного поля
@@ -146,14 +161,32 @@ public:
    */
   ::std::set<user_field_id_t> user_field_ids() const noexcept;
 
+  /**
+   * @brief Список идентификаторов дополнительных полей без выделения памяти
+   * @return  Диапазон идентификаторов дополнительных полей в порядке возрастания. Диапазон
+   *          действителен, пока объект существует и его дополнительные поля не изменяются.
+   */
+  UserFieldIdRange user_field_id_range() const noexcept;
+
 private:
   void put(::csdb::priv::obstream&) const;
   bool get(::csdb::priv::ibstream&);
+  void get(::csdb::priv::unchecked_ibstream&);
+  size_t serialized_size() const noexcept;
   friend class ::csdb::priv::obstream;
   friend class ::csdb::priv::ibstream;
+  friend class ::csdb::priv::unchecked_ibstream;
   friend class Pool;
 };
 
 } // namespace csdb
 
+namespace std {
+template<>
+struct hash<::csdb::TransactionID>
+{
+  size_t operator()(const ::csdb::TransactionID &value) const noexcept;
+};
+} // namespace std
+
 #endif // _CREDITS_CSDB_TRANSACTION_H_INCLUDED_
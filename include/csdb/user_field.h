@@ -10,6 +10,8 @@
 #include <cinttypes>
 #include <string>
 #include <vector>
+#include <utility>
+#include <iterator>
 #include <type_traits>
 
 #include "csdb/amount.h"
@@ -20,6 +22,7 @@ namespace csdb {
 namespace priv {
 class obstream;
 class ibstream;
+class unchecked_ibstream;
 } // namespace priv
 
 /**
@@ -84,8 +87,11 @@ public:
 private:
   void put(::csdb::priv::obstream&) const;
   bool get(::csdb::priv::ibstream&);
+  void get(::csdb::priv::unchecked_ibstream&);
+  size_t serialized_size() const noexcept;
   friend class ::csdb::priv::obstream;
   friend class ::csdb::priv::ibstream;
+  friend class ::csdb::priv::unchecked_ibstream;
 };
 
 inline bool UserField::operator !=(const UserField& other) const noexcept
@@ -93,6 +99,51 @@ inline bool UserField::operator !=(const UserField& other) const noexcept
   return !operator ==(other);
 }
 
+/**
+ * @brief Список идентификаторов дополнительных полей без копирования.
+ *
+ * Диапазон ссылается на внутренние данные объекта (\ref Transaction или \ref Pool), из которого
+ * он получен, и действителен до первого изменения списка дополнительных полей этого объекта.
+ * Идентификаторы перечисляются в порядке возрастания.
+ */
+class UserFieldIdRange
+{
+public:
+  using item_type = ::std::pair<user_field_id_t, UserField>;
+
+  class const_iterator
+  {
+  public:
+    using iterator_category = ::std::forward_iterator_tag;
+    using value_type = user_field_id_t;
+    using difference_type = ::std::ptrdiff_t;
+    using pointer = const user_field_id_t*;
+    using reference = user_field_id_t;
+
+    inline explicit const_iterator(const item_type* p) noexcept : p_(p) {}
+    inline user_field_id_t operator *() const noexcept { return p_->first; }
+    inline const_iterator& operator ++() noexcept { ++p_; return *this; }
+    inline const_iterator operator ++(int) noexcept { const_iterator res(*this); ++p_; return res; }
+    inline bool operator ==(const const_iterator& other) const noexcept { return p_ == other.p_; }
+    inline bool operator !=(const const_iterator& other) const noexcept { return p_ != other.p_; }
+  private:
+    const item_type* p_;
+  };
+
+  inline UserFieldIdRange(const item_type* begin, const item_type* end) noexcept :
+    begin_(begin), end_(end)
+  {}
+
+  inline const_iterator begin() const noexcept { return const_iterator(begin_); }
+  inline const_iterator end() const noexcept { return const_iterator(end_); }
+  inline size_t size() const noexcept { return static_cast<size_t>(end_ - begin_); }
+  inline bool empty() const noexcept { return begin_ == end_; }
+
+private:
+  const item_type* begin_;
+  const item_type* end_;
+};
+
 template<>
 UserField::UserField(uint64_t value);
 
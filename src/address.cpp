@@ -1,8 +1,10 @@
 #include "csdb/address.h"
 #include "csdb/internal/types.h"
 #include "csdb/internal/utils.h"
+#include "csdb/internal/fixed_byte_array.h"
 #include "csdb/internal/shared_data_ptr_implementation.h"
 #include "binary_streams.h"
+#include "serialization_schema.h"
 
 #include "priv_crypto.h"
 
@@ -10,9 +12,12 @@ namespace csdb {
 
 class Address::priv : public ::csdb::internal::shared_data
 {
-  ::csdb::internal::byte_array data_;
+  ::csdb::internal::fixed_byte_array<::csdb::priv::crypto::max_public_key_size> data_;
+
+  typedef ::csdb::priv::schema<priv, CSDB_SCHEMA_FIELD(priv, data_)> serialization_schema;
 
   friend class ::csdb::Address;
+  friend struct ::std::hash<::csdb::Address>;
 };
 SHARED_DATA_CLASS_IMPLEMENTATION(Address)
 
@@ -33,7 +38,7 @@ bool Address::operator <(const Address &other) const noexcept
 
 ::std::string Address::to_string() const noexcept
 {
-  return internal::to_hex(d->data_);
+  return internal::to_hex(d->data_.begin(), d->data_.end());
 }
 
 Address Address::from_string(const ::std::string &val)
@@ -42,7 +47,7 @@ Address Address::from_string(const ::std::string &val)
 
   const ::csdb::internal::byte_array data = ::csdb::internal::from_hex( val );
   if (::csdb::priv::crypto::public_key_size == data.size()) {
-    res.d->data_ = data;
+    res.d->data_.assign(data);
   }
 
   return res;
@@ -50,7 +55,7 @@ Address Address::from_string(const ::std::string &val)
 
 ::csdb::internal::byte_array Address::public_key() const noexcept
 {
-  return d->data_;
+  return d->data_.to_byte_array();
 }
 
 Address Address::from_public_key(const ::csdb::internal::byte_array &key)
@@ -58,7 +63,7 @@ Address Address::from_public_key(const ::csdb::internal::byte_array &key)
 	Address res;
 
 	if (::csdb::priv::crypto::public_key_size == key.size()) {
-		res.d->data_ = key;
+		res.d->data_.assign(key);
 	}
 
 	return res;
@@ -67,18 +72,33 @@ Address Address::from_public_key(const ::csdb::internal::byte_array &key)
 Address Address::from_public_key(const char* key)
 {
 	Address res;
-	res.d->data_ = ::csdb::internal::byte_array((const uint8_t*)key, (const uint8_t*)key + ::csdb::priv::crypto::public_key_size);
+	res.d->data_.assign(key, ::csdb::priv::crypto::public_key_size);
 	return res;
 }
 
 void Address::put(::csdb::priv::obstream &os) const
 {
-  os.put(d->data_);
+  priv::serialization_schema::put(os, *d.constData());
 }
 
 bool Address::get(::csdb::priv::ibstream &is)
 {
-  return is.get(d->data_);
+  return priv::serialization_schema::get(is, *d.data());
+}
+
+void Address::get(::csdb::priv::unchecked_ibstream &is)
+{
+  priv::serialization_schema::get(is, *d.data());
+}
+
+size_t Address::serialized_size() const noexcept
+{
+  return priv::serialization_schema::serialized_size(*d.constData());
 }
 
 } // namespace csdb
+
+size_t std::hash<::csdb::Address>::operator()(const ::csdb::Address &value) const noexcept
+{
+  return value.d->data_.hash();
+}
@@ -2,14 +2,21 @@
 
 #include <cstdio>
 #include <algorithm>
+#include <limits>
 
 #ifndef _MSC_VER
 #define sprintf_s sprintf
 #endif
 
 #include "binary_streams.h"
+#include "serialization_schema.h"
 
 namespace csdb {
+
+struct Amount::serialization_schema :
+  public priv::schema<Amount, CSDB_SCHEMA_FIELD(Amount, integral_), CSDB_SCHEMA_FIELD(Amount, fraction_)>
+{};
+
 Amount::Amount(double value)
 {
   if ((value < static_cast<double>(std::numeric_limits<int32_t>::min()))
@@ -61,13 +68,113 @@ Amount::Amount(double value)
 
 void Amount::put(priv::obstream& os) const
 {
-  os.put(integral_);
-  os.put(fraction_);
+  serialization_schema::put(os, *this);
 }
 
 bool Amount::get(priv::ibstream& is)
 {
-  return is.get(integral_) && is.get(fraction_);
+  return serialization_schema::get(is, *this);
+}
+
+void Amount::get(priv::unchecked_ibstream& is)
+{
+  serialization_schema::get(is, *this);
+}
+
+size_t Amount::serialized_size() const noexcept
+{
+  return serialization_schema::serialized_size(*this);
+}
+
+namespace {
+
+/// Количество десятичных знаков дробной части.
+constexpr unsigned FRACTION_DIGITS = 18;
+
+constexpr uint64_t pow10[FRACTION_DIGITS + 1] = {
+  1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL,
+  1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+  100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+  1000000000000000000ULL
+};
+
+inline int64_t compact_header(int32_t integral, uint64_t fraction) noexcept
+{
+  return static_cast<int64_t>(integral) * 2 + ((0 != fraction) ? 1 : 0);
+}
+
+/// Дробная часть без нулей в конце и количество этих нулей. Дробная часть не должна быть нулевой.
+inline uint64_t compact_fraction(uint64_t fraction) noexcept
+{
+  uint64_t mantissa = fraction;
+  unsigned zeros = 0;
+  for (unsigned step : {16U, 8U, 4U, 2U, 1U}) {
+    if (0 == (mantissa % pow10[step])) {
+      mantissa /= pow10[step];
+      zeros += step;
+    }
+  }
+  // mantissa < 10^(18 - zeros), поэтому значение не превышает 10^18 * 18 < 2^64.
+  return mantissa * FRACTION_DIGITS + zeros;
+}
+
+inline uint64_t fraction_from_compact(uint64_t value) noexcept
+{
+  return (value / FRACTION_DIGITS) * pow10[value % FRACTION_DIGITS];
+}
+
+/// Мантисса не нулевая и дробная часть меньше AMOUNT_MAX_FRACTION.
+inline bool is_valid_compact_fraction(uint64_t value) noexcept
+{
+  const uint64_t mantissa = value / FRACTION_DIGITS;
+  return (0 != mantissa) && (mantissa < pow10[FRACTION_DIGITS - (value % FRACTION_DIGITS)]);
+}
+
+} // namespace
+
+void Amount::put_compact(priv::obstream& os) const
+{
+  os.put(compact_header(integral_, fraction_));
+  if (0 != fraction_) {
+    os.put(compact_fraction(fraction_));
+  }
+}
+
+bool Amount::get_compact(priv::ibstream& is)
+{
+  int64_t header;
+  if (!is.get(header)
+      || (header < static_cast<int64_t>(::std::numeric_limits<int32_t>::min()) * 2)
+      || (header > static_cast<int64_t>(::std::numeric_limits<int32_t>::max()) * 2 + 1)) {
+    return false;
+  }
+
+  uint64_t fraction = 0;
+  if ((0 != (header & 1)) && (!is.get(fraction) || !is_valid_compact_fraction(fraction))) {
+    return false;
+  }
+
+  integral_ = static_cast<int32_t>(header >> 1);
+  fraction_ = fraction_from_compact(fraction);
+  return true;
+}
+
+void Amount::get_compact(priv::unchecked_ibstream& is)
+{
+  int64_t header;
+  is.get(header);
+  uint64_t fraction = 0;
+  if (0 != (header & 1)) {
+    is.get(fraction);
+  }
+  integral_ = static_cast<int32_t>(header >> 1);
+  fraction_ = fraction_from_compact(fraction);
+}
+
+size_t Amount::compact_serialized_size() const noexcept
+{
+  return priv::obstream::serialized_size(compact_header(integral_, fraction_))
+      + ((0 != fraction_) ? priv::obstream::serialized_size(compact_fraction(fraction_)) : 0);
 }
 
 } // namespace csdb
@@ -12,7 +12,10 @@
 #include <type_traits>
 #include <utility>
 #include <map>
+#include <vector>
 #include "csdb/internal/types.h"
+#include "csdb/internal/fixed_byte_array.h"
+#include "csdb/internal/small_flat_map.h"
 
 #include "integral_encdec.h"
 
@@ -37,7 +40,55 @@ public:
   template<class K, class T, class C, class A>
   void put(const ::std::map<K, T, C, A>& value);
 
+  template<size_t N>
+  void put(const internal::fixed_byte_array<N>& value);
+
+  template<class K, class T, size_t N>
+  void put(const internal::small_flat_map<K, T, N>& value);
+
+  /// Массив элементов: количество, затем элементы по порядку.
+  template<class T, class A>
+  void put(const ::std::vector<T, A>& value);
+
+  /**
+   * @brief Резервирует в буфере место под дополнительные данные.
+   * @param[in] size Количество байт, которое будет записано в поток.
+   *
+   * Обычно вызывается один раз перед записью с размером, полученным от \ref serialized_size.
+   */
+  inline void reserve(size_t size) { buffer_.reserve(buffer_.size() + size); }
+
   inline const internal::byte_array &buffer() const { return buffer_; }
+  inline internal::byte_array &buffer() { return buffer_; }
+
+  /**
+   * @brief Размер данных, которые запишет в поток вызов put() для того же значения.
+   *
+   * Набор перегрузок повторяет набор перегрузок put(). Для пользовательских типов
+   * вызывается метод serialized_size(), который должен повторять обход полей метода put().
+   */
+  static size_t serialized_size(const std::string &value);
+  static size_t serialized_size(const internal::byte_array &value);
+
+  template<typename T>
+  static typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, size_t>::type
+  serialized_size(T value);
+
+  template<typename T>
+  static decltype(std::declval<T>().serialized_size())
+  serialized_size(const T& value);
+
+  template<class K, class T, class C, class A>
+  static size_t serialized_size(const ::std::map<K, T, C, A>& value);
+
+  template<size_t N>
+  static size_t serialized_size(const internal::fixed_byte_array<N>& value);
+
+  template<class K, class T, size_t N>
+  static size_t serialized_size(const internal::small_flat_map<K, T, N>& value);
+
+  template<class T, class A>
+  static size_t serialized_size(const ::std::vector<T, A>& value);
 
 private:
   internal::byte_array buffer_;
@@ -66,11 +117,55 @@ public:
   template<class K, class T, class C, class A>
   bool get(::std::map<K, T, C, A>& value);
 
+  template<size_t N>
+  bool get(internal::fixed_byte_array<N>& value);
+
+  template<class K, class T, size_t N>
+  bool get(internal::small_flat_map<K, T, N>& value);
+
+  template<class T, class A>
+  bool get(::std::vector<T, A>& value);
+
+  /**
+   * @brief Читает \ref count целых значений, записанных подряд (см. \ref decode_batch).
+   * @return false, если данные содержат ошибку. В этом случае позиция не изменяется.
+   */
+  inline bool get_integrals(uint64_t *values, size_t count)
+  {
+    const size_t res = ::csdb::priv::decode_batch(data_, size_, values, count);
+    if (0 == res) {
+      return false;
+    }
+    data_ = static_cast<const uint8_t*>(data_) + res;
+    size_ -= res;
+    return true;
+  }
+
+  /**
+   * @brief Пропускает указанное количество байт.
+   * @return false, если данных недостаточно. В этом случае позиция не изменяется.
+   */
+  inline bool skip(size_t size)
+  {
+    if (size > size_) {
+      return false;
+    }
+    data_ = static_cast<const uint8_t*>(data_) + size;
+    size_ -= size;
+    return true;
+  }
+
   inline size_t size() const noexcept
   {
     return size_;
   }
 
+  /// Текущая позиция в данных.
+  inline const void* data() const noexcept
+  {
+    return data_;
+  }
+
   inline bool empty() const noexcept
   {
     return (0 == size_);
@@ -81,6 +176,69 @@ private:
   size_t size_;
 };
 
+/**
+ * @brief Чтение данных, структура которых уже проверена.
+ *
+ * В отличие от \ref ibstream не проверяет выход за границы данных и не возвращает признак
+ * ошибки, поэтому может использоваться только для данных, успешно прошедших проверку структуры
+ * (см. \ref scan_pool, \ref scan_transaction). Набор перегрузок get() повторяет набор
+ * перегрузок \ref ibstream::get для типов, входящих в пул.
+ */
+class unchecked_ibstream
+{
+public:
+  unchecked_ibstream(const void* data, size_t size) :
+    pos_(static_cast<const uint8_t*>(data)),
+    end_(static_cast<const uint8_t*>(data) + size)
+  {}
+
+public:
+  void get(std::string &value);
+  void get(internal::byte_array &value);
+
+  template<typename T>
+  typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, void>::type
+  get(T& value);
+
+  template<typename T>
+  decltype(std::declval<T>().get(std::declval<unchecked_ibstream&>()))
+  get(T& value);
+
+  template<size_t N>
+  void get(internal::fixed_byte_array<N>& value);
+
+  template<class K, class T, size_t N>
+  void get(internal::small_flat_map<K, T, N>& value);
+
+  template<class T, class A>
+  void get(::std::vector<T, A>& value);
+
+  /// Читает \ref count целых значений, записанных подряд (см. \ref decode_batch_unchecked).
+  inline void get_integrals(uint64_t *values, size_t count)
+  {
+    pos_ += ::csdb::priv::decode_batch_unchecked(pos_, size(), values, count);
+  }
+
+  inline void skip(size_t size)
+  {
+    pos_ += size;
+  }
+
+  inline size_t size() const noexcept
+  {
+    return static_cast<size_t>(end_ - pos_);
+  }
+
+  inline const void* data() const noexcept
+  {
+    return pos_;
+  }
+
+private:
+  const uint8_t* pos_;
+  const uint8_t* end_;
+};
+
 } // namespace priv
 } // namespace csdb
 
@@ -112,6 +270,94 @@ void obstream::put(const ::std::map<K, T, C, A>& value)
   }
 }
 
+template<class K, class T, size_t N>
+void obstream::put(const internal::small_flat_map<K, T, N>& value)
+{
+  put(value.size());
+  for (const auto& it : value) {
+    put(it.first);
+    put(it.second);
+  }
+}
+
+template<class T, class A>
+void obstream::put(const ::std::vector<T, A>& value)
+{
+  put(value.size());
+  for (const auto& it : value) {
+    put(it);
+  }
+}
+
+template<size_t N>
+inline void obstream::put(const internal::fixed_byte_array<N>& value)
+{
+  put(value.size());
+  buffer_.insert(buffer_.end(), value.begin(), value.end());
+}
+
+inline size_t obstream::serialized_size(const std::string &value)
+{
+  return serialized_size(value.size()) + value.size();
+}
+
+inline size_t obstream::serialized_size(const internal::byte_array &value)
+{
+  return serialized_size(value.size()) + value.size();
+}
+
+template<typename T>
+typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, size_t>::type
+inline obstream::serialized_size(T value)
+{
+  return ::csdb::priv::encoded_size(value);
+}
+
+template<typename T>
+decltype(std::declval<T>().serialized_size())
+inline obstream::serialized_size(const T& value)
+{
+  return value.serialized_size();
+}
+
+template<class K, class T, class C, class A>
+size_t obstream::serialized_size(const ::std::map<K, T, C, A>& value)
+{
+  size_t res = serialized_size(value.size());
+  for (const auto& it : value) {
+    res += serialized_size(it.first);
+    res += serialized_size(it.second);
+  }
+  return res;
+}
+
+template<class K, class T, size_t N>
+size_t obstream::serialized_size(const internal::small_flat_map<K, T, N>& value)
+{
+  size_t res = serialized_size(value.size());
+  for (const auto& it : value) {
+    res += serialized_size(it.first);
+    res += serialized_size(it.second);
+  }
+  return res;
+}
+
+template<class T, class A>
+size_t obstream::serialized_size(const ::std::vector<T, A>& value)
+{
+  size_t res = serialized_size(value.size());
+  for (const auto& it : value) {
+    res += serialized_size(it);
+  }
+  return res;
+}
+
+template<size_t N>
+inline size_t obstream::serialized_size(const internal::fixed_byte_array<N>& value)
+{
+  return serialized_size(value.size()) + value.size();
+}
+
 template<typename T>
 typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, bool>::type
 inline ibstream::get(T& value)
@@ -156,6 +402,157 @@ bool ibstream::get(::std::map<K, T, C, A>& value)
   return true;
 }
 
+template<class K, class T, size_t N>
+bool ibstream::get(internal::small_flat_map<K, T, N>& value)
+{
+  value.clear();
+
+  size_t size;
+  if (!get(size)) {
+    return false;
+  }
+
+  // Ключи записываются по возрастанию (см. obstream::put). При другом порядке элементы
+  // упорядочиваются один раз после чтения, а не сдвигаются при каждой вставке.
+  bool ordered = true;
+  for (size_t i = 0; i < size; ++i) {
+    K key;
+    T val;
+    if ((!get(key)) || (!get(val))) {
+      // Прочитанные элементы могут быть не упорядочены.
+      value.clear();
+      return false;
+    }
+    ordered = ordered && (value.empty() || ((value.end() - 1)->first < key));
+    value.push_back_unordered(key, val);
+  }
+  if (!ordered) {
+    value.sort_unique();
+  }
+
+  return true;
+}
+
+template<class T, class A>
+bool ibstream::get(::std::vector<T, A>& value)
+{
+  value.clear();
+
+  size_t size;
+  if (!get(size)) {
+    return false;
+  }
+
+  // Каждый элемент занимает хотя бы один байт, поэтому заведомо ошибочное количество
+  // не приводит к выделению лишней памяти.
+  value.reserve((size < size_) ? size : size_);
+  for (size_t i = 0; i < size; ++i) {
+    T val;
+    if (!get(val)) {
+      return false;
+    }
+    value.push_back(::std::move(val));
+  }
+
+  return true;
+}
+
+template<size_t N>
+bool ibstream::get(internal::fixed_byte_array<N>& value)
+{
+  size_t size;
+  if (!get(size)) {
+    return false;
+  }
+  if ((size > size_) || (size > N)) {
+    return false;
+  }
+
+  const uint8_t *data = static_cast<const uint8_t*>(data_);
+  value.assign(data, size);
+  size_ -= size;
+  data_ = static_cast<const void*>(data + size);
+  return true;
+}
+
+inline void unchecked_ibstream::get(std::string &value)
+{
+  size_t size;
+  get(size);
+  value.assign(reinterpret_cast<const char*>(pos_), size);
+  pos_ += size;
+}
+
+inline void unchecked_ibstream::get(internal::byte_array &value)
+{
+  size_t size;
+  get(size);
+  value.assign(pos_, pos_ + size);
+  pos_ += size;
+}
+
+template<typename T>
+typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, void>::type
+inline unchecked_ibstream::get(T& value)
+{
+  pos_ += ::csdb::priv::decode_unchecked(pos_, size(), value);
+}
+
+template<typename T>
+decltype(std::declval<T>().get(std::declval<unchecked_ibstream&>()))
+inline unchecked_ibstream::get(T& value)
+{
+  value.get(*this);
+}
+
+template<size_t N>
+inline void unchecked_ibstream::get(internal::fixed_byte_array<N>& value)
+{
+  size_t size;
+  get(size);
+  value.assign(pos_, size);
+  pos_ += size;
+}
+
+template<class K, class T, size_t N>
+void unchecked_ibstream::get(internal::small_flat_map<K, T, N>& value)
+{
+  value.clear();
+
+  size_t size;
+  get(size);
+  value.reserve(size);
+
+  bool ordered = true;
+  for (size_t i = 0; i < size; ++i) {
+    K key;
+    get(key);
+    T val;
+    get(val);
+    ordered = ordered && (value.empty() || ((value.end() - 1)->first < key));
+    value.push_back_unordered(key, val);
+  }
+  if (!ordered) {
+    value.sort_unique();
+  }
+}
+
+template<class T, class A>
+void unchecked_ibstream::get(::std::vector<T, A>& value)
+{
+  value.clear();
+
+  size_t size;
+  get(size);
+  value.reserve(size);
+
+  for (size_t i = 0; i < size; ++i) {
+    T val;
+    get(val);
+    value.push_back(::std::move(val));
+  }
+}
+
 } // namespace priv
 } // namespace csdb
 
@@ -0,0 +1,376 @@
+#include "blake2s.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+#include "csdb/internal/endian.h"
+
+// Пакетное вычисление хешей использует AVX2, если процессор его поддерживает.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CSDB_BLAKE2S_AVX2
+#define CSDB_BLAKE2S_AVX2_FUNCTION __attribute__((target("avx2")))
+#elif defined(__AVX2__)
+#define CSDB_BLAKE2S_AVX2
+#define CSDB_BLAKE2S_AVX2_FUNCTION
+#endif
+
+#ifdef CSDB_BLAKE2S_AVX2
+#include <immintrin.h>
+#endif
+
+namespace csdb {
+namespace priv {
+
+namespace {
+
+const uint32_t iv[8] = {
+  0x6A09E667UL, 0xBB67AE85UL, 0x3C6EF372UL, 0xA54FF53AUL,
+  0x510E527FUL, 0x9B05688CUL, 0x1F83D9ABUL, 0x5BE0CD19UL
+};
+
+const uint8_t sigma[10][16] = {
+  {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+  { 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+  { 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 },
+  {  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 },
+  {  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 },
+  {  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 },
+  { 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 },
+  { 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 },
+  {  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 },
+  { 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0 },
+};
+
+inline uint32_t rotr(uint32_t v, unsigned n)
+{
+  return (v >> n) | (v << (32 - n));
+}
+
+inline uint32_t load32(const uint8_t *p)
+{
+  uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return ::csdb::internal::from_little_endian(v);
+}
+
+inline void store32(uint8_t *p, uint32_t v)
+{
+  v = ::csdb::internal::to_little_endian(v);
+  std::memcpy(p, &v, sizeof(v));
+}
+
+inline void mix(uint32_t *v, size_t a, size_t b, size_t c, size_t d, uint32_t x, uint32_t y)
+{
+  v[a] = v[a] + v[b] + x;
+  v[d] = rotr(v[d] ^ v[a], 16);
+  v[c] = v[c] + v[d];
+  v[b] = rotr(v[b] ^ v[c], 12);
+  v[a] = v[a] + v[b] + y;
+  v[d] = rotr(v[d] ^ v[a], 8);
+  v[c] = v[c] + v[d];
+  v[b] = rotr(v[b] ^ v[c], 7);
+}
+
+#ifdef CSDB_BLAKE2S_AVX2
+
+/// Количество буферов, обрабатываемых одновременно.
+constexpr size_t lanes = 8;
+
+/// Меньше буферов выгоднее обработать по одному.
+constexpr size_t min_lanes = 3;
+
+bool has_avx2() noexcept
+{
+#ifdef __GNUC__
+  static const bool res = __builtin_cpu_supports("avx2");
+  return res;
+#else
+  return true;
+#endif
+}
+
+template<int n>
+CSDB_BLAKE2S_AVX2_FUNCTION inline __m256i rotr8x(__m256i v)
+{
+  return _mm256_or_si256(_mm256_srli_epi32(v, n), _mm256_slli_epi32(v, 32 - n));
+}
+
+template<>
+CSDB_BLAKE2S_AVX2_FUNCTION inline __m256i rotr8x<16>(__m256i v)
+{
+  return _mm256_shuffle_epi8(v, _mm256_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+                                                 2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13));
+}
+
+template<>
+CSDB_BLAKE2S_AVX2_FUNCTION inline __m256i rotr8x<8>(__m256i v)
+{
+  return _mm256_shuffle_epi8(v, _mm256_setr_epi8(1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12,
+                                                 1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12));
+}
+
+CSDB_BLAKE2S_AVX2_FUNCTION inline void mix8x(__m256i *v, size_t a, size_t b, size_t c, size_t d,
+                                             __m256i x, __m256i y)
+{
+  v[a] = _mm256_add_epi32(_mm256_add_epi32(v[a], v[b]), x);
+  v[d] = rotr8x<16>(_mm256_xor_si256(v[d], v[a]));
+  v[c] = _mm256_add_epi32(v[c], v[d]);
+  v[b] = rotr8x<12>(_mm256_xor_si256(v[b], v[c]));
+  v[a] = _mm256_add_epi32(_mm256_add_epi32(v[a], v[b]), y);
+  v[d] = rotr8x<8>(_mm256_xor_si256(v[d], v[a]));
+  v[c] = _mm256_add_epi32(v[c], v[d]);
+  v[b] = rotr8x<7>(_mm256_xor_si256(v[b], v[c]));
+}
+
+/// Сжатие блоков восьми буферов. Слово i блока буфера l находится в m[i][l].
+CSDB_BLAKE2S_AVX2_FUNCTION void compress8x(__m256i *h, const uint32_t (*m)[lanes], const uint32_t *t0,
+                                           const uint32_t *t1, const uint32_t *f)
+{
+  __m256i mv[16];
+  __m256i v[16];
+
+  for (size_t i = 0; i < 16; ++i) {
+    mv[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m[i]));
+  }
+  for (size_t i = 0; i < 8; ++i) {
+    v[i] = h[i];
+    v[i + 8] = _mm256_set1_epi32(static_cast<int>(iv[i]));
+  }
+  v[12] = _mm256_xor_si256(v[12], _mm256_loadu_si256(reinterpret_cast<const __m256i*>(t0)));
+  v[13] = _mm256_xor_si256(v[13], _mm256_loadu_si256(reinterpret_cast<const __m256i*>(t1)));
+  v[14] = _mm256_xor_si256(v[14], _mm256_loadu_si256(reinterpret_cast<const __m256i*>(f)));
+
+  for (size_t r = 0; r < 10; ++r) {
+    const uint8_t *s = sigma[r];
+    mix8x(v, 0, 4,  8, 12, mv[s[ 0]], mv[s[ 1]]);
+    mix8x(v, 1, 5,  9, 13, mv[s[ 2]], mv[s[ 3]]);
+    mix8x(v, 2, 6, 10, 14, mv[s[ 4]], mv[s[ 5]]);
+    mix8x(v, 3, 7, 11, 15, mv[s[ 6]], mv[s[ 7]]);
+    mix8x(v, 0, 5, 10, 15, mv[s[ 8]], mv[s[ 9]]);
+    mix8x(v, 1, 6, 11, 12, mv[s[10]], mv[s[11]]);
+    mix8x(v, 2, 7,  8, 13, mv[s[12]], mv[s[13]]);
+    mix8x(v, 3, 4,  9, 14, mv[s[14]], mv[s[15]]);
+  }
+
+  for (size_t i = 0; i < 8; ++i) {
+    h[i] = _mm256_xor_si256(h[i], _mm256_xor_si256(v[i], v[i + 8]));
+  }
+}
+
+/**
+ * Хеши count <= lanes буферов. Буферы обрабатываются по блоку за шаг; буфер, хеш которого
+ * уже вычислен, до конца группы сжимает нулевые блоки, результат которых отбрасывается.
+ */
+CSDB_BLAKE2S_AVX2_FUNCTION void calc8x(const uint8_t *const *data, const size_t *sizes, uint8_t *const *digests,
+                                       size_t count)
+{
+  constexpr size_t block_size = blake2s::block_size;
+
+  size_t blocks[lanes];
+  size_t max_blocks = 0;
+  for (size_t l = 0; l < count; ++l) {
+    blocks[l] = ::std::max<size_t>(1, (sizes[l] + block_size - 1) / block_size);
+    max_blocks = ::std::max(max_blocks, blocks[l]);
+  }
+
+  __m256i h[8];
+  for (size_t i = 0; i < 8; ++i) {
+    h[i] = _mm256_set1_epi32(static_cast<int>(iv[i]));
+  }
+  h[0] = _mm256_xor_si256(h[0], _mm256_set1_epi32(static_cast<int>(0x01010000UL ^ blake2s::digest_size)));
+
+  uint32_t m[16][lanes];
+  uint32_t t0[lanes], t1[lanes], f[lanes];
+  uint8_t tail[block_size];
+  for (size_t b = 0; b < max_blocks; ++b) {
+    bool finished = false;
+    for (size_t l = 0; l < lanes; ++l) {
+      const uint8_t *block = nullptr;
+      uint64_t counter = 0;
+      f[l] = 0;
+      if ((l < count) && (b < blocks[l])) {
+        const size_t offset = b * block_size;
+        if (b + 1 < blocks[l]) {
+          block = data[l] + offset;
+          counter = offset + block_size;
+        } else {
+          // Последний блок дополняется нулями.
+          std::memset(tail, 0, block_size);
+          if (sizes[l] != offset) {
+            std::memcpy(tail, data[l] + offset, sizes[l] - offset);
+          }
+          block = tail;
+          counter = sizes[l];
+          f[l] = 0xFFFFFFFFUL;
+          finished = true;
+        }
+      }
+      for (size_t i = 0; i < 16; ++i) {
+        m[i][l] = (nullptr != block) ? load32(block + i * sizeof(uint32_t)) : 0;
+      }
+      t0[l] = static_cast<uint32_t>(counter);
+      t1[l] = static_cast<uint32_t>(counter >> 32);
+    }
+
+    compress8x(h, m, t0, t1, f);
+
+    if (finished) {
+      uint32_t result[8][lanes];
+      for (size_t i = 0; i < 8; ++i) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(result[i]), h[i]);
+      }
+      for (size_t l = 0; l < count; ++l) {
+        if (b + 1 == blocks[l]) {
+          for (size_t i = 0; i < 8; ++i) {
+            store32(digests[l] + i * sizeof(uint32_t), result[i][l]);
+          }
+        }
+      }
+    }
+  }
+}
+
+#endif // CSDB_BLAKE2S_AVX2
+
+} // namespace
+
+constexpr size_t blake2s::digest_size;
+constexpr size_t blake2s::block_size;
+
+blake2s::blake2s() noexcept
+{
+  reset();
+}
+
+void blake2s::reset() noexcept
+{
+  for (size_t i = 0; i < 8; ++i) {
+    h_[i] = iv[i];
+  }
+  // Параметры: длина хеша, без ключа, fanout = depth = 1.
+  h_[0] ^= 0x01010000UL ^ static_cast<uint32_t>(digest_size);
+  t_[0] = t_[1] = 0;
+  buf_size_ = 0;
+}
+
+void blake2s::compress(const uint8_t *block, bool last) noexcept
+{
+  uint32_t m[16];
+  uint32_t v[16];
+
+  for (size_t i = 0; i < 16; ++i) {
+    m[i] = load32(block + i * sizeof(uint32_t));
+  }
+  for (size_t i = 0; i < 8; ++i) {
+    v[i] = h_[i];
+    v[i + 8] = iv[i];
+  }
+  v[12] ^= t_[0];
+  v[13] ^= t_[1];
+  if (last) {
+    v[14] = ~v[14];
+  }
+
+  for (size_t r = 0; r < 10; ++r) {
+    const uint8_t *s = sigma[r];
+    mix(v, 0, 4,  8, 12, m[s[ 0]], m[s[ 1]]);
+    mix(v, 1, 5,  9, 13, m[s[ 2]], m[s[ 3]]);
+    mix(v, 2, 6, 10, 14, m[s[ 4]], m[s[ 5]]);
+    mix(v, 3, 7, 11, 15, m[s[ 6]], m[s[ 7]]);
+    mix(v, 0, 5, 10, 15, m[s[ 8]], m[s[ 9]]);
+    mix(v, 1, 6, 11, 12, m[s[10]], m[s[11]]);
+    mix(v, 2, 7,  8, 13, m[s[12]], m[s[13]]);
+    mix(v, 3, 4,  9, 14, m[s[14]], m[s[15]]);
+  }
+
+  for (size_t i = 0; i < 8; ++i) {
+    h_[i] ^= v[i] ^ v[i + 8];
+  }
+}
+
+void blake2s::update(const void *data, size_t size) noexcept
+{
+  const uint8_t *p = static_cast<const uint8_t*>(data);
+  while (0 < size) {
+    // Последний блок должен обрабатываться в final(), поэтому заполненный буфер сжимается
+    // только тогда, когда известно, что за ним есть ещё данные.
+    if (block_size == buf_size_) {
+      t_[0] += static_cast<uint32_t>(block_size);
+      if (t_[0] < block_size) {
+        ++t_[1];
+      }
+      compress(buf_, false);
+      buf_size_ = 0;
+    }
+    const size_t chunk = ((block_size - buf_size_) < size) ? (block_size - buf_size_) : size;
+    std::memcpy(buf_ + buf_size_, p, chunk);
+    buf_size_ += chunk;
+    p += chunk;
+    size -= chunk;
+  }
+}
+
+void blake2s::final(uint8_t *digest) noexcept
+{
+  t_[0] += static_cast<uint32_t>(buf_size_);
+  if (t_[0] < buf_size_) {
+    ++t_[1];
+  }
+  std::memset(buf_ + buf_size_, 0, block_size - buf_size_);
+  compress(buf_, true);
+
+  for (size_t i = 0; i < 8; ++i) {
+    store32(digest + i * sizeof(uint32_t), h_[i]);
+  }
+}
+
+void blake2s::calc(const void *data, size_t size, uint8_t *digest) noexcept
+{
+  blake2s state;
+  state.update(data, size);
+  state.final(digest);
+}
+
+void blake2s::calc_batch(const void *const *data, const size_t *sizes, size_t count, uint8_t *digests)
+{
+  size_t pos = 0;
+#ifdef CSDB_BLAKE2S_AVX2
+  if ((count >= min_lanes) && has_avx2()) {
+    // Буферы одной группы должны быть близкого размера, иначе короткие простаивают.
+    ::std::vector<size_t> order(count);
+    ::std::iota(order.begin(), order.end(), 0);
+    ::std::stable_sort(order.begin(), order.end(), [sizes](size_t a, size_t b) {
+      return sizes[a] < sizes[b];
+    });
+
+    const uint8_t *group_data[lanes];
+    size_t group_sizes[lanes];
+    uint8_t *group_digests[lanes];
+    while (count - pos >= min_lanes) {
+      const size_t group = ::std::min(lanes, count - pos);
+      for (size_t l = 0; l < group; ++l) {
+        const size_t index = order[pos + l];
+        group_data[l] = static_cast<const uint8_t*>(data[index]);
+        group_sizes[l] = sizes[index];
+        group_digests[l] = digests + index * digest_size;
+      }
+      calc8x(group_data, group_sizes, group_digests, group);
+      pos += group;
+    }
+    for (; pos < count; ++pos) {
+      const size_t index = order[pos];
+      calc(data[index], sizes[index], digests + index * digest_size);
+    }
+    return;
+  }
+#endif
+
+  for (; pos < count; ++pos) {
+    calc(data[pos], sizes[pos], digests + pos * digest_size);
+  }
+}
+
+} // namespace priv
+} // namespace csdb
@@ -0,0 +1,71 @@
+/**
+  * @file blake2s.h
+  *
+  * Потоковая (инкрементальная) реализация BLAKE2s-256 (RFC 7693) без ключа.
+  * Результат совпадает с cscrypto::blake2s, но данные можно подавать частями по мере
+  * их формирования.
+  */
+
+#pragma once
+#ifndef _CREDITS_CSDB_PRIVATE_BLAKE2S_H_INCLUDED_
+#define _CREDITS_CSDB_PRIVATE_BLAKE2S_H_INCLUDED_
+
+#include <cstddef>
+#include <cinttypes>
+
+namespace csdb {
+namespace priv {
+
+class blake2s
+{
+public:
+  static constexpr size_t digest_size = 32;
+  static constexpr size_t block_size = 64;
+
+public:
+  blake2s() noexcept;
+
+  /// Возвращает объект в начальное состояние.
+  void reset() noexcept;
+
+  /// Добавляет очередную порцию данных.
+  void update(const void *data, size_t size) noexcept;
+
+  /**
+   * @brief Завершает вычисление хеша.
+   * @param[out] digest Буфер размером не менее \ref digest_size байт.
+   *
+   * После вызова объект необходимо сбросить (\ref reset) перед повторным использованием.
+   */
+  void final(uint8_t *digest) noexcept;
+
+  /// Вычисление хеша буфера целиком.
+  static void calc(const void *data, size_t size, uint8_t *digest) noexcept;
+
+  /**
+   * @brief Вычисление хешей нескольких независимых буферов.
+   * @param[in]  data    Указатели на буферы.
+   * @param[in]  sizes   Размеры буферов.
+   * @param[in]  count   Количество буферов.
+   * @param[out] digests Буфер размером не менее count * \ref digest_size байт. Хеш i-го буфера
+   *                     записывается по смещению i * \ref digest_size.
+   *
+   * Результат совпадает с вызовом \ref calc для каждого буфера. Если процессор поддерживает AVX2,
+   * буферы близкого размера обрабатываются по восемь одновременно.
+   */
+  static void calc_batch(const void *const *data, const size_t *sizes, size_t count, uint8_t *digests);
+
+private:
+  void compress(const uint8_t *block, bool last) noexcept;
+
+private:
+  uint32_t h_[8];
+  uint32_t t_[2];
+  uint8_t buf_[block_size];
+  size_t buf_size_;
+};
+
+} // namespace priv
+} // namespace csdb
+
+#endif // _CREDITS_CSDB_PRIVATE_BLAKE2S_H_INCLUDED_
@@ -0,0 +1,215 @@
+#include "block_compression.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace csdb {
+namespace priv {
+
+namespace {
+
+/// Размер хеш-таблицы позиций (в битах).
+constexpr unsigned hash_bits = 14;
+
+/// После каждых 2^skip_shift промахов подряд шаг поиска увеличивается на единицу.
+constexpr unsigned skip_shift = 6;
+
+inline uint32_t read32(const uint8_t* p) noexcept
+{
+  uint32_t res;
+  memcpy(&res, p, sizeof(res));
+  return res;
+}
+
+inline uint32_t hash4(uint32_t value) noexcept
+{
+  return (value * 2654435761U) >> (32 - hash_bits);
+}
+
+void put_length(::csdb::internal::byte_array& out, size_t length)
+{
+  for (; length >= 0xFF; length -= 0xFF) {
+    out.push_back(0xFF);
+  }
+  out.push_back(static_cast<uint8_t>(length));
+}
+
+/// Последовательность "литералы + совпадение". Для последней последовательности match_length == 0.
+void put_sequence(::csdb::internal::byte_array& out, const uint8_t* literals, size_t literals_count,
+                  size_t match_length, size_t offset)
+{
+  const size_t match_code = (0 != match_length) ? (match_length - lz_min_match) : 0;
+  out.push_back(static_cast<uint8_t>((::std::min<size_t>(literals_count, 0x0F) << 4)
+                                     | ::std::min<size_t>(match_code, 0x0F)));
+  if (literals_count >= 0x0F) {
+    put_length(out, literals_count - 0x0F);
+  }
+  out.insert(out.end(), literals, literals + literals_count);
+
+  if (0 != match_length) {
+    out.push_back(static_cast<uint8_t>(offset));
+    out.push_back(static_cast<uint8_t>(offset >> 8));
+    if (match_code >= 0x0F) {
+      put_length(out, match_code - 0x0F);
+    }
+  }
+}
+
+bool get_length(const uint8_t*& in, const uint8_t* in_end, size_t& length)
+{
+  uint8_t value;
+  do {
+    if (in == in_end) {
+      return false;
+    }
+    value = *(in++);
+    length += value;
+  } while (0xFF == value);
+  return true;
+}
+
+} // namespace
+
+::csdb::internal::byte_array lz_compress(const void* data, size_t size,
+                                         const ::csdb::internal::byte_array& dictionary)
+{
+  // Словарь и данные рассматриваются как один непрерывный буфер.
+  const size_t dictionary_size = ::std::min<size_t>(dictionary.size(), lz_max_offset);
+  ::csdb::internal::byte_array buffer;
+  const uint8_t* base = static_cast<const uint8_t*>(data);
+  if (0 != dictionary_size) {
+    buffer.reserve(dictionary_size + size);
+    buffer.insert(buffer.end(), dictionary.end() - dictionary_size, dictionary.end());
+    buffer.insert(buffer.end(), base, base + size);
+    base = buffer.data();
+  }
+  const size_t end = dictionary_size + size;
+
+  ::csdb::internal::byte_array out;
+  out.reserve(size + size / 0xFF + 16);
+
+  // Позиция + 1 последней четвёрки байт с данным хешем, 0 - позиции нет.
+  ::std::vector<size_t> table(size_t(1) << hash_bits, 0);
+  for (size_t pos = 0; pos + lz_min_match <= dictionary_size; ++pos) {
+    table[hash4(read32(base + pos))] = pos + 1;
+  }
+
+  size_t anchor = dictionary_size;
+  size_t pos = dictionary_size;
+  size_t misses = 0;
+  while (pos + lz_min_match <= end) {
+    const uint32_t value = read32(base + pos);
+    size_t& entry = table[hash4(value)];
+    size_t candidate = entry;
+    entry = pos + 1;
+    if ((0 == candidate) || ((pos - (--candidate)) > lz_max_offset) || (read32(base + candidate) != value)) {
+      // Несжимаемые участки проходятся всё большими шагами.
+      pos += 1 + ((misses++) >> skip_shift);
+      continue;
+    }
+    misses = 0;
+
+    while ((pos > anchor) && (candidate > 0) && (base[pos - 1] == base[candidate - 1])) {
+      --pos;
+      --candidate;
+    }
+    size_t length = lz_min_match;
+    while ((pos + length < end) && (base[candidate + length] == base[pos + length])) {
+      ++length;
+    }
+
+    put_sequence(out, base + anchor, pos - anchor, length, pos - candidate);
+    pos += length;
+    anchor = pos;
+    if (pos + lz_min_match <= end + 2) {
+      table[hash4(read32(base + pos - 2))] = pos - 1;
+    }
+  }
+
+  put_sequence(out, base + anchor, end - anchor, 0, 0);
+  return out;
+}
+
+bool lz_decompress(const void* data, size_t size, size_t result_size,
+                   const ::csdb::internal::byte_array& dictionary, ::csdb::internal::byte_array& result)
+{
+  // Каждый байт сжатых данных даёт не больше нескольких сотен байт результата, поэтому
+  // заведомо неверный размер отбрасывается до выделения памяти.
+  if ((result_size / 0x200) > size) {
+    return false;
+  }
+
+  const size_t dictionary_size = ::std::min<size_t>(dictionary.size(), lz_max_offset);
+  ::csdb::internal::byte_array out(dictionary_size + result_size);
+  ::std::copy(dictionary.end() - dictionary_size, dictionary.end(), out.begin());
+
+  const uint8_t* in = static_cast<const uint8_t*>(data);
+  const uint8_t* in_end = in + size;
+  const size_t end = out.size();
+  size_t pos = dictionary_size;
+  for (;;) {
+    if (in == in_end) {
+      return false;
+    }
+    const uint8_t token = *(in++);
+
+    size_t literals_count = token >> 4;
+    if ((0x0F == literals_count) && (!get_length(in, in_end, literals_count))) {
+      return false;
+    }
+    if ((literals_count > static_cast<size_t>(in_end - in)) || (literals_count > end - pos)) {
+      return false;
+    }
+    if (0 != literals_count) {
+      memcpy(out.data() + pos, in, literals_count);
+    }
+    in += literals_count;
+    pos += literals_count;
+
+    if (in == in_end) {
+      break;
+    }
+
+    if ((in_end - in) < 2) {
+      return false;
+    }
+    const size_t offset = static_cast<size_t>(in[0]) | (static_cast<size_t>(in[1]) << 8);
+    in += 2;
+    size_t length = token & 0x0F;
+    if ((0x0F == length) && (!get_length(in, in_end, length))) {
+      return false;
+    }
+    length += lz_min_match;
+    if ((0 == offset) || (offset > pos) || (length > end - pos)) {
+      return false;
+    }
+
+    uint8_t* dst = out.data() + pos;
+    const uint8_t* src = dst - offset;
+    if (offset >= length) {
+      memcpy(dst, src, length);
+    } else {
+      // Перекрывающееся совпадение повторяет последние offset байт.
+      for (size_t i = 0; i < length; ++i) {
+        dst[i] = src[i];
+      }
+    }
+    pos += length;
+  }
+
+  if (pos != end) {
+    return false;
+  }
+
+  if (0 == dictionary_size) {
+    result = ::std::move(out);
+  } else {
+    result.assign(out.begin() + dictionary_size, out.end());
+  }
+  return true;
+}
+
+} // namespace priv
+} // namespace csdb
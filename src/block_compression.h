@@ -0,0 +1,63 @@
+/**
+  * @file block_compression.h
+  *
+  * Быстрое сжатие блоков данных (LZ77). Блок представляется последовательностями
+  * "литералы + совпадение" в том же виде, что и в формате блоков LZ4:
+  *
+  * - байт-токен: старшие 4 бита - количество литералов, младшие 4 бита - длина совпадения
+  *   минус \ref lz_min_match. Значение 15 означает, что длина продолжается следующими байтами,
+  *   каждый из которых добавляет к ней своё значение, пока не встретится байт меньше 255;
+  * - литералы;
+  * - смещение совпадения назад (2 байта, little-endian, не ноль).
+  *
+  * Последняя последовательность состоит только из литералов и не содержит смещения.
+  *
+  * Сжатие может использовать словарь - данные, которые считаются предшествующими блоку.
+  * Совпадения могут ссылаться на словарь так же, как на уже распакованные данные, поэтому
+  * для распаковки нужен тот же словарь.
+  */
+
+#pragma once
+#ifndef _CREDITS_CSDB_PRIVATE_BLOCK_COMPRESSION_H_INCLUDED_
+#define _CREDITS_CSDB_PRIVATE_BLOCK_COMPRESSION_H_INCLUDED_
+
+#include <cinttypes>
+#include <cstddef>
+
+#include "csdb/internal/types.h"
+
+namespace csdb {
+namespace priv {
+
+enum {
+  lz_min_match = 4,
+  lz_max_offset = 0xFFFF,
+};
+
+/**
+ * @brief Сжимает блок данных.
+ * @param[in] data        Данные для сжатия.
+ * @param[in] size        Размер данных.
+ * @param[in] dictionary  Словарь. Используются только последние \ref lz_max_offset байт.
+ * @return Сжатые данные. Их размер может превышать исходный размер для несжимаемых данных.
+ */
+::csdb::internal::byte_array lz_compress(const void* data, size_t size,
+                                         const ::csdb::internal::byte_array& dictionary
+                                           = ::csdb::internal::byte_array{});
+
+/**
+ * @brief Распаковывает блок данных.
+ * @param[in]  data       Сжатые данные.
+ * @param[in]  size       Размер сжатых данных.
+ * @param[in]  result_size Размер исходных данных.
+ * @param[in]  dictionary Словарь, использованный при сжатии.
+ * @param[out] result     Распакованные данные.
+ * @return false, если данные повреждены или их размер после распаковки отличается от result_size.
+ */
+bool lz_decompress(const void* data, size_t size, size_t result_size,
+                   const ::csdb::internal::byte_array& dictionary, ::csdb::internal::byte_array& result);
+
+} // namespace priv
+} // namespace csdb
+
+#endif // _CREDITS_CSDB_PRIVATE_BLOCK_COMPRESSION_H_INCLUDED_
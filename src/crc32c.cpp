@@ -0,0 +1,121 @@
+#include "crc32c.h"
+
+#include <cstring>
+
+// Аппаратное вычисление использует SSE4.2, если процессор его поддерживает.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CSDB_CRC32C_SSE42
+#define CSDB_CRC32C_SSE42_FUNCTION __attribute__((target("sse4.2")))
+#elif defined(__SSE4_2__)
+#define CSDB_CRC32C_SSE42
+#define CSDB_CRC32C_SSE42_FUNCTION
+#endif
+
+#ifdef CSDB_CRC32C_SSE42
+#include <nmmintrin.h>
+#endif
+
+namespace csdb {
+namespace priv {
+
+namespace {
+
+/// Отражённый полином CRC-32C.
+constexpr uint32_t polynomial = 0x82F63B78;
+
+/// Таблицы для обработки по восемь байт за шаг (slicing-by-8).
+struct tables_t
+{
+  uint32_t t[8][256];
+
+  tables_t() noexcept
+  {
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t crc = i;
+      for (int j = 0; j < 8; ++j) {
+        crc = (crc >> 1) ^ ((0 != (crc & 1)) ? polynomial : 0);
+      }
+      t[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; ++i) {
+      for (size_t k = 1; k < 8; ++k) {
+        t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+      }
+    }
+  }
+};
+
+uint32_t crc32c_tables(const uint8_t* p, size_t size, uint32_t crc) noexcept
+{
+  static const tables_t tables;
+  const auto& t = tables.t;
+
+  for (; size >= 8; size -= 8, p += 8) {
+    // Байты читаются по одному, поэтому порядок байт платформы не важен.
+    const uint32_t lo = crc ^ (static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8)
+                               | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24));
+    crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24]
+          ^ t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+  }
+  for (; size > 0; --size, ++p) {
+    crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xFF];
+  }
+  return crc;
+}
+
+#ifdef CSDB_CRC32C_SSE42
+
+bool has_sse42() noexcept
+{
+#ifdef __GNUC__
+  static const bool res = __builtin_cpu_supports("sse4.2");
+  return res;
+#else
+  return true;
+#endif
+}
+
+CSDB_CRC32C_SSE42_FUNCTION uint32_t crc32c_sse42(const uint8_t* p, size_t size, uint32_t crc) noexcept
+{
+#ifdef __x86_64__
+  uint64_t crc64 = crc;
+  for (; size >= 8; size -= 8, p += 8) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    crc64 = _mm_crc32_u64(crc64, value);
+  }
+  crc = static_cast<uint32_t>(crc64);
+#endif
+  for (; size >= 4; size -= 4, p += 4) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    crc = _mm_crc32_u32(crc, value);
+  }
+  for (; size > 0; --size, ++p) {
+    crc = _mm_crc32_u8(crc, *p);
+  }
+  return crc;
+}
+
+#endif // CSDB_CRC32C_SSE42
+
+} // namespace
+
+uint32_t crc32c(const void* data, size_t size, uint32_t crc) noexcept
+{
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+#ifdef CSDB_CRC32C_SSE42
+  if (has_sse42()) {
+    return ~crc32c_sse42(p, size, ~crc);
+  }
+#endif
+  return ~crc32c_tables(p, size, ~crc);
+}
+
+uint32_t crc32c_table(const void* data, size_t size, uint32_t crc) noexcept
+{
+  return ~crc32c_tables(static_cast<const uint8_t*>(data), size, ~crc);
+}
+
+} // namespace priv
+} // namespace csdb
@@ -0,0 +1,36 @@
+/**
+  * @file crc32c.h
+  *
+  * Контрольная сумма CRC-32C (полином Кастаньоли, RFC 3720). Используется для быстрой
+  * проверки целостности записей хранилища; для защиты от намеренного изменения данных
+  * она не предназначена.
+  */
+
+#pragma once
+#ifndef _CREDITS_CSDB_PRIVATE_CRC32C_H_INCLUDED_
+#define _CREDITS_CSDB_PRIVATE_CRC32C_H_INCLUDED_
+
+#include <cinttypes>
+#include <cstddef>
+
+namespace csdb {
+namespace priv {
+
+/**
+ * @brief Вычисляет CRC-32C.
+ * @param[in] data Данные.
+ * @param[in] size Размер данных.
+ * @param[in] crc  Контрольная сумма предыдущих частей данных (0 для первой части).
+ * @return Контрольная сумма данных, включая предыдущие части.
+ *
+ * Если процессор поддерживает SSE4.2, используется инструкция crc32, иначе - таблицы.
+ */
+uint32_t crc32c(const void* data, size_t size, uint32_t crc = 0) noexcept;
+
+/// Табличная реализация \ref crc32c, используемая на процессорах без SSE4.2.
+uint32_t crc32c_table(const void* data, size_t size, uint32_t crc = 0) noexcept;
+
+} // namespace priv
+} // namespace csdb
+
+#endif // _CREDITS_CSDB_PRIVATE_CRC32C_H_INCLUDED_
@@ -1,6 +1,7 @@
 #include "csdb/currency.h"
 #include "csdb/internal/shared_data_ptr_implementation.h"
 #include "binary_streams.h"
+#include "serialization_schema.h"
 
 namespace csdb {
 
@@ -8,6 +9,8 @@ class Currency::priv : public ::csdb::internal::shared_data
 {
 public:
   std::string name;
+
+  typedef ::csdb::priv::schema<priv, CSDB_SCHEMA_FIELD(priv, name)> serialization_schema;
 };
 SHARED_DATA_CLASS_IMPLEMENTATION(Currency)
 
@@ -44,12 +47,27 @@ bool Currency::operator <(const Currency &other) const noexcept
 
 void Currency::put(::csdb::priv::obstream &os) const
 {
-  os.put(d->name);
+  priv::serialization_schema::put(os, *d.constData());
 }
 
 bool Currency::get(::csdb::priv::ibstream &is)
 {
-  return is.get(d->name);
+  return priv::serialization_schema::get(is, *d.data());
+}
+
+void Currency::get(::csdb::priv::unchecked_ibstream &is)
+{
+  priv::serialization_schema::get(is, *d.data());
+}
+
+size_t Currency::serialized_size() const noexcept
+{
+  return priv::serialization_schema::serialized_size(*d.constData());
 }
 
 } // namespace csdb
+
+size_t std::hash<::csdb::Currency>::operator()(const ::csdb::Currency &value) const noexcept
+{
+  return std::hash<std::string>()(value.d->name);
+}
@@ -21,12 +21,28 @@ Database::Iterator::~Iterator()
 {
 }
 
+Database::IteratorPtr Database::new_scan_iterator()
+{
+  return new_iterator();
+}
+
+Database::Error Database::last_error() const
+{
+  std::lock_guard<std::mutex> lock(error_mutex_);
+  return last_error_;
+}
+
 std::string Database::last_error_message() const
 {
-  if (!last_error_message_.empty()) {
-    return last_error_message_;
+  Error error;
+  {
+    std::lock_guard<std::mutex> lock(error_mutex_);
+    if (!last_error_message_.empty()) {
+      return last_error_message_;
+    }
+    error = last_error_;
   }
-  switch (last_error_) {
+  switch (error) {
   case NoError: return "No error";
   case NotFound: return "Database is not found";
   case Corruption: return "Database is corrupted";
@@ -40,26 +56,29 @@ std::string Database::last_error_message() const
 
 void Database::set_last_error(Error error, const std::string& message)
 {
+  std::lock_guard<std::mutex> lock(error_mutex_);
   last_error_ = error;
   last_error_message_ = message;
 }
 
 void Database::set_last_error(Error error, const char* message, ...)
 {
-  last_error_ = error;
+  std::string text;
   if (nullptr != message) {
     va_list args1;
     va_start(args1, message);
     va_list args2;
     va_copy(args2, args1);
-    last_error_message_.resize(std::vsnprintf(NULL, 0, message, args1) + 1);
+    text.resize(std::vsnprintf(NULL, 0, message, args1) + 1);
     va_end(args1);
-    std::vsnprintf(&(last_error_message_[0]), last_error_message_.size(), message, args2);
+    std::vsnprintf(&(text[0]), text.size(), message, args2);
     va_end(args2);
-    last_error_message_.resize(last_error_message_.size() - 1);
-  } else {
-    last_error_message_.clear();
+    text.resize(text.size() - 1);
   }
+
+  std::lock_guard<std::mutex> lock(error_mutex_);
+  last_error_ = error;
+  last_error_message_ = std::move(text);
 }
 
 } // namespace csdb
@@ -228,4 +228,18 @@ DatabaseLevelDB::IteratorPtr DatabaseLevelDB::new_iterator()
   return Database::IteratorPtr(new DatabaseLevelDB::Iterator(db_->NewIterator(::leveldb::ReadOptions())));
 }
 
+DatabaseLevelDB::IteratorPtr DatabaseLevelDB::new_scan_iterator()
+{
+  if (!db_) {
+    set_last_error(NotOpen);
+    return nullptr;
+  }
+
+  // Просматриваемые блоки не попадают в кеш, но их контрольные суммы проверяются.
+  ::leveldb::ReadOptions options;
+  options.fill_cache = false;
+  options.verify_checksums = true;
+  return Database::IteratorPtr(new DatabaseLevelDB::Iterator(db_->NewIterator(options)));
+}
+
 } // namespace csdb
@@ -1,12 +1,117 @@
 #include "integral_encdec.h"
 
-#include <cstring>
-
-#include "csdb/internal/endian.h"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define CSDB_INTEGRAL_ENCDEC_SSE2
+#endif
 
 namespace csdb {
 namespace priv {
 
+namespace {
+
+/// Количество младших нулевых бит. Значение не должно быть нулевым.
+inline unsigned count_trailing_zeros64(uint64_t value)
+{
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward64(&index, value);
+  return static_cast<unsigned>(index);
+#else
+  return static_cast<unsigned>(__builtin_ctzll(value));
+#endif
+}
+
+#if defined(__AVX2__)
+enum { SCAN_WINDOW = 32 };
+
+/// Битовая маска байт окна, младший бит которых установлен (начала многобайтовых значений).
+inline uint64_t multibyte_mask(const uint8_t *d)
+{
+  const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(d));
+  // Сдвиг 16-битных слов на 7 переносит младший бит каждого байта в его старший бит.
+  return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_slli_epi16(v, 7)));
+}
+#elif defined(CSDB_INTEGRAL_ENCDEC_SSE2)
+enum { SCAN_WINDOW = 16 };
+
+inline uint64_t multibyte_mask(const uint8_t *d)
+{
+  const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(d));
+  return static_cast<uint32_t>(_mm_movemask_epi8(_mm_slli_epi16(v, 7)));
+}
+#else
+enum { SCAN_WINDOW = 8 };
+
+inline uint64_t multibyte_mask(const uint8_t *d)
+{
+  // Младший бит i-го байта оказывается в бите 8 * i, поэтому номер первого многобайтового
+  // значения получается делением на 8.
+  return _load_le64(d) & 0x0101010101010101ULL;
+}
+#endif
+
+/// Номер первого байта окна, с которого начинается многобайтовое значение (или размер окна).
+inline std::size_t single_byte_run(const uint8_t *d)
+{
+#if defined(__AVX2__) || defined(CSDB_INTEGRAL_ENCDEC_SSE2)
+  return count_trailing_zeros64(multibyte_mask(d) | (static_cast<uint64_t>(1) << SCAN_WINDOW));
+#else
+  const uint64_t mask = multibyte_mask(d);
+  return (0 == mask) ? SCAN_WINDOW : (count_trailing_zeros64(mask) / 8);
+#endif
+}
+
+template<bool checked>
+std::size_t decode_batch_impl(const void *buf, std::size_t size, uint64_t *values,
+                              std::size_t count)
+{
+  const uint8_t *begin = static_cast<const uint8_t*>(buf);
+  const uint8_t *pos = begin;
+  const uint8_t *end = begin + size;
+  uint64_t *out = values;
+  uint64_t *out_end = values + count;
+
+  while (out != out_end) {
+    // Однобайтовые значения (младший бит первого байта равен нулю) декодируются блоком.
+    // Если очередное значение многобайтовое, сканирование блока ничего не даст.
+    if ((static_cast<std::size_t>(end - pos) >= SCAN_WINDOW) && (0 == (pos[0] & 1))) {
+      std::size_t run = single_byte_run(pos);
+      if (run > static_cast<std::size_t>(out_end - out)) {
+        run = static_cast<std::size_t>(out_end - out);
+      }
+      for (std::size_t i = 0; i < run; ++i) {
+        // Семь бит значения со знаком.
+        const uint64_t value = static_cast<uint64_t>(pos[i] >> 1);
+        out[i] = (value ^ 0x40) - 0x40;
+      }
+      pos += run;
+      out += run;
+      if (out == out_end) {
+        break;
+      }
+    }
+
+    std::size_t res;
+    if (checked) {
+      res = decode(pos, static_cast<std::size_t>(end - pos), *out);
+      if (0 == res) {
+        return 0;
+      }
+    } else {
+      res = decode_unchecked(pos, static_cast<std::size_t>(end - pos), *out);
+    }
+    pos += res;
+    ++out;
+  }
+
+  return static_cast<std::size_t>(pos - begin);
+}
+
+} // namespace
+
 template<>
 std::size_t encode(void *buf, bool value)
 {
@@ -17,29 +122,21 @@ std::size_t encode(void *buf, bool value)
 template<>
 std::size_t encode(void *buf, uint64_t value)
 {
-  value = ::csdb::internal::to_little_endian(value);
-  uint8_t bits = (sizeof(uint64_t) * 8);
-  uint64_t mask = (static_cast<uint64_t>(1) << (bits - 1));
-  bool new_bit = (0 != (mask & value)), bit;
-  do {
-    bit = new_bit;
-    mask >>= 1;
-    new_bit = (0 != (mask & value));
-  } while ((bit == new_bit) && (7 < (--bits)));
-
-  uint8_t bytes = 8;
-  uint8_t first = '\xFF';
-  if (57 > bits) {
-    bytes = ((bits - 1) / 7);
-    first = static_cast<char>((value << (bytes + 1)) | ((1 << bytes) - 1));
-    value >>= (7 - bytes);
-  }
+  // Формат: в младших битах первого байта записано количество дополнительных байт
+  // (в виде последовательности единиц, завершённой нулём), за ними - значение. Если
+  // дополнительных байт меньше 8, всё закодированное значение помещается в одно 64-битное
+  // слово, которое записывается целиком (буфер гарантированно имеет размер не менее
+  // MAX_INTEGRAL_ENCODED_SIZE, лишние байты перезаписываются следующими данными).
+  const std::size_t extra = _encoded_extra_bytes(value);
   uint8_t *buffer = static_cast<uint8_t*>(buf);
-  *(buffer++) = first;
-  if (0 < bytes) {
-    memcpy(buffer, &value, bytes);
+  if (8 > extra) {
+    const uint64_t ones = (static_cast<uint64_t>(1) << extra) - 1;
+    _store_le64(buffer, (value << (extra + 1)) | ones);
+  } else {
+    buffer[0] = '\xFF';
+    _store_le64(buffer + 1, value);
   }
-  return bytes + sizeof(uint8_t);
+  return extra + sizeof(uint8_t);
 }
 
 template<>
@@ -58,27 +155,22 @@ std::size_t decode(const void *buf, std::size_t size, uint64_t& value)
   if (sizeof(uint8_t) > size) {
     return 0;
   }
-  const char* d = static_cast<const char*>(buf);
-  uint8_t first = static_cast<uint8_t>(*d);
-  uint8_t bytes = 0;
-  for (uint8_t mask = first; 0 != (mask & 0x1); ++bytes, mask >>= 1) {}
-  if ((bytes + 1) > size) {
+  const std::size_t total = _decoded_extra_bytes(*static_cast<const uint8_t*>(buf)) + 1;
+  if (total > size) {
     return 0;
   }
+  return decode_unchecked(buf, size, value);
+}
 
-  uint64_t val = 0;
-  if (bytes > 0) {
-    memcpy(&val, d + 1, bytes);
-  }
-  if (8 > bytes) {
-    val <<= (7 - bytes);
-    val |= (first >> (bytes + 1));
-    if (0 != (d[bytes] & 0x80)) {
-      val |= static_cast<uint64_t>(-1) << ((bytes + 1) * 7);
-    }
-  }
-  value = ::csdb::internal::from_little_endian(val);
-  return bytes + 1;
+std::size_t decode_batch(const void *buf, std::size_t size, uint64_t *values, std::size_t count)
+{
+  return decode_batch_impl<true>(buf, size, values, count);
+}
+
+std::size_t decode_batch_unchecked(const void *buf, std::size_t size, uint64_t *values,
+                                   std::size_t count)
+{
+  return decode_batch_impl<false>(buf, size, values, count);
 }
 
 } // namespace priv
@@ -11,14 +11,46 @@
 #define _CREDITS_CSDB_PRIVATE_INTEGRAL_ENCDEC_H_INCLUDED_
 
 #include <cinttypes>
+#include <cstddef>
+#include <cstring>
 #include <type_traits>
 
+#include "csdb/internal/endian.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 namespace csdb {
 namespace priv {
 enum {
   MAX_INTEGRAL_ENCODED_SIZE = sizeof(uint64_t) + 1,
 };
 
+/// Количество старших нулевых бит. Значение не должно быть нулевым.
+inline unsigned _count_leading_zeros(uint64_t value)
+{
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanReverse64(&index, value);
+  return 63 - static_cast<unsigned>(index);
+#else
+  return static_cast<unsigned>(__builtin_clzll(value));
+#endif
+}
+
+/// Количество младших нулевых бит. Значение не должно быть нулевым.
+inline unsigned _count_trailing_zeros(uint32_t value)
+{
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, value);
+  return static_cast<unsigned>(index);
+#else
+  return static_cast<unsigned>(__builtin_ctz(value));
+#endif
+}
+
 /**
  * @brief Компактное кодирование переменной целочисленного типа.
  * @param[out]  buf   Буфер, в которые поместить закодированное значени. Буфер должен
@@ -58,6 +90,155 @@ decode(const void *buf, std::size_t size, T& value)
   return res;
 }
 
+/**
+ * @brief Размер закодированного значения.
+ * @param[in]   value Значение, для которого нужно определить размер.
+ * @return  Количество байт, которое запишет \ref encode для того же значения.
+ */
+template<typename T>
+typename std::enable_if<(std::is_integral<T>::value || std::is_enum<T>::value)
+                        && (sizeof(T) <= sizeof(uint64_t)), std::size_t>::type
+encoded_size(T value)
+{
+  return encoded_size<uint64_t>(static_cast<uint64_t>(value));
+}
+
+template<>
+inline std::size_t encoded_size(bool)
+{
+  return sizeof(uint8_t);
+}
+
+/**
+ * @brief Количество дополнительных байт (после первого) в закодированном значении.
+ *
+ * Значение кодируется как знаковое: старшие биты, совпадающие со знаковым, не хранятся.
+ * Первый байт вмещает 7 бит значения (со знаком), каждый следующий - ещё 7 бит, а всё,
+ * что не помещается в 8 байт, записывается полными 9-ю байтами.
+ */
+inline std::size_t _encoded_extra_bytes(uint64_t value)
+{
+  // Инвертируем отрицательные значения, чтобы знаковые биты стали нулями. Младший бит
+  // добавлен, чтобы не передавать 0 в _count_leading_zeros (на результат он не влияет).
+  const uint64_t significant = (value ^ (0 - (value >> 63))) | 1;
+  // Число значащих бит с учётом знакового, от 2 до 64.
+  const std::size_t bits = 65 - _count_leading_zeros(significant);
+  const std::size_t extra = (bits - 1) / 7;
+  return (extra < 8) ? extra : 8;
+}
+
+template<>
+inline std::size_t encoded_size(uint64_t value)
+{
+  return _encoded_extra_bytes(value) + 1;
+}
+
+/// Количество дополнительных байт по первому байту закодированного значения.
+inline std::size_t _decoded_extra_bytes(uint8_t first)
+{
+  // Количество единиц в младших битах первого байта; для 0xFF - 8.
+  return _count_trailing_zeros(~static_cast<uint32_t>(first) | 0x100);
+}
+
+inline uint64_t _load_le64(const void *buf)
+{
+  uint64_t value;
+  std::memcpy(&value, buf, sizeof(value));
+  return ::csdb::internal::from_little_endian(value);
+}
+
+inline void _store_le64(void *buf, uint64_t value)
+{
+  value = ::csdb::internal::to_little_endian(value);
+  std::memcpy(buf, &value, sizeof(value));
+}
+
+/**
+ * @brief Декодирование целочисленного типа из заведомо корректных данных.
+ * @param[in]   buf   Буфер, в котором лежат данные для декодирования. Данные должны быть
+ *                    предварительно проверены: закодированное значение целиком находится
+ *                    в буфере.
+ * @param[in]   size  Количество байт, доступных для чтения начиная с \ref buf. Используется
+ *                    только для выбора способа чтения.
+ * @param[out]  value Переменная, куда поместить результат декодирования.
+ * @return  Количество байт, прочитанных из \ref buf.
+ *
+ * В отличие от \ref decode не проверяет размер данных.
+ */
+template<typename T>
+typename std::enable_if<(std::is_integral<T>::value || std::is_enum<T>::value)
+                         && (sizeof(T) <= sizeof(uint64_t)), std::size_t>::type
+decode_unchecked(const void *buf, std::size_t size, T& value)
+{
+  uint64_t v;
+  const std::size_t res = decode_unchecked<uint64_t>(buf, size, v);
+  value = static_cast<T>(v);
+  return res;
+}
+
+template<>
+inline std::size_t decode_unchecked(const void *buf, std::size_t, bool& value)
+{
+  value = ('\0' != (*static_cast<const uint8_t*>(buf)));
+  return sizeof(uint8_t);
+}
+
+template<>
+inline std::size_t decode_unchecked(const void *buf, std::size_t size, uint64_t& value)
+{
+  const uint8_t *d = static_cast<const uint8_t*>(buf);
+  const std::size_t extra = _decoded_extra_bytes(d[0]);
+  const std::size_t total = extra + 1;
+
+  if (8 == extra) {
+    value = _load_le64(d + 1);
+    return total;
+  }
+
+  uint64_t raw;
+  if (sizeof(uint64_t) <= size) {
+    raw = _load_le64(d);
+  } else {
+    uint8_t tmp[sizeof(uint64_t)] = {0};
+    std::memcpy(tmp, d, total);
+    raw = _load_le64(tmp);
+  }
+
+  // Значение занимает 7 * total бит (не более 56) вслед за префиксом длины.
+  const std::size_t bits = 7 * total;
+  const uint64_t mask = (static_cast<uint64_t>(1) << bits) - 1;
+  const uint64_t sign = static_cast<uint64_t>(1) << (bits - 1);
+  const uint64_t val = (raw >> total) & mask;
+  value = (val ^ sign) - sign;
+  return total;
+}
+
+/**
+ * @brief Декодирование последовательности целых значений, записанных подряд.
+ * @param[in]   buf     Буфер, в котором лежат данные для декодирования.
+ * @param[in]   size    Размер данных в буфере.
+ * @param[out]  values  Массив, куда поместить результаты декодирования. Должен вмещать
+ *                      не менее \ref count элементов.
+ * @param[in]   count   Количество значений, которые нужно декодировать. Должно быть больше 0.
+ * @return  Количество байт, прочитанных из \ref buf. 0, если данные содержат ошибку или
+ *          их недостаточно для декодирования всех \ref count значений.
+ *
+ * Результат совпадает с \ref count последовательными вызовами \ref decode, но серии
+ * однобайтовых значений (наиболее частый случай для количеств, типов и сумм) распознаются
+ * сразу блоком из 8, 16 или 32 байт в зависимости от доступного набора инструкций
+ * (SWAR, SSE2, AVX2).
+ */
+std::size_t decode_batch(const void *buf, std::size_t size, uint64_t *values, std::size_t count);
+
+/**
+ * @brief Декодирование последовательности целых значений из заведомо корректных данных.
+ *
+ * Аналог \ref decode_batch для данных, структура которых уже проверена (см.
+ * \ref decode_unchecked). Возвращает количество прочитанных байт.
+ */
+std::size_t decode_batch_unchecked(const void *buf, std::size_t size, uint64_t *values,
+                                   std::size_t count);
+
 template<>
 std::size_t encode(void *buf, bool value);
 
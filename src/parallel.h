@@ -0,0 +1,65 @@
+/**
+  * @file parallel.h
+  *
+  * Разбиение работы над последовательностью элементов между несколькими потоками.
+  */
+
+#pragma once
+#ifndef _CREDITS_CSDB_PRIVATE_PARALLEL_H_INCLUDED_
+#define _CREDITS_CSDB_PRIVATE_PARALLEL_H_INCLUDED_
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace csdb {
+namespace priv {
+
+/**
+ * @brief Количество потоков для обработки count элементов.
+ * @param[in] count     Количество элементов.
+ * @param[in] threads   Запрошенное количество потоков; 0 - по числу ядер процессора.
+ * @param[in] min_chunk Минимальное количество элементов на поток.
+ * @return Количество потоков от 1 до threads, при котором на каждый приходится не меньше
+ *         min_chunk элементов.
+ */
+inline size_t parallel_threads(size_t count, size_t threads, size_t min_chunk)
+{
+  if (0 == threads) {
+    threads = ::std::max<size_t>(::std::thread::hardware_concurrency(), 1);
+  }
+  return ::std::max<size_t>(::std::min(threads, count / ::std::max<size_t>(min_chunk, 1)), 1);
+}
+
+/// Границы части номер chunk при делении count элементов на chunks непрерывных частей.
+inline size_t parallel_chunk_begin(size_t count, size_t chunks, size_t chunk)
+{
+  return count / chunks * chunk + ::std::min(chunk, count % chunks);
+}
+
+/**
+ * @brief Вызывает fn(chunk, begin, end) для каждой из chunks непрерывных частей [0, count).
+ *
+ * Первая часть обрабатывается вызывающим потоком, остальные - отдельными потоками.
+ * Функция возвращает управление после обработки всех частей.
+ */
+template<typename F>
+void parallel_for(size_t count, size_t chunks, F fn)
+{
+  ::std::vector<::std::thread> workers;
+  workers.reserve(chunks - 1);
+  for (size_t chunk = 1; chunk < chunks; ++chunk) {
+    workers.emplace_back(fn, chunk, parallel_chunk_begin(count, chunks, chunk),
+                         parallel_chunk_begin(count, chunks, chunk + 1));
+  }
+  fn(size_t(0), size_t(0), parallel_chunk_begin(count, chunks, 1));
+  for (auto& it : workers) {
+    it.join();
+  }
+}
+
+} // namespace priv
+} // namespace csdb
+
+#endif // _CREDITS_CSDB_PRIVATE_PARALLEL_H_INCLUDED_
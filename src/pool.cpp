@@ -2,23 +2,29 @@
 
 #include <sstream>
 #include <iomanip>
-#include <map>
 #include <algorithm>
+#include <cstring>
 
 #include "csdb/csdb.h"
 
 #include "csdb/internal/shared_data_ptr_implementation.h"
 #include "csdb/internal/utils.h"
+#include "csdb/internal/fixed_byte_array.h"
 #include "binary_streams.h"
+#include "serialization_schema.h"
 #include "priv_crypto.h"
+#include "pool_scan.h"
 #include "transaction_p.h"
+#include "pool_p.h"
 
 namespace csdb {
 
 class PoolHash::priv : public ::csdb::internal::shared_data
 {
 public:
-  internal::byte_array value;
+  internal::fixed_byte_array<::csdb::priv::crypto::max_hash_size> value;
+
+  typedef ::csdb::priv::schema<priv, CSDB_SCHEMA_FIELD(priv, value)> serialization_schema;
 };
 SHARED_DATA_CLASS_IMPLEMENTATION(PoolHash)
 
@@ -34,12 +40,12 @@ size_t PoolHash::size()  const noexcept
 
 std::string PoolHash::to_string() const noexcept
 {
-  return internal::to_hex(d->value);
+  return internal::to_hex(d->value.begin(), d->value.end());
 }
 
 ::csdb::internal::byte_array PoolHash::to_binary() const noexcept
 {
-  return d->value;
+  return d->value.to_byte_array();
 }
 
 PoolHash PoolHash::from_binary(const ::csdb::internal::byte_array& data)
@@ -49,7 +55,7 @@ PoolHash PoolHash::from_binary(const ::csdb::internal::byte_array& data)
   if ((0 == sz)
       || (::csdb::priv::crypto::hash_size == sz)
       ) {
-    res.d->value = data;
+    res.d->value.assign(data);
   }
   return res;
 }
@@ -72,7 +78,7 @@ PoolHash PoolHash::from_string(const ::std::string& str)
   if ((0 == sz)
       || (::csdb::priv::crypto::hash_size == sz)
       ) {
-    res.d->value = hash;
+    res.d->value.assign(hash);
   }
   return res;
 }
@@ -80,136 +86,30 @@ PoolHash PoolHash::from_string(const ::std::string& str)
 PoolHash PoolHash::calc_from_data(const internal::byte_array &data)
 {
   PoolHash res;
-  res.d->value = ::csdb::priv::crypto::calc_hash(data);
+  res.d->value.assign(::csdb::priv::crypto::calc_hash(data));
   return res;
 }
 
 void PoolHash::put(::csdb::priv::obstream &os) const
 {
-  os.put(d->value);
+  priv::serialization_schema::put(os, *d.constData());
 }
 
 bool PoolHash::get(::csdb::priv::ibstream &is)
 {
-  return is.get(d->value);
+  return priv::serialization_schema::get(is, *d.data());
 }
 
-class Pool::priv : public ::csdb::internal::shared_data
+void PoolHash::get(::csdb::priv::unchecked_ibstream &is)
 {
-  priv() : is_valid_(false), read_only_(false), sequence_(0) {}
-  priv(PoolHash previous_hash, Pool::sequence_t sequence, ::csdb::Storage::WeakPtr storage) :
-    is_valid_(true),
-    read_only_(false),
-    previous_hash_(previous_hash),
-    sequence_(sequence),
-    storage_(storage)
-  {}
-
-  void put(::csdb::priv::obstream& os) const
-  {
-    os.put(previous_hash_);
-    os.put(sequence_);
-
-    os.put(transactions_.size());
-    for(const auto& it : transactions_) {
-      os.put(it);
-    }
-
-    os.put(user_fields_);
-  }
-
-  bool get_meta(::csdb::priv::ibstream& is, size_t& cnt) {
-	  if (!is.get(previous_hash_)) {
-		  return false;
-	  }
-
-	  if (!is.get(sequence_))
-		  return false;
-
-	  if (!is.get(cnt)) {
-		  return false;
-	  }
-
-	  return true;
-  }
-
-  bool get(::csdb::priv::ibstream& is)
-  {
-	size_t cnt;
-	if (!get_meta(is, cnt))
-		return false;
-
-    transactions_.clear();
-    transactions_.reserve(cnt);
-    for(size_t i = 0; i < cnt; ++i )
-    {
-      Transaction tran;
-      if(!is.get(tran))
-        return false;
-      transactions_.emplace_back(tran);
-    }
-
-    if(!is.get(user_fields_)) {
-      return false;
-    }
-
-    is_valid_ = true;
-    return true;
-  }
-
-  void compose()
-  {
-    if (!is_valid_) {
-      binary_representation_.clear();
-      hash_ = PoolHash();
-      return;
-    }
-
-    /*if (!binary_representation_.empty()) {
-      return;
-    }*/
-
-    ::csdb::priv::obstream os;
-    put(os);
-    binary_representation_ = os.buffer();
-
-    update_transactions();
-  }
-
-  void update_transactions()
-  {
-    read_only_ = true;
-    hash_ = PoolHash::calc_from_data(binary_representation_);
-    for (size_t idx = 0; idx < transactions_.size(); ++idx) {
-      transactions_[idx].d->_update_id(hash_, idx);
-    }
-  }
-
-  Storage get_storage(Storage candidate)
-  {
-    if (candidate.isOpen()) {
-      return candidate;
-    }
-
-    candidate = Storage(storage_);
-    if (candidate.isOpen()) {
-      return candidate;
-    }
+  priv::serialization_schema::get(is, *d.data());
+}
 
-    return ::csdb::defaultStorage();
-  }
+size_t PoolHash::serialized_size() const noexcept
+{
+  return priv::serialization_schema::serialized_size(*d.constData());
+}
 
-  bool is_valid_;
-  bool read_only_;
-  PoolHash hash_;
-  PoolHash previous_hash_;
-  Pool::sequence_t sequence_;
-  std::vector<Transaction> transactions_;
-  ::std::map<::csdb::user_field_id_t, ::csdb::UserField> user_fields_;
-  ::csdb::internal::byte_array binary_representation_;
-  ::csdb::Storage::WeakPtr storage_;
-  friend class Pool;
-};
 SHARED_DATA_CLASS_IMPLEMENTATION(Pool)
 
 Pool::Pool(PoolHash previous_hash, sequence_t sequence, Storage storage) :
@@ -232,6 +132,18 @@ PoolHash Pool::hash() const noexcept
   return d->hash_;
 }
 
+bool Pool::verify_hash() const
+{
+  const priv* data = d.constData();
+  if (!data->read_only_) {
+    return false;
+  }
+  const size_t size = ::csdb::priv::pool_hashed_size(data->binary_representation_.data(),
+                                                     data->binary_representation_.size());
+  return data->hash_ == PoolHash::from_binary(
+        ::csdb::priv::crypto::calc_hash(data->binary_representation_.data(), size));
+}
+
 PoolHash Pool::previous_hash() const noexcept
 {
   return d->previous_hash_;
@@ -266,6 +178,13 @@ Transaction Pool::get_last_by_source(Address source) const noexcept
     return Transaction{};
   }
 
+  if (data->is_indexed())
+  {
+    const priv::address_entry* entry = data->find_indexed(source);
+    return ((nullptr != entry) && (priv::npos != entry->last_source))
+           ? data->transactions_[entry->last_source] : Transaction{};
+  }
+
   auto it_rend = data->transactions_.rend();
   for (auto it = data->transactions_.rbegin(); it != it_rend; ++it)
   {
@@ -289,6 +208,13 @@ Transaction Pool::get_last_by_target(Address target) const noexcept
     return Transaction{};
   }
 
+  if (data->is_indexed())
+  {
+    const priv::address_entry* entry = data->find_indexed(target);
+    return ((nullptr != entry) && (priv::npos != entry->last_target))
+           ? data->transactions_[entry->last_target] : Transaction{};
+  }
+
   auto it_rend = data->transactions_.rend();
   for (auto it = data->transactions_.rbegin(); it != it_rend; ++it)
   {
@@ -303,7 +229,47 @@ Transaction Pool::get_last_by_target(Address target) const noexcept
   return Transaction{};
 }
 
-bool Pool::add_transaction(Transaction transaction
+std::vector<size_t> Pool::find_by_address(const Address& address) const
+{
+  const auto data = d.constData();
+  if (data->is_indexed()) {
+    const priv::address_entry* entry = data->find_indexed(address);
+    return (nullptr != entry) ? entry->transactions : std::vector<size_t>{};
+  }
+
+  std::vector<size_t> res;
+  for (size_t i = 0; i < data->transactions_.size(); ++i) {
+    const Transaction::priv* t = data->transactions_[i].d.constData();
+    if ((t->source_ == address) || (t->target_ == address)) {
+      res.push_back(i);
+    }
+  }
+  return res;
+}
+
+Amount Pool::debit(const Address& source, const Currency& currency) const
+{
+  const auto data = d.constData();
+  if (data->is_indexed()) {
+    const priv::address_entry* entry = data->find_indexed(source);
+    if (nullptr == entry) {
+      return 0_c;
+    }
+    const auto it = entry->debits.find(currency);
+    return (it != entry->debits.end()) ? it->second : 0_c;
+  }
+
+  Amount res = 0_c;
+  for (const auto& it : data->transactions_) {
+    const Transaction::priv* t = it.d.constData();
+    if ((t->source_ == source) && (t->currency_ == currency)) {
+      res += t->amount_;
+    }
+  }
+  return res;
+}
+
+bool Pool::add_transaction(const Transaction &transaction
 #ifdef CSDB_UNIT_TEST
                      , bool skip_check
 #endif
@@ -320,15 +286,98 @@ bool Pool::add_transaction(Transaction transaction
 #ifdef CSDB_UNIT_TEST
   if (!skip_check) {
 #endif
-  /// \todo Add transaction checking.
+  // Транзакции пула проверяются при формировании, см. Pool::compose(PoolValidator&, ...).
 #ifdef CSDB_UNIT_TEST
   }
 #endif
 
-  d->transactions_.push_back(Transaction(new Transaction::priv(*(transaction.d.constData()))));
+  priv* data = d.data();
+  data->transactions_.push_back(Transaction(new Transaction::priv(*(transaction.d.constData()))));
+  data->index_last_transaction();
   return true;
 }
 
+bool Pool::add_transaction(Transaction &&transaction
+#ifdef CSDB_UNIT_TEST
+                     , bool skip_check
+#endif
+                     )
+{
+  // Данные транзакции разделяются с кем-то ещё - забирать их нельзя.
+  if (1 != transaction.d.constData()->ref) {
+    return add_transaction(static_cast<const Transaction&>(transaction)
+#ifdef CSDB_UNIT_TEST
+                           , skip_check
+#endif
+                           );
+  }
+
+  if(d.constData()->read_only_) {
+    return false;
+  }
+
+  if (!transaction.is_valid()) {
+    return false;
+  }
+
+#ifdef CSDB_UNIT_TEST
+  if (!skip_check) {
+#endif
+  // Транзакции пула проверяются при формировании, см. Pool::compose(PoolValidator&, ...).
+#ifdef CSDB_UNIT_TEST
+  }
+#endif
+
+  // Транзакция могла быть получена из другого (сформированного) пула. Как и при
+  // копировании, сбрасываем её идентификатор.
+  Transaction::priv* tdata = transaction.d.data();
+  if (tdata->read_only_) {
+    tdata->read_only_ = false;
+    tdata->id_ = TransactionID();
+  }
+
+  priv* data = d.data();
+  data->transactions_.push_back(::std::move(transaction));
+  data->index_last_transaction();
+  return true;
+}
+
+size_t Pool::add_transactions(std::vector<Transaction> &&transactions
+#ifdef CSDB_UNIT_TEST
+                              , bool skip_check
+#endif
+                              )
+{
+  if(d.constData()->read_only_) {
+    transactions.clear();
+    return 0;
+  }
+
+  reserve(d.constData()->transactions_.size() + transactions.size());
+
+  size_t res = 0;
+  for (auto& it : transactions) {
+    if (add_transaction(::std::move(it)
+#ifdef CSDB_UNIT_TEST
+                        , skip_check
+#endif
+                        )) {
+      ++res;
+    }
+  }
+  transactions.clear();
+  return res;
+}
+
+void Pool::reserve(size_t count)
+{
+  if (d.constData()->read_only_) {
+    return;
+  }
+
+  d->transactions_.reserve(count);
+}
+
 size_t Pool::transactions_count() const noexcept
 {
   return d->transactions_.size();
@@ -339,6 +388,20 @@ Pool::sequence_t Pool::sequence() const noexcept
   return d->sequence_;
 }
 
+Pool::Format Pool::format() const noexcept
+{
+  return d->format_;
+}
+
+void Pool::set_format(Pool::Format format) noexcept
+{
+  if (d.constData()->read_only_ || (!::csdb::priv::is_known_pool_format(format))) {
+    return;
+  }
+
+  d->format_ = format;
+}
+
 void Pool::set_sequence(Pool::sequence_t seq) noexcept
 {
   if (d.constData()->read_only_) {
@@ -371,7 +434,9 @@ void Pool::set_storage(Storage storage) noexcept
 
 std::vector<csdb::Transaction>& Pool::transactions()
 {
-	return d->transactions_;
+  priv* data = d.data();
+  data->drop_index();
+  return data->transactions_;
 }
 
   bool Pool::add_user_field(user_field_id_t id, UserField field) noexcept
@@ -382,7 +447,7 @@ std::vector<csdb::Transaction>& Pool::transactions()
 
   priv* data = d.data();
   data->is_valid_ = true;
-  data->user_fields_[id] = field;
+  data->user_fields_.insert_or_assign(id, field);
 
   return true;
 }
@@ -396,12 +461,14 @@ UserField Pool::user_field(user_field_id_t id) const noexcept
 
 ::std::set<user_field_id_t> Pool::user_field_ids() const noexcept
 {
-  ::std::set<user_field_id_t> res;
+  const UserFieldIdRange ids = user_field_id_range();
+  return ::std::set<user_field_id_t>(ids.begin(), ids.end());
+}
+
+UserFieldIdRange Pool::user_field_id_range() const noexcept
+{
   const priv* data = d.constData();
-  for (const auto& it : data->user_fields_) {
-    res.insert(it.first);
-  }
-  return res;
+  return UserFieldIdRange(data->user_fields_.begin(), data->user_fields_.end());
 }
 
 bool Pool::compose()
@@ -418,15 +485,125 @@ bool Pool::compose()
   return true;
 }
 
+bool Pool::compose(size_t threads)
+{
+  if (d.constData()->read_only_) {
+    return true;
+  }
+
+  if (!d.constData()->is_valid_) {
+    return false;
+  }
+
+  d->compose(threads);
+  return true;
+}
+
 ::csdb::internal::byte_array Pool::to_binary() const noexcept
 {
   return d->binary_representation_;
 }
 
+::csdb::internal::byte_array Pool::merkle_root() const
+{
+  const priv* data = d.constData();
+  size_t cnt;
+  size_t header_size;
+  ::csdb::internal::byte_array res;
+  if ((!data->read_only_) || (MerkleFormat != data->format_)
+      || (!::csdb::priv::get_merkle_header(data->binary_representation_.data(),
+                                           data->binary_representation_.size(), cnt, res, header_size))) {
+    return ::csdb::internal::byte_array{};
+  }
+  return res;
+}
+
+Pool::InclusionProof Pool::inclusion_proof(TransactionID id) const
+{
+  const priv* data = d.constData();
+  InclusionProof res;
+  if ((!data->read_only_) || (MerkleFormat != data->format_)
+      || (!id.is_valid()) || (id.pool_hash() != data->hash_)
+      || (data->transactions_.size() <= id.d->index_)) {
+    return res;
+  }
+
+  // Бинарное представление уже проверено при формировании или чтении пула.
+  const ::csdb::internal::byte_array& binary = data->binary_representation_;
+  ::csdb::priv::ibstream is(binary);
+  Format format;
+  size_t cnt;
+  ::csdb::priv::get_pool_format(is, format);
+  ::csdb::priv::scan_merkle_header(is, cnt);
+  const size_t header_size = binary.size() - is.size();
+  const void* body = is.data();
+
+  const size_t index = static_cast<size_t>(id.d->index_);
+  ::std::vector<size_t> sizes(cnt);
+  size_t offset = header_size;
+  for (size_t i = 0; i < cnt; ++i) {
+    const size_t size = is.size();
+    ::csdb::priv::scan_transaction(is);
+    sizes[i] = size - is.size();
+    if (i < index) {
+      offset += sizes[i];
+    }
+  }
+
+  res.header.assign(binary.begin(), binary.begin() + header_size);
+  res.transaction.assign(binary.begin() + offset, binary.begin() + offset + sizes[index]);
+  res.path = ::csdb::priv::merkle_path(::csdb::priv::merkle_leaves(body, sizes), index);
+  return res;
+}
+
+Transaction Pool::verify_inclusion_proof(TransactionID id, const InclusionProof& proof)
+{
+  size_t cnt;
+  size_t header_size;
+  ::csdb::internal::byte_array root;
+  if ((!id.is_valid())
+      || (!::csdb::priv::get_merkle_header(proof.header.data(), proof.header.size(), cnt, root, header_size))
+      || (proof.header.size() != header_size) || root.empty()
+      || (PoolHash::calc_from_data(proof.header) != id.pool_hash())
+      || (::csdb::priv::merkle_root_from_path(proof.transaction, static_cast<size_t>(id.d->index_), cnt,
+                                              proof.path) != root)) {
+    return Transaction{};
+  }
+
+  Transaction res = Transaction::from_binary(proof.transaction);
+  if (!res.is_valid()) {
+    return Transaction{};
+  }
+  res.d->_update_id(id.pool_hash(), id.d->index_);
+  return res;
+}
+
+Pool Pool::from_byte_stream(::csdb::internal::byte_array&& data)
+{
+	size_t cnt;
+	if (!::csdb::priv::scan_pool(data.data(), data.size(), cnt)) {
+		return Pool();
+	}
+	priv *p = new priv();
+	::csdb::priv::unchecked_ibstream is(data.data(), data.size());
+	if (!p->get(is)) {
+		delete p;
+		return Pool();
+	}
+	p->binary_representation_ = ::std::move(data);
+	p->update_transactions();
+	return Pool(p);
+}
+
 Pool Pool::from_binary(const ::csdb::internal::byte_array& data)
 {
+	// Структура проверяется один раз, после чего поля читаются без проверок.
+	size_t cnt;
+	if (!::csdb::priv::scan_pool(data.data(), data.size(), cnt)) {
+		return Pool();
+	}
 	priv *p = new priv();
-	::csdb::priv::ibstream is(data.data(), data.size());
+	::csdb::priv::unchecked_ibstream is(data.data(), data.size());
 	if (!p->get(is)) {
 		delete p;
 		return Pool();
@@ -436,6 +613,23 @@ Pool Pool::from_binary(const ::csdb::internal::byte_array& data)
 	return Pool(p);
 }
 
+Pool Pool::from_binary(::csdb::internal::byte_array data, const PoolHash& hash)
+{
+	size_t cnt;
+	if (hash.is_empty() || !::csdb::priv::scan_pool(data.data(), data.size(), cnt)) {
+		return Pool();
+	}
+	priv *p = new priv();
+	::csdb::priv::unchecked_ibstream is(data.data(), data.size());
+	if (!p->get(is)) {
+		delete p;
+		return Pool();
+	}
+	p->binary_representation_ = ::std::move(data);
+	p->update_transactions(hash);
+	return Pool(p);
+}
+
 Pool Pool::meta_from_binary(const ::csdb::internal::byte_array& data, size_t& cnt)
 {
 	priv *p = new priv();
@@ -451,9 +645,13 @@ Pool Pool::meta_from_binary(const ::csdb::internal::byte_array& data, size_t& cn
 }
 
   Pool Pool::from_byte_stream(const char* data, size_t size) {
-    priv *p = new priv();
-    ::csdb::priv::ibstream is(data, size);
+    size_t cnt;
+    if (!::csdb::priv::scan_pool(data, size, cnt)) {
+      return Pool();
+    }
 
+    priv *p = new priv();
+    ::csdb::priv::unchecked_ibstream is(data, size);
     if (!p->get(is)) {
       delete p;
       return Pool();
@@ -464,15 +662,55 @@ Pool Pool::meta_from_binary(const ::csdb::internal::byte_array& data, size_t& cn
 
   char* Pool::to_byte_stream(size_t& size) {
 	  if (d->binary_representation_.empty()) {
-		  ::csdb::priv::obstream os;
-		  d->put(os);
-		  d->binary_representation_ = std::move(const_cast<std::vector<uint8_t>&>(os.buffer()));
+		  d->binary_representation_ = d->serialize();
 	  }
 
 	  size = d->binary_representation_.size();
 	  return (char*)(d->binary_representation_.data());
   }
 
+const ::csdb::internal::byte_array& Pool::byte_stream()
+{
+  if (d.constData()->binary_representation_.empty()) {
+    d->binary_representation_ = d->serialize();
+  }
+  return d.constData()->binary_representation_;
+}
+
+size_t Pool::byte_stream_size()
+{
+  return byte_stream().size();
+}
+
+size_t Pool::to_byte_stream(void* buffer, size_t size)
+{
+  const ByteStreamBuffer buffers[] = {{buffer, size}};
+  return to_byte_stream(buffers, 1);
+}
+
+size_t Pool::to_byte_stream(const ByteStreamBuffer* buffers, size_t count)
+{
+  const ::csdb::internal::byte_array& data = byte_stream();
+
+  size_t capacity = 0;
+  for (size_t i = 0; (i < count) && (capacity < data.size()); ++i) {
+    capacity += buffers[i].size;
+  }
+  if (capacity < data.size()) {
+    return 0;
+  }
+
+  size_t pos = 0;
+  for (size_t i = 0; pos < data.size(); ++i) {
+    const size_t size = ::std::min(buffers[i].size, data.size() - pos);
+    if (0 != size) {
+      memcpy(buffers[i].data, data.data() + pos, size);
+    }
+    pos += size;
+  }
+  return pos;
+}
+
   bool Pool::save(Storage storage)
 {
   if ((!d.constData()->is_valid_) || ((!d.constData()->read_only_))) {
@@ -508,9 +746,15 @@ Pool Pool::load(PoolHash hash, Storage storage)
   bool Pool::clear() noexcept
   {
     d->transactions_.clear();
+    d->clear_index();
 
     if (!d->transactions_.empty())
       return false;
     return true;
   }
 } // namespace csdb
+
+size_t std::hash<::csdb::PoolHash>::operator()(const ::csdb::PoolHash &value) const noexcept
+{
+  return value.d->value.hash();
+}
@@ -0,0 +1,169 @@
+#include "csdb/pool_builder.h"
+
+#include <utility>
+
+#include "csdb/internal/shared_data_ptr_implementation.h"
+#include "binary_streams.h"
+#include "priv_crypto.h"
+#include "pool_p.h"
+
+namespace csdb {
+
+class PoolBuilder::priv : public ::csdb::internal::shared_data
+{
+  priv() :
+    expected_count_(0),
+    body_offset_(0),
+    hashed_size_(0)
+  {}
+
+  priv(PoolHash previous_hash, Pool::sequence_t sequence, size_t expected_count, Storage storage) :
+    pool_(previous_hash, sequence, storage),
+    expected_count_(expected_count),
+    body_offset_(0),
+    hashed_size_(0)
+  {
+    pool_.d->put_meta(os_, expected_count_);
+    body_offset_ = os_.buffer().size();
+    feed();
+  }
+
+  /// Передаёт в вычислитель хеша ещё не обработанные байты бинарного представления.
+  void feed()
+  {
+    const ::csdb::internal::byte_array& buffer = os_.buffer();
+    hasher_.update(buffer.data() + hashed_size_, buffer.size() - hashed_size_);
+    hashed_size_ = buffer.size();
+  }
+
+  /// Сериализует последнюю добавленную транзакцию.
+  void append_last()
+  {
+    const Pool::priv* pool = pool_.d.constData();
+    os_.put(pool->transactions_.back());
+    // При превышении заявленного количества хеш всё равно будет вычислен заново.
+    if (pool->transactions_.size() <= expected_count_) {
+      feed();
+    }
+  }
+
+  Pool pool_;
+  ::csdb::priv::obstream os_;
+  ::csdb::priv::crypto::hasher hasher_;
+  size_t expected_count_;
+  size_t body_offset_;
+  size_t hashed_size_;
+  friend class PoolBuilder;
+};
+SHARED_DATA_CLASS_IMPLEMENTATION(PoolBuilder)
+
+PoolBuilder::PoolBuilder(PoolHash previous_hash, Pool::sequence_t sequence, size_t expected_transactions_count,
+                         Storage storage) :
+  d(new priv(previous_hash, sequence, expected_transactions_count, storage))
+{
+}
+
+bool PoolBuilder::is_valid() const noexcept
+{
+  return d->pool_.is_valid();
+}
+
+size_t PoolBuilder::transactions_count() const noexcept
+{
+  return d->pool_.transactions_count();
+}
+
+size_t PoolBuilder::expected_transactions_count() const noexcept
+{
+  return d->expected_count_;
+}
+
+bool PoolBuilder::add_transaction(const Transaction &transaction
+#ifdef CSDB_UNIT_TEST
+                                  , bool skip_check
+#endif
+                                  )
+{
+  if (!is_valid()) {
+    return false;
+  }
+
+  priv* data = d.data();
+  if (!data->pool_.add_transaction(transaction
+#ifdef CSDB_UNIT_TEST
+                                   , skip_check
+#endif
+                                   )) {
+    return false;
+  }
+
+  data->append_last();
+  return true;
+}
+
+bool PoolBuilder::add_transaction(Transaction &&transaction
+#ifdef CSDB_UNIT_TEST
+                                  , bool skip_check
+#endif
+                                  )
+{
+  if (!is_valid()) {
+    return false;
+  }
+
+  priv* data = d.data();
+  if (!data->pool_.add_transaction(::std::move(transaction)
+#ifdef CSDB_UNIT_TEST
+                                   , skip_check
+#endif
+                                   )) {
+    return false;
+  }
+
+  data->append_last();
+  return true;
+}
+
+bool PoolBuilder::add_user_field(user_field_id_t id, UserField field) noexcept
+{
+  if (!is_valid()) {
+    return false;
+  }
+
+  return d->pool_.add_user_field(id, field);
+}
+
+Pool PoolBuilder::compose()
+{
+  if (!is_valid()) {
+    return Pool();
+  }
+
+  priv* data = d.data();
+  Pool::priv* pool = data->pool_.d.data();
+  ::csdb::internal::byte_array& buffer = data->os_.buffer();
+
+  PoolHash hash;
+  if (pool->transactions_.size() == data->expected_count_) {
+    data->os_.put(pool->user_fields_);
+    data->feed();
+    hash = PoolHash::from_binary(data->hasher_.finalize());
+    pool->binary_representation_ = ::std::move(buffer);
+  } else {
+    ::csdb::priv::obstream os;
+    os.reserve(buffer.size() + ::csdb::priv::MAX_INTEGRAL_ENCODED_SIZE
+               + ::csdb::priv::obstream::serialized_size(pool->user_fields_));
+    pool->put_meta(os, pool->transactions_.size());
+    os.put(buffer.data() + data->body_offset_, buffer.size() - data->body_offset_);
+    os.put(pool->user_fields_);
+    pool->binary_representation_ = ::std::move(os.buffer());
+    hash = PoolHash::calc_from_data(pool->binary_representation_);
+  }
+  pool->update_transactions(hash);
+
+  Pool res(data->pool_);
+  *this = PoolBuilder();
+  return res;
+}
+
+} // namespace csdb
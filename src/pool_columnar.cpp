@@ -0,0 +1,315 @@
+#include "pool_columnar.h"
+
+#include <algorithm>
+
+#include "csdb/address.h"
+#include "csdb/currency.h"
+
+#include "pool_format.h"
+#include "pool_p.h"
+#include "pool_tables.h"
+#include "transaction_p.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define CSDB_POOL_COLUMNAR_SSE2
+#endif
+
+namespace csdb {
+namespace priv {
+
+namespace {
+
+#if defined(CSDB_POOL_COLUMNAR_SSE2)
+enum { MATCH_WINDOW = 16 };
+
+/// Номер value, размноженный по всем элементам окна.
+inline __m128i match_pattern(size_t value, uint8_t width)
+{
+  switch (width) {
+  case 1:
+    return _mm_set1_epi8(static_cast<char>(value));
+  case 2:
+    return _mm_set1_epi16(static_cast<short>(value));
+  default:
+    return _mm_set1_epi32(static_cast<int>(value));
+  }
+}
+
+/**
+ * Маска совпадений в окне из MATCH_WINDOW байт: для каждого совпавшего элемента
+ * устанавливается бит, соответствующий его первому байту.
+ */
+inline uint32_t match_mask(const uint8_t* d, __m128i pattern, uint8_t width)
+{
+  const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(d));
+  switch (width) {
+  case 1:
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, pattern)));
+  case 2:
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi16(v, pattern))) & 0x5555;
+  default:
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi32(v, pattern))) & 0x1111;
+  }
+}
+
+inline unsigned count_trailing_zeros32(uint32_t value)
+{
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, value);
+  return static_cast<unsigned>(index);
+#else
+  return static_cast<unsigned>(__builtin_ctz(value));
+#endif
+}
+
+inline unsigned highest_bit32(uint32_t value)
+{
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanReverse(&index, value);
+  return static_cast<unsigned>(index);
+#else
+  return 31 - static_cast<unsigned>(__builtin_clz(value));
+#endif
+}
+#endif
+
+} // namespace
+
+bool check_column_indices(const uint8_t* column, size_t count, uint8_t width, size_t limit) noexcept
+{
+  size_t max = 0;
+  for (size_t i = 0; i < count; ++i) {
+    max = ::std::max(max, get_column_index(column, i, width));
+  }
+  return (0 == count) || (max < limit);
+}
+
+void find_column_index(const uint8_t* column, size_t count, uint8_t width, size_t value,
+                       ::std::vector<size_t>& matches)
+{
+  size_t i = 0;
+#if defined(CSDB_POOL_COLUMNAR_SSE2)
+  const size_t per_window = MATCH_WINDOW / width;
+  const __m128i pattern = match_pattern(value, width);
+  for (; i + per_window <= count; i += per_window) {
+    uint32_t mask = match_mask(column + i * width, pattern, width);
+    while (0 != mask) {
+      matches.push_back(i + count_trailing_zeros32(mask) / width);
+      mask &= mask - 1;
+    }
+  }
+#endif
+  for (; i < count; ++i) {
+    if (get_column_index(column, i, width) == value) {
+      matches.push_back(i);
+    }
+  }
+}
+
+size_t find_last_column_index(const uint8_t* column, size_t count, uint8_t width, size_t value) noexcept
+{
+  size_t i = count;
+#if defined(CSDB_POOL_COLUMNAR_SSE2)
+  const size_t per_window = MATCH_WINDOW / width;
+  // Окна выравниваются от начала столбца, хвост проверяется поэлементно.
+  const size_t windows_end = count - count % per_window;
+  for (; i > windows_end; --i) {
+    if (get_column_index(column, i - 1, width) == value) {
+      return i - 1;
+    }
+  }
+  const __m128i pattern = match_pattern(value, width);
+  for (; i > 0; i -= per_window) {
+    const uint32_t mask = match_mask(column + (i - per_window) * width, pattern, width);
+    if (0 != mask) {
+      return i - per_window + highest_bit32(mask) / width;
+    }
+  }
+#else
+  for (; i > 0; --i) {
+    if (get_column_index(column, i - 1, width) == value) {
+      return i - 1;
+    }
+  }
+#endif
+  return count;
+}
+
+} // namespace priv
+
+namespace {
+
+/// Выделяет из потока столбец заданного размера.
+inline bool get_column(::csdb::priv::ibstream& is, size_t size, ::csdb::priv::ibstream& column)
+{
+  column = ::csdb::priv::ibstream(is.data(), size);
+  return is.skip(size);
+}
+
+} // namespace
+
+void Pool::priv::put_columnar(::csdb::priv::obstream& os) const
+{
+  using ::csdb::priv::obstream;
+  using ::csdb::priv::columnar_layout;
+
+  // Номера отправителей, затем получателей, затем валют - в порядке записи столбцов.
+  const size_t count = transactions_.size();
+  ::csdb::priv::value_table<Address> addresses(count);
+  ::csdb::priv::value_table<Currency> currencies(1);
+  ::std::vector<size_t> indices(3 * count);
+  columnar_layout layout;
+  for (size_t i = 0; i < count; ++i) {
+    const Transaction::priv* t = transactions_[i].d.constData();
+    indices[i] = addresses.index(t->source_);
+    indices[count + i] = addresses.index(t->target_);
+    indices[2 * count + i] = currencies.index(t->currency_);
+    layout.amounts_size += t->amount_.compact_serialized_size();
+    layout.balances_size += t->balance_.compact_serialized_size();
+    layout.user_fields_size += obstream::serialized_size(t->user_fields_);
+  }
+  layout.index_width = columnar_layout::index_width_for(::std::max(addresses.size(), currencies.size()));
+
+  os.reserve(2 * ::csdb::priv::MAX_INTEGRAL_ENCODED_SIZE
+             + obstream::serialized_size(previous_hash_)
+             + obstream::serialized_size(sequence_)
+             + addresses.serialized_size()
+             + currencies.serialized_size()
+             + obstream::serialized_size(count)
+             + columnar_layout::serialization_schema::max_size
+             + 3 * layout.index_column_size(count)
+             + layout.amounts_size + layout.balances_size + layout.user_fields_size
+             + obstream::serialized_size(user_fields_));
+
+  ::csdb::priv::put_pool_format(os, Pool::ColumnarFormat);
+  os.put(previous_hash_);
+  os.put(sequence_);
+  addresses.put(os);
+  currencies.put(os);
+  os.put(count);
+  layout.put(os);
+
+  ::csdb::internal::byte_array& buffer = os.buffer();
+  size_t pos = buffer.size();
+  buffer.resize(pos + 3 * layout.index_column_size(count));
+  for (size_t index : indices) {
+    ::csdb::priv::put_column_index(buffer.data() + pos, index, layout.index_width);
+    pos += layout.index_width;
+  }
+
+  for (const auto& it : transactions_) {
+    it.d.constData()->amount_.put_compact(os);
+  }
+  for (const auto& it : transactions_) {
+    it.d.constData()->balance_.put_compact(os);
+  }
+  for (const auto& it : transactions_) {
+    os.put(it.d.constData()->user_fields_);
+  }
+  os.put(user_fields_);
+}
+
+bool Pool::priv::get_columnar(::csdb::priv::ibstream& is)
+{
+  using ::csdb::priv::get_column_index;
+
+  ::std::vector<Address> addresses;
+  ::std::vector<Currency> currencies;
+  size_t cnt;
+  ::csdb::priv::columnar_layout layout;
+  if (!is.get(previous_hash_) || !is.get(sequence_)
+      || !is.get(addresses) || !is.get(currencies)
+      || !is.get(cnt) || !layout.get(is, cnt)) {
+    return false;
+  }
+
+  const size_t column_size = layout.index_column_size(cnt);
+  const uint8_t* sources = static_cast<const uint8_t*>(is.data());
+  const uint8_t* targets = sources + column_size;
+  const uint8_t* currency_indices = targets + column_size;
+  ::csdb::priv::ibstream amounts(nullptr, 0);
+  ::csdb::priv::ibstream balances(nullptr, 0);
+  ::csdb::priv::ibstream user_fields(nullptr, 0);
+  if (!::csdb::priv::check_column_indices(sources, cnt, layout.index_width, addresses.size())
+      || !::csdb::priv::check_column_indices(targets, cnt, layout.index_width, addresses.size())
+      || !::csdb::priv::check_column_indices(currency_indices, cnt, layout.index_width, currencies.size())
+      || !is.skip(3 * column_size)
+      || !get_column(is, layout.amounts_size, amounts)
+      || !get_column(is, layout.balances_size, balances)
+      || !get_column(is, layout.user_fields_size, user_fields)) {
+    return false;
+  }
+
+  transactions_.clear();
+  transactions_.reserve(cnt);
+  for (size_t i = 0; i < cnt; ++i) {
+    Transaction tran;
+    Transaction::priv* t = tran.d.data();
+    t->source_ = addresses[get_column_index(sources, i, layout.index_width)];
+    t->target_ = addresses[get_column_index(targets, i, layout.index_width)];
+    t->currency_ = currencies[get_column_index(currency_indices, i, layout.index_width)];
+    if (!t->amount_.get_compact(amounts)) {
+      return false;
+    }
+    transactions_.push_back(::std::move(tran));
+  }
+  for (auto& it : transactions_) {
+    if (!it.d->balance_.get_compact(balances)) {
+      return false;
+    }
+  }
+  for (auto& it : transactions_) {
+    if (!user_fields.get(it.d->user_fields_)) {
+      return false;
+    }
+  }
+
+  return amounts.empty() && balances.empty() && user_fields.empty() && is.get(user_fields_);
+}
+
+void Pool::priv::get_columnar(::csdb::priv::unchecked_ibstream& is)
+{
+  using ::csdb::priv::get_column_index;
+
+  ::std::vector<Address> addresses;
+  ::std::vector<Currency> currencies;
+  size_t cnt;
+  ::csdb::priv::columnar_layout layout;
+  is.get(previous_hash_);
+  is.get(sequence_);
+  is.get(addresses);
+  is.get(currencies);
+  is.get(cnt);
+  layout.get(is);
+
+  const size_t column_size = layout.index_column_size(cnt);
+  const uint8_t* sources = static_cast<const uint8_t*>(is.data());
+  const uint8_t* targets = sources + column_size;
+  const uint8_t* currency_indices = targets + column_size;
+  is.skip(3 * column_size);
+
+  transactions_.clear();
+  transactions_.reserve(cnt);
+  for (size_t i = 0; i < cnt; ++i) {
+    Transaction tran;
+    Transaction::priv* t = tran.d.data();
+    t->source_ = addresses[get_column_index(sources, i, layout.index_width)];
+    t->target_ = addresses[get_column_index(targets, i, layout.index_width)];
+    t->currency_ = currencies[get_column_index(currency_indices, i, layout.index_width)];
+    t->amount_.get_compact(is);
+    transactions_.push_back(::std::move(tran));
+  }
+  for (auto& it : transactions_) {
+    it.d->balance_.get_compact(is);
+  }
+  for (auto& it : transactions_) {
+    is.get(it.d->user_fields_);
+  }
+
+  is.get(user_fields_);
+}
+
+} // namespace csdb
@@ -0,0 +1,121 @@
+/**
+  * @file pool_columnar.h
+  *
+  * Бинарное представление пула в формате \ref Pool::ColumnarFormat:
+  *
+  * - заголовок формата (\ref put_pool_format);
+  * - хеш предыдущего пула и номер пула;
+  * - таблицы адресов и валют (как в \ref Pool::DictionaryFormat);
+  * - количество транзакций;
+  * - заголовок столбцов (\ref columnar_layout);
+  * - столбцы номеров отправителей, получателей и валют. Номера имеют фиксированную ширину
+  *   (\ref columnar_layout::index_width) и записываются подряд в порядке little-endian;
+  * - столбцы сумм и остатков в компактном представлении (\ref Amount::put_compact) и столбец
+  *   дополнительных полей транзакций;
+  * - дополнительные поля пула.
+  *
+  * Размеры всех столбцов известны из заголовка, поэтому любой столбец можно прочитать, не
+  * декодируя остальные, а номера в столбцах номеров можно сравнивать блоками.
+  */
+
+#pragma once
+#ifndef _CREDITS_CSDB_PRIVATE_POOL_COLUMNAR_H_INCLUDED_
+#define _CREDITS_CSDB_PRIVATE_POOL_COLUMNAR_H_INCLUDED_
+
+#include <cinttypes>
+#include <vector>
+
+#include "binary_streams.h"
+#include "serialization_schema.h"
+
+namespace csdb {
+namespace priv {
+
+/// Заголовок столбцов пула.
+struct columnar_layout
+{
+  uint8_t index_width = 0;        ///< Ширина номера в столбцах номеров (1, 2 или 4 байта).
+  size_t amounts_size = 0;        ///< Размер столбца сумм в байтах.
+  size_t balances_size = 0;       ///< Размер столбца остатков в байтах.
+  size_t user_fields_size = 0;    ///< Размер столбца дополнительных полей в байтах.
+
+  typedef schema<columnar_layout,
+                 CSDB_SCHEMA_FIELD(columnar_layout, index_width),
+                 CSDB_SCHEMA_FIELD(columnar_layout, amounts_size),
+                 CSDB_SCHEMA_FIELD(columnar_layout, balances_size),
+                 CSDB_SCHEMA_FIELD(columnar_layout, user_fields_size)> serialization_schema;
+
+  /// Минимальная ширина номера для таблицы из table_size элементов.
+  static uint8_t index_width_for(size_t table_size) noexcept
+  {
+    return (table_size <= 0x100) ? 1 : ((table_size <= 0x10000) ? 2 : 4);
+  }
+
+  /// Размер столбца номеров для count транзакций.
+  size_t index_column_size(size_t count) const noexcept
+  {
+    return count * index_width;
+  }
+
+  void put(obstream& os) const
+  {
+    serialization_schema::put(os, *this);
+  }
+
+  /**
+   * @brief Читает заголовок столбцов пула из count транзакций.
+   * @return false, если ширина номеров недопустима или столбцы номеров не помещаются
+   *         в оставшиеся данные.
+   */
+  bool get(ibstream& is, size_t count)
+  {
+    return serialization_schema::get(is, *this)
+        && ((1 == index_width) || (2 == index_width) || (4 == index_width))
+        && (count <= is.size() / (3 * static_cast<size_t>(index_width)));
+  }
+
+  void get(unchecked_ibstream& is)
+  {
+    serialization_schema::get(is, *this);
+  }
+};
+
+/// Записывает номер value шириной width байт.
+inline void put_column_index(uint8_t* pos, size_t value, uint8_t width) noexcept
+{
+  for (uint8_t i = 0; i < width; ++i) {
+    pos[i] = static_cast<uint8_t>(value >> (i * 8));
+  }
+}
+
+/// Номер с индексом i из столбца номеров шириной width байт.
+inline size_t get_column_index(const uint8_t* column, size_t i, uint8_t width) noexcept
+{
+  const uint8_t* pos = column + i * width;
+  size_t res = 0;
+  for (uint8_t b = 0; b < width; ++b) {
+    res |= static_cast<size_t>(pos[b]) << (b * 8);
+  }
+  return res;
+}
+
+/// Проверяет, что все номера столбца меньше limit.
+bool check_column_indices(const uint8_t* column, size_t count, uint8_t width, size_t limit) noexcept;
+
+/**
+ * @brief Находит в столбце номеров все элементы, равные value.
+ * @param[out] matches  Индексы найденных элементов по возрастанию (добавляются в конец).
+ */
+void find_column_index(const uint8_t* column, size_t count, uint8_t width, size_t value,
+                       ::std::vector<size_t>& matches);
+
+/**
+ * @brief Находит в столбце номеров последний элемент, равный value.
+ * @return Индекс элемента или count, если элемент не найден.
+ */
+size_t find_last_column_index(const uint8_t* column, size_t count, uint8_t width, size_t value) noexcept;
+
+} // namespace priv
+} // namespace csdb
+
+#endif // _CREDITS_CSDB_PRIVATE_POOL_COLUMNAR_H_INCLUDED_
@@ -0,0 +1,357 @@
+#include "csdb/pool_columns.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include "csdb/csdb.h"
+#include "csdb/internal/shared_data_ptr_implementation.h"
+
+#include "binary_streams.h"
+#include "pool_columnar.h"
+#include "pool_format.h"
+#include "pool_p.h"
+#include "pool_scan.h"
+#include "pool_tables.h"
+
+namespace csdb {
+
+class PoolColumns::priv : public ::csdb::internal::shared_data
+{
+  priv() :
+    is_valid_(false),
+    format_(Pool::LegacyFormat),
+    sequence_(0),
+    count_(0),
+    columns_offset_(0),
+    amounts_offset_(0)
+  {}
+
+  /// Столбцы из данных в формате Pool::ColumnarFormat, прошедших проверку scan_pool.
+  void read_columnar(::csdb::internal::byte_array data)
+  {
+    data_ = ::std::move(data);
+    ::csdb::priv::unchecked_ibstream is(data_.data(), data_.size());
+    format_ = ::csdb::priv::get_pool_format(is);
+    is.get(previous_hash_);
+    is.get(sequence_);
+    is.get(addresses_);
+    is.get(currencies_);
+    is.get(count_);
+    layout_.get(is);
+    columns_offset_ = offset(is);
+    is.skip(3 * layout_.index_column_size(count_));
+    amounts_offset_ = offset(is);
+    is_valid_ = true;
+  }
+
+  /// Столбцы по транзакциям пула. Номера записываются так же, как в Pool::ColumnarFormat.
+  void build(const Pool& pool)
+  {
+    const Pool::priv* p = pool.d.constData();
+    format_ = p->format_;
+    previous_hash_ = p->previous_hash_;
+    sequence_ = p->sequence_;
+    count_ = p->transactions_.size();
+
+    ::csdb::priv::value_table<Address> addresses(count_);
+    ::csdb::priv::value_table<Currency> currencies(1);
+    ::std::vector<size_t> indices(3 * count_);
+    for (size_t i = 0; i < count_; ++i) {
+      const Transaction& t = p->transactions_[i];
+      indices[i] = addresses.index(t.source());
+      indices[count_ + i] = addresses.index(t.target());
+      indices[2 * count_ + i] = currencies.index(t.currency());
+    }
+    addresses_ = addresses.values();
+    currencies_ = currencies.values();
+
+    layout_.index_width = ::csdb::priv::columnar_layout::index_width_for(
+          ::std::max(addresses_.size(), currencies_.size()));
+    data_.resize(3 * layout_.index_column_size(count_));
+    uint8_t* pos = data_.data();
+    for (size_t index : indices) {
+      ::csdb::priv::put_column_index(pos, index, layout_.index_width);
+      pos += layout_.index_width;
+    }
+
+    pool_ = pool;
+    is_valid_ = true;
+  }
+
+  size_t offset(const ::csdb::priv::unchecked_ibstream& is) const noexcept
+  {
+    return static_cast<size_t>(static_cast<const uint8_t*>(is.data()) - data_.data());
+  }
+
+  /// Столбец номеров: 0 - отправители, 1 - получатели, 2 - валюты.
+  const uint8_t* column(size_t n) const noexcept
+  {
+    return data_.data() + columns_offset_ + n * layout_.index_column_size(count_);
+  }
+
+  size_t index(size_t column_number, size_t transaction) const noexcept
+  {
+    if (transaction >= count_) {
+      return PoolColumns::npos;
+    }
+    return ::csdb::priv::get_column_index(column(column_number), transaction, layout_.index_width);
+  }
+
+  /// Количество элементов таблицы, на которую ссылается столбец.
+  size_t table_size(size_t column_number) const noexcept
+  {
+    return (2 == column_number) ? currencies_.size() : addresses_.size();
+  }
+
+  ::std::vector<size_t> find(size_t column_number, size_t value) const
+  {
+    ::std::vector<size_t> res;
+    // Номер за пределами таблицы мог бы совпасть с номером в столбце после усечения до его ширины.
+    if (value < table_size(column_number)) {
+      ::csdb::priv::find_column_index(column(column_number), count_, layout_.index_width, value, res);
+    }
+    return res;
+  }
+
+  size_t find_last(size_t column_number, size_t value) const noexcept
+  {
+    if (value >= table_size(column_number)) {
+      return PoolColumns::npos;
+    }
+    const size_t res = ::csdb::priv::find_last_column_index(column(column_number), count_,
+                                                             layout_.index_width, value);
+    return (res < count_) ? res : PoolColumns::npos;
+  }
+
+  bool is_valid_;
+  Pool::Format format_;
+  PoolHash previous_hash_;
+  Pool::sequence_t sequence_;
+  size_t count_;
+  ::std::vector<Address> addresses_;
+  ::std::vector<Currency> currencies_;
+  ::csdb::priv::columnar_layout layout_;
+
+  /// Бинарное представление пула (Pool::ColumnarFormat) или построенные столбцы номеров.
+  ::csdb::internal::byte_array data_;
+  size_t columns_offset_;
+  size_t amounts_offset_;
+
+  /// Декодированный пул, если он уже есть.
+  Pool pool_;
+  /// Хеш пула, если он известен заранее (см. PoolColumns::from_binary).
+  PoolHash hash_;
+
+  friend class PoolColumns;
+};
+SHARED_DATA_CLASS_IMPLEMENTATION(PoolColumns)
+
+constexpr size_t PoolColumns::npos;
+
+PoolColumns::PoolColumns(const Pool& pool) :
+  d(new priv())
+{
+  if (!pool.is_valid()) {
+    return;
+  }
+
+  const Pool::priv* p = pool.d.constData();
+  if ((Pool::ColumnarFormat == p->format_) && p->read_only_ && (!p->binary_representation_.empty())) {
+    d->read_columnar(p->binary_representation_);
+    d->pool_ = pool;
+  } else {
+    d->build(pool);
+  }
+}
+
+PoolColumns PoolColumns::from_binary(const ::csdb::internal::byte_array& data)
+{
+  ::csdb::priv::ibstream is(data);
+  Pool::Format format;
+  if (!::csdb::priv::get_pool_format(is, format)) {
+    return PoolColumns();
+  }
+
+  if (Pool::ColumnarFormat != format) {
+    return PoolColumns(Pool::from_binary(data));
+  }
+
+  size_t cnt;
+  if (!::csdb::priv::scan_pool(data.data(), data.size(), cnt)) {
+    return PoolColumns();
+  }
+
+  priv* p = new priv();
+  p->read_columnar(data);
+  return PoolColumns(p);
+}
+
+PoolColumns PoolColumns::from_binary(::csdb::internal::byte_array data, const PoolHash& hash)
+{
+  ::csdb::priv::ibstream is(data);
+  Pool::Format format;
+  if (!::csdb::priv::get_pool_format(is, format)) {
+    return PoolColumns();
+  }
+
+  if (Pool::ColumnarFormat != format) {
+    return PoolColumns(Pool::from_binary(::std::move(data), hash));
+  }
+
+  size_t cnt;
+  if (!::csdb::priv::scan_pool(data.data(), data.size(), cnt)) {
+    return PoolColumns();
+  }
+
+  priv* p = new priv();
+  p->read_columnar(::std::move(data));
+  p->hash_ = hash;
+  return PoolColumns(p);
+}
+
+PoolColumns PoolColumns::load(PoolHash hash, Storage storage)
+{
+  if (!storage.isOpen()) {
+    storage = ::csdb::defaultStorage();
+  }
+
+  return storage.pool_load_columns(hash);
+}
+
+bool PoolColumns::is_valid() const noexcept
+{
+  return d->is_valid_;
+}
+
+Pool::Format PoolColumns::format() const noexcept
+{
+  return d->format_;
+}
+
+PoolHash PoolColumns::previous_hash() const noexcept
+{
+  return d->previous_hash_;
+}
+
+Pool::sequence_t PoolColumns::sequence() const noexcept
+{
+  return d->sequence_;
+}
+
+size_t PoolColumns::transactions_count() const noexcept
+{
+  return d->count_;
+}
+
+size_t PoolColumns::addresses_count() const noexcept
+{
+  return d->addresses_.size();
+}
+
+Address PoolColumns::address(size_t index) const noexcept
+{
+  return (index < d->addresses_.size()) ? d->addresses_[index] : Address{};
+}
+
+size_t PoolColumns::find_address(const Address& address) const noexcept
+{
+  const auto& addresses = d->addresses_;
+  const auto it = ::std::find(addresses.begin(), addresses.end(), address);
+  return (it != addresses.end()) ? static_cast<size_t>(it - addresses.begin()) : npos;
+}
+
+size_t PoolColumns::currencies_count() const noexcept
+{
+  return d->currencies_.size();
+}
+
+Currency PoolColumns::currency(size_t index) const noexcept
+{
+  return (index < d->currencies_.size()) ? d->currencies_[index] : Currency{};
+}
+
+size_t PoolColumns::source_index(size_t transaction) const noexcept
+{
+  return d->index(0, transaction);
+}
+
+size_t PoolColumns::target_index(size_t transaction) const noexcept
+{
+  return d->index(1, transaction);
+}
+
+size_t PoolColumns::currency_index(size_t transaction) const noexcept
+{
+  return d->index(2, transaction);
+}
+
+std::vector<size_t> PoolColumns::find_by_source(size_t address) const
+{
+  return d->find(0, address);
+}
+
+std::vector<size_t> PoolColumns::find_by_target(size_t address) const
+{
+  return d->find(1, address);
+}
+
+std::vector<size_t> PoolColumns::find_by_address(size_t address) const
+{
+  const std::vector<size_t> sources = d->find(0, address);
+  const std::vector<size_t> targets = d->find(1, address);
+  std::vector<size_t> res;
+  res.reserve(sources.size() + targets.size());
+  // Транзакция с одинаковыми отправителем и получателем попадает в результат один раз.
+  std::set_union(sources.begin(), sources.end(), targets.begin(), targets.end(), std::back_inserter(res));
+  return res;
+}
+
+size_t PoolColumns::find_last_by_source(size_t address) const noexcept
+{
+  return d->find_last(0, address);
+}
+
+size_t PoolColumns::find_last_by_target(size_t address) const noexcept
+{
+  return d->find_last(1, address);
+}
+
+std::vector<Amount> PoolColumns::amounts() const
+{
+  const priv* data = d.constData();
+  std::vector<Amount> res;
+  if (!data->is_valid_) {
+    return res;
+  }
+
+  res.reserve(data->count_);
+  if (data->pool_.is_valid()) {
+    for (const auto& it : data->pool_.d.constData()->transactions_) {
+      res.push_back(it.amount());
+    }
+    return res;
+  }
+
+  ::csdb::priv::unchecked_ibstream is(data->data_.data() + data->amounts_offset_, data->layout_.amounts_size);
+  for (size_t i = 0; i < data->count_; ++i) {
+    Amount value;
+    value.get_compact(is);
+    res.push_back(value);
+  }
+  return res;
+}
+
+Pool PoolColumns::pool() const
+{
+  const priv* data = d.constData();
+  if ((!data->is_valid_) || data->pool_.is_valid()) {
+    return data->pool_;
+  }
+  if (!data->hash_.is_empty()) {
+    return Pool::from_binary(data->data_, data->hash_);
+  }
+  return Pool::from_binary(data->data_);
+}
+
+} // namespace csdb
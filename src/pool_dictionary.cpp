@@ -0,0 +1,147 @@
+/**
+  * @file pool_dictionary.cpp
+  *
+  * Бинарное представление пула в формате \ref Pool::DictionaryFormat:
+  *
+  * - заголовок формата (\ref put_pool_format);
+  * - хеш предыдущего пула и номер пула;
+  * - таблица адресов: количество, затем адреса;
+  * - таблица валют: количество, затем валюты;
+  * - количество транзакций, затем транзакции. Вместо адресов и валюты в транзакции
+  *   записываются их номера в таблицах, сумма и остаток - в компактном представлении
+  *   (\ref Amount::put_compact), дополнительные поля - как в исходном формате;
+  * - дополнительные поля пула.
+  *
+  * Адреса и валюты записываются в таблицы в порядке первого появления в транзакциях.
+  */
+
+#include <vector>
+
+#include "csdb/address.h"
+#include "csdb/currency.h"
+
+#include "binary_streams.h"
+#include "pool_format.h"
+#include "pool_p.h"
+#include "pool_tables.h"
+#include "transaction_p.h"
+
+namespace csdb {
+
+void Pool::priv::put_dictionary(::csdb::priv::obstream& os) const
+{
+  using ::csdb::priv::obstream;
+
+  // Адресов обычно значительно меньше, чем транзакций.
+  ::csdb::priv::value_table<Address> addresses(transactions_.size());
+  ::csdb::priv::value_table<Currency> currencies(1);
+  ::std::vector<size_t> indices;
+  indices.reserve(transactions_.size() * 3);
+
+  size_t size = obstream::serialized_size(previous_hash_)
+      + obstream::serialized_size(sequence_)
+      + obstream::serialized_size(transactions_.size())
+      + obstream::serialized_size(user_fields_)
+      + 2 * ::csdb::priv::MAX_INTEGRAL_ENCODED_SIZE;
+  for (const auto& it : transactions_) {
+    const Transaction::priv* t = it.d.constData();
+    indices.push_back(addresses.index(t->source_));
+    indices.push_back(addresses.index(t->target_));
+    indices.push_back(currencies.index(t->currency_));
+    size += obstream::serialized_size(indices[indices.size() - 3])
+        + obstream::serialized_size(indices[indices.size() - 2])
+        + obstream::serialized_size(indices[indices.size() - 1])
+        + t->amount_.compact_serialized_size()
+        + t->balance_.compact_serialized_size()
+        + obstream::serialized_size(t->user_fields_);
+  }
+  os.reserve(size + addresses.serialized_size() + currencies.serialized_size());
+
+  ::csdb::priv::put_pool_format(os, Pool::DictionaryFormat);
+  os.put(previous_hash_);
+  os.put(sequence_);
+  addresses.put(os);
+  currencies.put(os);
+  os.put(transactions_.size());
+  auto index = indices.begin();
+  for (const auto& it : transactions_) {
+    const Transaction::priv* t = it.d.constData();
+    os.put(*(index++));
+    os.put(*(index++));
+    os.put(*(index++));
+    t->amount_.put_compact(os);
+    t->balance_.put_compact(os);
+    os.put(t->user_fields_);
+  }
+  os.put(user_fields_);
+}
+
+bool Pool::priv::get_dictionary(::csdb::priv::ibstream& is)
+{
+  ::std::vector<Address> addresses;
+  ::std::vector<Currency> currencies;
+  size_t cnt;
+  if (!is.get(previous_hash_) || !is.get(sequence_)
+      || !is.get(addresses) || !is.get(currencies)
+      || !is.get(cnt)) {
+    return false;
+  }
+
+  transactions_.clear();
+  transactions_.reserve((cnt < is.size()) ? cnt : is.size());
+  for (size_t i = 0; i < cnt; ++i) {
+    uint64_t indices[3];
+    if (!is.get_integrals(indices, 3)
+        || (indices[0] >= addresses.size())
+        || (indices[1] >= addresses.size())
+        || (indices[2] >= currencies.size())) {
+      return false;
+    }
+
+    Transaction tran;
+    Transaction::priv* t = tran.d.data();
+    t->source_ = addresses[indices[0]];
+    t->target_ = addresses[indices[1]];
+    t->currency_ = currencies[indices[2]];
+    if (!t->amount_.get_compact(is) || !t->balance_.get_compact(is) || !is.get(t->user_fields_)) {
+      return false;
+    }
+    transactions_.push_back(::std::move(tran));
+  }
+
+  return is.get(user_fields_);
+}
+
+void Pool::priv::get_dictionary(::csdb::priv::unchecked_ibstream& is)
+{
+  ::std::vector<Address> addresses;
+  ::std::vector<Currency> currencies;
+  size_t cnt;
+  is.get(previous_hash_);
+  is.get(sequence_);
+  is.get(addresses);
+  is.get(currencies);
+  is.get(cnt);
+
+  transactions_.clear();
+  transactions_.reserve(cnt);
+  for (size_t i = 0; i < cnt; ++i) {
+    uint64_t indices[3];
+    is.get_integrals(indices, 3);
+
+    // Транзакции разделяют данные адресов и валют с таблицами пула.
+    Transaction tran;
+    Transaction::priv* t = tran.d.data();
+    t->source_ = addresses[indices[0]];
+    t->target_ = addresses[indices[1]];
+    t->currency_ = currencies[indices[2]];
+    t->amount_.get_compact(is);
+    t->balance_.get_compact(is);
+    is.get(t->user_fields_);
+    transactions_.push_back(::std::move(tran));
+  }
+
+  is.get(user_fields_);
+}
+
+} // namespace csdb
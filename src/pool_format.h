@@ -0,0 +1,88 @@
+/**
+  * @file pool_format.h
+  *
+  * Заголовок версионированного бинарного представления пула.
+  *
+  * Пул в исходном формате (\ref Pool::LegacyFormat) начинается с хеша предыдущего пула,
+  * т.е. с его длины, которая не может превышать crypto::max_hash_size. Все остальные форматы
+  * начинаются со значения \ref pool_format_marker, заведомо превышающего эту длину, за которым
+  * следует номер формата. Поэтому данные в исходном формате читаются без изменений, а данные
+  * в новых форматах никогда не будут приняты за исходный формат.
+  */
+
+#pragma once
+#ifndef _CREDITS_CSDB_PRIVATE_POOL_FORMAT_H_INCLUDED_
+#define _CREDITS_CSDB_PRIVATE_POOL_FORMAT_H_INCLUDED_
+
+#include <cinttypes>
+
+#include "csdb/pool.h"
+
+#include "binary_streams.h"
+#include "priv_crypto.h"
+
+namespace csdb {
+namespace priv {
+
+constexpr uint64_t pool_format_marker = 0xC5DB;
+static_assert(pool_format_marker > crypto::max_hash_size,
+              "Pool format marker must not be a valid previous hash length.");
+
+inline bool is_known_pool_format(uint64_t format) noexcept
+{
+  return (Pool::LegacyFormat == format) || (Pool::DictionaryFormat == format)
+      || (Pool::ColumnarFormat == format) || (Pool::MerkleFormat == format);
+}
+
+/// Записывает заголовок формата. Для исходного формата ничего не записывается.
+inline void put_pool_format(obstream& os, Pool::Format format)
+{
+  if (Pool::LegacyFormat != format) {
+    os.put(pool_format_marker);
+    os.put(format);
+  }
+}
+
+/**
+ * @brief Читает заголовок формата, если он есть.
+ * @return false, если данные начинаются с заголовка неизвестного формата.
+ *
+ * Если заголовка нет, формат считается исходным, а позиция потока не изменяется.
+ */
+inline bool get_pool_format(ibstream& is, Pool::Format& format)
+{
+  ibstream header = is;
+  uint64_t value;
+  if ((!header.get(value)) || (pool_format_marker != value)) {
+    format = Pool::LegacyFormat;
+    return true;
+  }
+
+  if ((!header.get(value)) || (Pool::LegacyFormat == value) || (!is_known_pool_format(value))) {
+    return false;
+  }
+
+  format = static_cast<Pool::Format>(value);
+  is = header;
+  return true;
+}
+
+/// Чтение заголовка из данных, прошедших проверку \ref get_pool_format.
+inline Pool::Format get_pool_format(unchecked_ibstream& is)
+{
+  unchecked_ibstream header = is;
+  uint64_t value;
+  header.get(value);
+  if (pool_format_marker != value) {
+    return Pool::LegacyFormat;
+  }
+
+  header.get(value);
+  is = header;
+  return static_cast<Pool::Format>(value);
+}
+
+} // namespace priv
+} // namespace csdb
+
+#endif // _CREDITS_CSDB_PRIVATE_POOL_FORMAT_H_INCLUDED_
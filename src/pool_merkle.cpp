@@ -0,0 +1,257 @@
+#include "pool_merkle.h"
+
+#include <algorithm>
+
+#include "binary_streams.h"
+#include "pool_format.h"
+#include "pool_p.h"
+#include "pool_scan.h"
+#include "priv_crypto.h"
+
+namespace csdb {
+namespace priv {
+
+namespace {
+
+constexpr uint8_t leaf_prefix = 0x00;
+constexpr uint8_t node_prefix = 0x01;
+
+/// Хеши участков buffer, начинающихся с offsets[i] и заканчивающихся началом следующего участка.
+merkle_level calc_hashes(const ::csdb::internal::byte_array& buffer, const ::std::vector<size_t>& offsets)
+{
+  ::std::vector<const void*> data(offsets.size());
+  ::std::vector<size_t> sizes(offsets.size());
+  for (size_t i = 0; i < offsets.size(); ++i) {
+    data[i] = buffer.data() + offsets[i];
+    sizes[i] = ((i + 1 < offsets.size()) ? offsets[i + 1] : buffer.size()) - offsets[i];
+  }
+  return crypto::calc_hashes(data.data(), sizes.data(), offsets.size());
+}
+
+merkle_level next_level(const merkle_level& level)
+{
+  ::csdb::internal::byte_array buffer;
+  ::std::vector<size_t> offsets(level.size() / 2);
+  buffer.reserve(offsets.size() * (1 + 2 * level.front().size()));
+  for (size_t i = 0; i < offsets.size(); ++i) {
+    offsets[i] = buffer.size();
+    buffer.push_back(node_prefix);
+    buffer.insert(buffer.end(), level[2 * i].begin(), level[2 * i].end());
+    buffer.insert(buffer.end(), level[2 * i + 1].begin(), level[2 * i + 1].end());
+  }
+
+  merkle_level res = calc_hashes(buffer, offsets);
+  if (0 != (level.size() % 2)) {
+    res.push_back(level.back());
+  }
+  return res;
+}
+
+} // namespace
+
+merkle_level merkle_leaves(const void* data, const ::std::vector<size_t>& sizes)
+{
+  size_t total = 0;
+  for (size_t size : sizes) {
+    total += 1 + size;
+  }
+
+  const uint8_t* transaction = static_cast<const uint8_t*>(data);
+  ::csdb::internal::byte_array buffer;
+  ::std::vector<size_t> offsets(sizes.size());
+  buffer.reserve(total);
+  for (size_t i = 0; i < sizes.size(); ++i) {
+    offsets[i] = buffer.size();
+    buffer.push_back(leaf_prefix);
+    buffer.insert(buffer.end(), transaction, transaction + sizes[i]);
+    transaction += sizes[i];
+  }
+  return calc_hashes(buffer, offsets);
+}
+
+::csdb::internal::byte_array merkle_root(merkle_level leaves)
+{
+  if (leaves.empty()) {
+    return crypto::calc_hash(::csdb::internal::byte_array{});
+  }
+
+  while (leaves.size() > 1) {
+    leaves = next_level(leaves);
+  }
+  return leaves.front();
+}
+
+merkle_level merkle_path(merkle_level leaves, size_t index)
+{
+  merkle_level res;
+  if (index >= leaves.size()) {
+    return res;
+  }
+
+  for (; leaves.size() > 1; index /= 2) {
+    const size_t sibling = index ^ 1;
+    if (sibling < leaves.size()) {
+      res.push_back(leaves[sibling]);
+    }
+    leaves = next_level(leaves);
+  }
+  return res;
+}
+
+::csdb::internal::byte_array merkle_root_from_path(const ::csdb::internal::byte_array& transaction, size_t index,
+                                                   size_t count, const merkle_level& path)
+{
+  if (index >= count) {
+    return ::csdb::internal::byte_array{};
+  }
+
+  ::csdb::internal::byte_array buffer{leaf_prefix};
+  buffer.insert(buffer.end(), transaction.begin(), transaction.end());
+  ::csdb::internal::byte_array node = crypto::calc_hash(buffer);
+
+  auto sibling = path.begin();
+  for (size_t level_size = count; level_size > 1; level_size = (level_size + 1) / 2, index /= 2) {
+    if ((0 == (index % 2)) && (index + 1 == level_size)) {
+      // Узел без пары.
+      continue;
+    }
+    if (path.end() == sibling) {
+      return ::csdb::internal::byte_array{};
+    }
+
+    buffer.assign(1, node_prefix);
+    if (0 == (index % 2)) {
+      buffer.insert(buffer.end(), node.begin(), node.end());
+      buffer.insert(buffer.end(), sibling->begin(), sibling->end());
+    } else {
+      buffer.insert(buffer.end(), sibling->begin(), sibling->end());
+      buffer.insert(buffer.end(), node.begin(), node.end());
+    }
+    node = crypto::calc_hash(buffer);
+    ++sibling;
+  }
+
+  return (path.end() == sibling) ? node : ::csdb::internal::byte_array{};
+}
+
+bool get_merkle_header(const void* data, size_t size, size_t& transactions_count,
+                       ::csdb::internal::byte_array& root, size_t& header_size)
+{
+  ibstream is(data, size);
+  Pool::Format format;
+  PoolHash previous_hash;
+  Pool::sequence_t sequence;
+  ::csdb::user_field_map_t user_fields;
+  if (!get_pool_format(is, format) || (Pool::MerkleFormat != format)
+      || !is.get(previous_hash) || !is.get(sequence) || !is.get(user_fields)
+      || !is.get(transactions_count) || !is.get(root)) {
+    return false;
+  }
+
+  header_size = size - is.size();
+  return true;
+}
+
+size_t pool_hashed_size(const void* data, size_t size)
+{
+  ibstream is(data, size);
+  Pool::Format format;
+  size_t cnt;
+  if (get_pool_format(is, format) && (Pool::MerkleFormat == format) && scan_merkle_header(is, cnt)) {
+    return size - is.size();
+  }
+  return size;
+}
+
+} // namespace priv
+
+void Pool::priv::put_merkle(::csdb::priv::obstream& os) const
+{
+  os.reserve(serialized_size() + ::csdb::priv::crypto::hash_size + 3 * ::csdb::priv::MAX_INTEGRAL_ENCODED_SIZE);
+  const size_t body_offset = put_merkle_header(os);
+
+  ::std::vector<size_t> sizes;
+  sizes.reserve(transactions_.size());
+  for (const auto& it : transactions_) {
+    const size_t offset = os.buffer().size();
+    os.put(it);
+    sizes.push_back(os.buffer().size() - offset);
+  }
+
+  put_merkle_root(os.buffer(), body_offset,
+                  ::csdb::priv::merkle_leaves(os.buffer().data() + body_offset, sizes));
+}
+
+size_t Pool::priv::put_merkle_header(::csdb::priv::obstream& os) const
+{
+  // Корень записывается после транзакций на заранее оставленное место.
+  const ::csdb::internal::byte_array placeholder(::csdb::priv::crypto::hash_size, 0);
+  ::csdb::priv::put_pool_format(os, Pool::MerkleFormat);
+  os.put(previous_hash_);
+  os.put(sequence_);
+  os.put(user_fields_);
+  os.put(transactions_.size());
+  os.put(placeholder);
+  return os.buffer().size();
+}
+
+void Pool::priv::put_merkle_root(::csdb::internal::byte_array& buffer, size_t body_offset,
+                                 const ::csdb::priv::merkle_level& leaves)
+{
+  const ::csdb::internal::byte_array root = ::csdb::priv::merkle_root(leaves);
+  ::std::copy(root.begin(), root.end(), buffer.begin() + (body_offset - root.size()));
+}
+
+bool Pool::priv::get_merkle(::csdb::priv::ibstream& is)
+{
+  size_t cnt;
+  ::csdb::internal::byte_array root;
+  if (!is.get(previous_hash_) || !is.get(sequence_) || !is.get(user_fields_)
+      || !is.get(cnt) || !is.get(root)) {
+    return false;
+  }
+
+  const void* body = is.data();
+  ::std::vector<size_t> sizes;
+  transactions_.clear();
+  transactions_.reserve((cnt < is.size()) ? cnt : is.size());
+  sizes.reserve(transactions_.capacity());
+  for (size_t i = 0; i < cnt; ++i) {
+    const size_t size = is.size();
+    Transaction tran;
+    if (!is.get(tran)) {
+      return false;
+    }
+    sizes.push_back(size - is.size());
+    transactions_.push_back(::std::move(tran));
+  }
+
+  return ::csdb::priv::merkle_root(::csdb::priv::merkle_leaves(body, sizes)) == root;
+}
+
+bool Pool::priv::get_merkle(::csdb::priv::unchecked_ibstream& is)
+{
+  size_t cnt;
+  ::csdb::internal::byte_array root;
+  is.get(previous_hash_);
+  is.get(sequence_);
+  is.get(user_fields_);
+  is.get(cnt);
+  is.get(root);
+
+  const void* body = is.data();
+  ::std::vector<size_t> sizes(cnt);
+  transactions_.clear();
+  transactions_.reserve(cnt);
+  for (size_t i = 0; i < cnt; ++i) {
+    const size_t size = is.size();
+    Transaction tran;
+    is.get(tran);
+    sizes[i] = size - is.size();
+    transactions_.push_back(::std::move(tran));
+  }
+
+  return ::csdb::priv::merkle_root(::csdb::priv::merkle_leaves(body, sizes)) == root;
+}
+
+} // namespace csdb
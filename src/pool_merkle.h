@@ -0,0 +1,72 @@
+/**
+  * @file pool_merkle.h
+  *
+  * Бинарное представление пула в формате \ref Pool::MerkleFormat:
+  *
+  * - заголовок формата (\ref put_pool_format);
+  * - хеш предыдущего пула и номер пула;
+  * - дополнительные поля пула;
+  * - количество транзакций;
+  * - корень дерева Меркла по транзакциям;
+  * - транзакции в исходном формате.
+  *
+  * Хеш пула вычисляется по данным до первой транзакции (\ref pool_hashed_size), а с транзакциями
+  * его связывает корень дерева, который проверяется при каждом чтении пула.
+  *
+  * Дерево строится так же, как в RFC 6962: хеш листа - H(0x00 || транзакция), хеш узла -
+  * H(0x01 || левый || правый). Узлы каждого уровня объединяются попарно слева направо, узел
+  * без пары переходит на следующий уровень без изменений. Корень пустого дерева - хеш пустых
+  * данных. Все хеши одного уровня вычисляются одновременно (\ref crypto::calc_hashes).
+  */
+
+#pragma once
+#ifndef _CREDITS_CSDB_PRIVATE_POOL_MERKLE_H_INCLUDED_
+#define _CREDITS_CSDB_PRIVATE_POOL_MERKLE_H_INCLUDED_
+
+#include <cstddef>
+#include <vector>
+
+#include "csdb/internal/types.h"
+
+namespace csdb {
+namespace priv {
+
+/// Хеши узлов одного уровня дерева.
+using merkle_level = ::std::vector<::csdb::internal::byte_array>;
+
+/// Хеши листьев для транзакций, записанных подряд начиная с data; sizes - размеры транзакций.
+merkle_level merkle_leaves(const void* data, const ::std::vector<size_t>& sizes);
+
+/// Корень дерева по хешам листьев.
+::csdb::internal::byte_array merkle_root(merkle_level leaves);
+
+/// Хеши соседних узлов на пути от листа index к корню.
+merkle_level merkle_path(merkle_level leaves, size_t index);
+
+/**
+ * @brief Корень дерева из count листьев, вычисленный по транзакции с номером index и пути к корню.
+ * @return Пустой массив, если длина пути не соответствует index и count.
+ */
+::csdb::internal::byte_array merkle_root_from_path(const ::csdb::internal::byte_array& transaction, size_t index,
+                                                   size_t count, const merkle_level& path);
+
+/**
+ * @brief Читает заголовок пула в формате \ref Pool::MerkleFormat.
+ * @param[out] transactions_count Количество транзакций в пуле.
+ * @param[out] root               Корень дерева.
+ * @param[out] header_size        Размер заголовка (см. \ref pool_hashed_size).
+ * @return false, если данные не начинаются с заголовка пула в формате \ref Pool::MerkleFormat.
+ */
+bool get_merkle_header(const void* data, size_t size, size_t& transactions_count,
+                       ::csdb::internal::byte_array& root, size_t& header_size);
+
+/**
+ * @brief Размер начала бинарного представления пула, по которому вычисляется хеш пула.
+ * @return Размер заголовка для пулов в формате \ref Pool::MerkleFormat и size для остальных данных.
+ */
+size_t pool_hashed_size(const void* data, size_t size);
+
+} // namespace priv
+} // namespace csdb
+
+#endif // _CREDITS_CSDB_PRIVATE_POOL_MERKLE_H_INCLUDED_
@@ -0,0 +1,343 @@
+/**
+  * @file pool_p.h
+  * @author Evgeny V. Zalivochkin
+  */
+
+#pragma once
+#ifndef _CREDITS_CSDB_POOL_PRIVATE_H_INCLUDED_
+#define _CREDITS_CSDB_POOL_PRIVATE_H_INCLUDED_
+
+#include <unordered_map>
+#include <vector>
+#include <utility>
+
+#include "csdb/internal/shared_data_ptr_implementation.h"
+
+#include "csdb/pool.h"
+#include "csdb/storage.h"
+#include "csdb/csdb.h"
+
+#include "binary_streams.h"
+#include "pool_format.h"
+#include "pool_merkle.h"
+#include "pool_scan.h"
+#include "serialization_schema.h"
+#include "transaction_p.h"
+
+namespace csdb {
+
+class Pool::priv : public ::csdb::internal::shared_data
+{
+  priv() : is_valid_(false), read_only_(false), format_(Pool::LegacyFormat), sequence_(0), indexed_count_(0) {}
+  priv(PoolHash previous_hash, Pool::sequence_t sequence, ::csdb::Storage::WeakPtr storage) :
+    is_valid_(true),
+    read_only_(false),
+    format_(Pool::LegacyFormat),
+    previous_hash_(previous_hash),
+    sequence_(sequence),
+    storage_(storage),
+    indexed_count_(0)
+  {}
+
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  /// Транзакции пула с одним адресом.
+  struct address_entry
+  {
+    address_entry() : last_source(npos), last_target(npos) {}
+
+    ::std::vector<size_t> transactions;  // Номера транзакций с адресом-отправителем или получателем
+    size_t last_source;
+    size_t last_target;
+    ::std::unordered_map<Currency, Amount> debits;  // Сумма транзакций с адресом-отправителем
+  };
+
+  /**
+   * @brief Индекс адресов покрывает все транзакции пула.
+   *
+   * Индекс дополняется в \ref Pool::add_transaction. Пулы, прочитанные из бинарного
+   * представления, индекса не имеют, а после вызова \ref Pool::transactions он перестаёт
+   * соответствовать транзакциям; в этих случаях поиск выполняется перебором.
+   */
+  bool is_indexed() const noexcept
+  {
+    return indexed_count_ == transactions_.size();
+  }
+
+  /// Добавляет в индекс последнюю транзакцию, если индекс покрывает все предыдущие.
+  void index_last_transaction()
+  {
+    if (indexed_count_ + 1 != transactions_.size()) {
+      return;
+    }
+
+    const size_t index = indexed_count_++;
+    const Transaction::priv* t = transactions_[index].d.constData();
+    address_entry& source = address_index_[t->source_];
+    source.transactions.push_back(index);
+    source.last_source = index;
+    source.debits[t->currency_] += t->amount_;
+
+    // Транзакция с совпадающими отправителем и получателем записывается один раз.
+    address_entry& target = address_index_[t->target_];
+    if (t->target_ != t->source_) {
+      target.transactions.push_back(index);
+    }
+    target.last_target = index;
+  }
+
+  /// Сбрасывает индекс; до вызова \ref clear_index поиск выполняется перебором.
+  void drop_index()
+  {
+    address_index_.clear();
+    indexed_count_ = npos;
+  }
+
+  /// Пустой индекс для пула без транзакций.
+  void clear_index()
+  {
+    address_index_.clear();
+    indexed_count_ = 0;
+  }
+
+  /// Запись индекса для адреса или nullptr, если адреса в пуле нет. Только для \ref is_indexed.
+  const address_entry* find_indexed(const Address& address) const
+  {
+    const auto it = address_index_.find(address);
+    return (it != address_index_.end()) ? &it->second : nullptr;
+  }
+
+  void put_meta(::csdb::priv::obstream& os, size_t cnt) const
+  {
+    os.put(previous_hash_);
+    os.put(sequence_);
+    os.put(cnt);
+  }
+
+  /// Запись в формате format_.
+  void put(::csdb::priv::obstream& os) const
+  {
+    switch (format_) {
+    case Pool::DictionaryFormat:
+      put_dictionary(os);
+      break;
+    case Pool::ColumnarFormat:
+      put_columnar(os);
+      break;
+    case Pool::MerkleFormat:
+      put_merkle(os);
+      break;
+    default:
+      serialization_schema::put(os, *this);
+      break;
+    }
+  }
+
+  /// Размер бинарного представления в исходном формате.
+  size_t serialized_size() const noexcept
+  {
+    return serialization_schema::serialized_size(*this);
+  }
+
+  /// Формирует бинарное представление в формате format_.
+  ::csdb::internal::byte_array serialize() const
+  {
+    ::csdb::priv::obstream os;
+    // Для остальных форматов размер известен только после построения таблиц, поэтому
+    // память резервируется при записи.
+    if (Pool::LegacyFormat == format_) {
+      os.reserve(serialized_size());
+    }
+    put(os);
+    return ::std::move(os.buffer());
+  }
+
+  bool get_meta(::csdb::priv::ibstream& is, size_t& cnt) {
+	  if (!::csdb::priv::get_pool_format(is, format_)) {
+		  return false;
+	  }
+
+	  if (!is.get(previous_hash_)) {
+		  return false;
+	  }
+
+	  if (!is.get(sequence_))
+		  return false;
+
+	  if (((Pool::DictionaryFormat == format_) || (Pool::ColumnarFormat == format_))
+	      && (!::csdb::priv::scan_pool_tables(is))) {
+		  return false;
+	  }
+
+	  if ((Pool::MerkleFormat == format_) && (!is.get(user_fields_))) {
+		  return false;
+	  }
+
+	  if (!is.get(cnt)) {
+		  return false;
+	  }
+
+	  return true;
+  }
+
+  bool get(::csdb::priv::ibstream& is)
+  {
+    if (!::csdb::priv::get_pool_format(is, format_)) {
+      return false;
+    }
+
+    bool res;
+    switch (format_) {
+    case Pool::DictionaryFormat:
+      res = get_dictionary(is);
+      break;
+    case Pool::ColumnarFormat:
+      res = get_columnar(is);
+      break;
+    case Pool::MerkleFormat:
+      res = get_merkle(is);
+      break;
+    default:
+      res = serialization_schema::get(is, *this);
+      break;
+    }
+    if (!res) {
+      return false;
+    }
+
+    is_valid_ = true;
+    return true;
+  }
+
+  /**
+   * @brief Чтение данных, прошедших проверку \ref ::csdb::priv::scan_pool.
+   * @return false, если не совпадает корень дерева Меркла (\ref Pool::MerkleFormat).
+   */
+  bool get(::csdb::priv::unchecked_ibstream& is)
+  {
+    bool res = true;
+    format_ = ::csdb::priv::get_pool_format(is);
+    switch (format_) {
+    case Pool::DictionaryFormat:
+      get_dictionary(is);
+      break;
+    case Pool::ColumnarFormat:
+      get_columnar(is);
+      break;
+    case Pool::MerkleFormat:
+      res = get_merkle(is);
+      break;
+    default:
+      serialization_schema::get(is, *this);
+      break;
+    }
+    is_valid_ = res;
+    return res;
+  }
+
+  // Формат Pool::DictionaryFormat (pool_dictionary.cpp).
+  void put_dictionary(::csdb::priv::obstream& os) const;
+  bool get_dictionary(::csdb::priv::ibstream& is);
+  void get_dictionary(::csdb::priv::unchecked_ibstream& is);
+
+  // Формат Pool::ColumnarFormat (pool_columnar.cpp).
+  void put_columnar(::csdb::priv::obstream& os) const;
+  bool get_columnar(::csdb::priv::ibstream& is);
+  void get_columnar(::csdb::priv::unchecked_ibstream& is);
+
+  // Формат Pool::MerkleFormat (pool_merkle.cpp).
+  void put_merkle(::csdb::priv::obstream& os) const;
+  /// Заголовок с местом под корень дерева. Возвращает смещение первой транзакции.
+  size_t put_merkle_header(::csdb::priv::obstream& os) const;
+  /// Записывает корень дерева по листьям перед транзакциями, начинающимися с body_offset.
+  static void put_merkle_root(::csdb::internal::byte_array& buffer, size_t body_offset,
+                              const ::csdb::priv::merkle_level& leaves);
+  bool get_merkle(::csdb::priv::ibstream& is);
+  bool get_merkle(::csdb::priv::unchecked_ibstream& is);
+
+  /// Формирует бинарное представление, используя до threads потоков (см. \ref Pool::compose).
+  void compose(size_t threads = 1)
+  {
+    if (!is_valid_) {
+      binary_representation_.clear();
+      hash_ = PoolHash();
+      return;
+    }
+
+    /*if (!binary_representation_.empty()) {
+      return;
+    }*/
+
+    binary_representation_ = (1 == threads) ? serialize() : serialize(threads);
+
+    update_transactions(threads);
+  }
+
+  // Параллельное формирование пула (pool_parallel.cpp).
+  ::csdb::internal::byte_array serialize(size_t threads) const;
+  void update_ids(size_t threads);
+
+  void update_transactions(size_t threads = 1)
+  {
+    const size_t size = ::csdb::priv::pool_hashed_size(binary_representation_.data(),
+                                                       binary_representation_.size());
+    update_transactions(PoolHash::from_binary(
+                          ::csdb::priv::crypto::calc_hash(binary_representation_.data(), size)), threads);
+  }
+
+  /// Переводит пул в режим read-only с заранее вычисленным хешем.
+  void update_transactions(const PoolHash& hash, size_t threads = 1)
+  {
+    read_only_ = true;
+    hash_ = hash;
+    if (1 != threads) {
+      update_ids(threads);
+      return;
+    }
+    for (size_t idx = 0; idx < transactions_.size(); ++idx) {
+      transactions_[idx].d->_update_id(hash_, idx);
+    }
+  }
+
+  Storage get_storage(Storage candidate)
+  {
+    if (candidate.isOpen()) {
+      return candidate;
+    }
+
+    candidate = Storage(storage_);
+    if (candidate.isOpen()) {
+      return candidate;
+    }
+
+    return ::csdb::defaultStorage();
+  }
+
+  bool is_valid_;
+  bool read_only_;
+  Pool::Format format_;
+  PoolHash hash_;
+  PoolHash previous_hash_;
+  Pool::sequence_t sequence_;
+  std::vector<Transaction> transactions_;
+  user_field_map_t user_fields_;
+  ::csdb::internal::byte_array binary_representation_;
+  ::csdb::Storage::WeakPtr storage_;
+  ::std::unordered_map<Address, address_entry> address_index_;
+  size_t indexed_count_;  // Количество проиндексированных транзакций или npos, если индекс сброшен
+
+  /// Заголовок пула (см. \ref put_meta), транзакции и дополнительные поля.
+  typedef ::csdb::priv::schema<priv,
+                               CSDB_SCHEMA_FIELD(priv, previous_hash_),
+                               CSDB_SCHEMA_FIELD(priv, sequence_),
+                               CSDB_SCHEMA_FIELD(priv, transactions_),
+                               CSDB_SCHEMA_FIELD(priv, user_fields_)> serialization_schema;
+
+  friend class Pool;
+  friend class PoolBuilder;
+  friend class PoolColumns;
+};
+
+} // namespace csdb
+
+#endif // _CREDITS_CSDB_POOL_PRIVATE_H_INCLUDED_
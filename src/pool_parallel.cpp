@@ -0,0 +1,109 @@
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "binary_streams.h"
+#include "integral_encdec.h"
+#include "parallel.h"
+#include "pool_merkle.h"
+#include "pool_p.h"
+#include "priv_crypto.h"
+
+namespace csdb {
+
+namespace {
+
+/// Минимальное количество транзакций на поток: на меньших частях запуск потока дороже сериализации.
+constexpr size_t compose_min_chunk = 2048;
+
+/// Минимальное количество транзакций на поток при установке идентификаторов.
+constexpr size_t update_ids_min_chunk = 8192;
+
+} // namespace
+
+::csdb::internal::byte_array Pool::priv::serialize(size_t threads) const
+{
+  const bool merkle = (Pool::MerkleFormat == format_);
+  threads = ::csdb::priv::parallel_threads(transactions_.size(), threads, compose_min_chunk);
+  // Таблицы адресов и валют строятся по всем транзакциям сразу, поэтому форматы со словарём
+  // формируются последовательно.
+  if ((1 == threads) || ((Pool::LegacyFormat != format_) && (!merkle))) {
+    return serialize();
+  }
+
+  // Каждая часть транзакций сериализуется в свой буфер заранее вычисленного размера. Для
+  // MerkleFormat там же вычисляются листья дерева.
+  ::std::vector<::csdb::internal::byte_array> parts(threads);
+  ::std::vector<::csdb::priv::merkle_level> leaves(merkle ? threads : 0);
+  ::csdb::priv::parallel_for(transactions_.size(), threads, [&](size_t chunk, size_t begin, size_t end) {
+    size_t size = 0;
+    for (size_t i = begin; i < end; ++i) {
+      size += ::csdb::priv::obstream::serialized_size(transactions_[i]);
+    }
+
+    ::csdb::priv::obstream os;
+    os.reserve(size);
+    ::std::vector<size_t> sizes;
+    sizes.reserve(merkle ? (end - begin) : 0);
+    for (size_t i = begin; i < end; ++i) {
+      const size_t offset = os.buffer().size();
+      os.put(transactions_[i]);
+      if (merkle) {
+        sizes.push_back(os.buffer().size() - offset);
+      }
+    }
+
+    if (merkle) {
+      leaves[chunk] = ::csdb::priv::merkle_leaves(os.buffer().data(), sizes);
+    }
+    parts[chunk] = ::std::move(os.buffer());
+  });
+
+  // Части склеиваются по порядку между заголовком и окончанием представления.
+  size_t body_size = 0;
+  for (const auto& it : parts) {
+    body_size += it.size();
+  }
+
+  ::csdb::priv::obstream os;
+  os.reserve(::csdb::priv::obstream::serialized_size(previous_hash_)
+             + ::csdb::priv::obstream::serialized_size(user_fields_) + ::csdb::priv::crypto::hash_size
+             + 4 * ::csdb::priv::MAX_INTEGRAL_ENCODED_SIZE + body_size);
+  size_t body_offset = 0;
+  if (merkle) {
+    body_offset = put_merkle_header(os);
+  } else {
+    os.put(previous_hash_);
+    os.put(sequence_);
+    os.put(transactions_.size());
+  }
+
+  for (const auto& it : parts) {
+    os.put(it.data(), it.size());
+  }
+
+  if (merkle) {
+    ::csdb::priv::merkle_level all;
+    all.reserve(transactions_.size());
+    for (auto& it : leaves) {
+      ::std::move(it.begin(), it.end(), ::std::back_inserter(all));
+    }
+    put_merkle_root(os.buffer(), body_offset, all);
+  } else {
+    os.put(user_fields_);
+  }
+
+  return ::std::move(os.buffer());
+}
+
+void Pool::priv::update_ids(size_t threads)
+{
+  threads = ::csdb::priv::parallel_threads(transactions_.size(), threads, update_ids_min_chunk);
+  ::csdb::priv::parallel_for(transactions_.size(), threads, [this](size_t, size_t begin, size_t end) {
+    for (size_t idx = begin; idx < end; ++idx) {
+      transactions_[idx].d->_update_id(hash_, idx);
+    }
+  });
+}
+
+} // namespace csdb
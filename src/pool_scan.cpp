@@ -0,0 +1,254 @@
+#include "pool_scan.h"
+
+#include <limits>
+
+#include "csdb/amount.h"
+#include "csdb/user_field.h"
+#include "binary_streams.h"
+#include "pool_columnar.h"
+#include "pool_format.h"
+#include "priv_crypto.h"
+
+namespace csdb {
+namespace priv {
+
+namespace {
+
+inline bool scan_integral(ibstream& is)
+{
+  uint64_t value;
+  return is.get(value);
+}
+
+/// Массив байт или строка с префиксом длины.
+inline bool scan_bytes(ibstream& is, size_t max_size = ::std::numeric_limits<size_t>::max())
+{
+  size_t size;
+  return is.get(size) && (size <= max_size) && is.skip(size);
+}
+
+/// Несколько целых значений, записанных подряд.
+template<size_t N>
+inline bool scan_integrals(ibstream& is)
+{
+  uint64_t values[N];
+  return is.get_integrals(values, N);
+}
+
+inline bool scan_amount(ibstream& is)
+{
+  return scan_integrals<2>(is);
+}
+
+/// Сумма в компактном представлении (Amount::put_compact).
+inline bool scan_compact_amount(ibstream& is)
+{
+  Amount value;
+  return value.get_compact(is);
+}
+
+bool scan_user_fields(ibstream& is)
+{
+  size_t count;
+  if (!is.get(count)) {
+    return false;
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    UserField::Type type;
+    if (!scan_integral(is) || !is.get(type)) {
+      return false;
+    }
+    switch (type) {
+    case UserField::Integer:
+      if (!scan_integral(is)) {
+        return false;
+      }
+      break;
+
+    case UserField::String:
+      if (!scan_bytes(is)) {
+        return false;
+      }
+      break;
+
+    case UserField::Amount:
+      if (!scan_amount(is)) {
+        return false;
+      }
+      break;
+
+    default:
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/// Таблица: количество элементов, затем элементы с префиксом длины.
+bool scan_table(ibstream& is, size_t max_size, size_t& count)
+{
+  if (!is.get(count)) {
+    return false;
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    if (!scan_bytes(is, max_size)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/// Транзакция пула в формате Pool::DictionaryFormat.
+bool scan_dictionary_transaction(ibstream& is, size_t addresses_count, size_t currencies_count)
+{
+  uint64_t indices[3];
+  return is.get_integrals(indices, 3)                   // source, target, currency
+      && (indices[0] < addresses_count)
+      && (indices[1] < addresses_count)
+      && (indices[2] < currencies_count)
+      && scan_compact_amount(is)                        // amount
+      && scan_compact_amount(is)                        // balance
+      && scan_user_fields(is);
+}
+
+bool scan_dictionary_pool(ibstream& is, size_t& transactions_count)
+{
+  size_t addresses_count;
+  size_t currencies_count;
+  if (!scan_bytes(is, crypto::max_hash_size)            // previous hash
+      || !scan_integral(is)                             // sequence
+      || !scan_table(is, crypto::max_public_key_size, addresses_count)
+      || !scan_table(is, ::std::numeric_limits<size_t>::max(), currencies_count)
+      || !is.get(transactions_count)) {
+    return false;
+  }
+
+  for (size_t i = 0; i < transactions_count; ++i) {
+    if (!scan_dictionary_transaction(is, addresses_count, currencies_count)) {
+      return false;
+    }
+  }
+
+  return scan_user_fields(is);
+}
+
+/// Столбец из count значений, занимающий ровно size байт.
+template<typename F>
+bool scan_column(ibstream& is, size_t size, size_t count, F scan_value)
+{
+  ibstream column(is.data(), size);
+  if (!is.skip(size)) {
+    return false;
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    if (!scan_value(column)) {
+      return false;
+    }
+  }
+
+  return column.empty();
+}
+
+bool scan_columnar_pool(ibstream& is, size_t& transactions_count)
+{
+  size_t addresses_count;
+  size_t currencies_count;
+  columnar_layout layout;
+  if (!scan_bytes(is, crypto::max_hash_size)            // previous hash
+      || !scan_integral(is)                             // sequence
+      || !scan_table(is, crypto::max_public_key_size, addresses_count)
+      || !scan_table(is, ::std::numeric_limits<size_t>::max(), currencies_count)
+      || !is.get(transactions_count)
+      || !layout.get(is, transactions_count)) {
+    return false;
+  }
+
+  const size_t column_size = layout.index_column_size(transactions_count);
+  const uint8_t* sources = static_cast<const uint8_t*>(is.data());
+  return check_column_indices(sources, transactions_count, layout.index_width, addresses_count)
+      && check_column_indices(sources + column_size, transactions_count, layout.index_width,
+                              addresses_count)
+      && check_column_indices(sources + 2 * column_size, transactions_count, layout.index_width,
+                              currencies_count)
+      && is.skip(3 * column_size)
+      && scan_column(is, layout.amounts_size, transactions_count, scan_compact_amount)
+      && scan_column(is, layout.balances_size, transactions_count, scan_compact_amount)
+      && scan_column(is, layout.user_fields_size, transactions_count, scan_user_fields)
+      && scan_user_fields(is);
+}
+
+} // namespace
+
+bool scan_transaction(ibstream& is)
+{
+  return scan_bytes(is, crypto::max_public_key_size)    // source
+      && scan_bytes(is, crypto::max_public_key_size)    // target
+      && scan_bytes(is)                                 // currency
+      && scan_integrals<4>(is)                          // amount, balance
+      && scan_user_fields(is);
+}
+
+bool scan_pool_tables(ibstream& is)
+{
+  size_t count;
+  return scan_table(is, crypto::max_public_key_size, count)
+      && scan_table(is, ::std::numeric_limits<size_t>::max(), count);
+}
+
+bool scan_merkle_header(ibstream& is, size_t& transactions_count)
+{
+  return scan_bytes(is, crypto::max_hash_size)          // previous hash
+      && scan_integral(is)                              // sequence
+      && scan_user_fields(is)
+      && is.get(transactions_count)
+      && scan_bytes(is, crypto::max_hash_size);         // merkle root
+}
+
+bool scan_pool(const void* data, size_t size, size_t& transactions_count)
+{
+  ibstream is(data, size);
+  Pool::Format format;
+  if (!get_pool_format(is, format)) {
+    return false;
+  }
+  if (Pool::DictionaryFormat == format) {
+    return scan_dictionary_pool(is, transactions_count);
+  }
+  if (Pool::ColumnarFormat == format) {
+    return scan_columnar_pool(is, transactions_count);
+  }
+  if (Pool::MerkleFormat == format) {
+    if (!scan_merkle_header(is, transactions_count)) {
+      return false;
+    }
+    for (size_t i = 0; i < transactions_count; ++i) {
+      if (!scan_transaction(is)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  uint64_t meta[2];
+  if (!scan_bytes(is, crypto::max_hash_size)            // previous hash
+      || !is.get_integrals(meta, 2)) {                  // sequence, transactions count
+    return false;
+  }
+  transactions_count = static_cast<size_t>(meta[1]);
+
+  for (size_t i = 0; i < transactions_count; ++i) {
+    if (!scan_transaction(is)) {
+      return false;
+    }
+  }
+
+  return scan_user_fields(is);
+}
+
+} // namespace priv
+} // namespace csdb
@@ -0,0 +1,64 @@
+/**
+  * @file pool_scan.h
+  *
+  * Проверка структуры бинарного представления пула и транзакции без декодирования
+  * (без создания объектов и выделения памяти).
+  *
+  * Для пулов в форматах \ref Pool::DictionaryFormat и \ref Pool::ColumnarFormat дополнительно
+  * проверяется, что номера адресов и валют в транзакциях не выходят за пределы таблиц пула,
+  * а для \ref Pool::ColumnarFormat - что размеры столбцов совпадают с заявленными.
+  * Корень дерева Меркла для \ref Pool::MerkleFormat не проверяется.
+  *
+  * Проверка принимает в точности те данные, которые успешно читаются через \ref ibstream
+  * (\ref Pool::from_binary, \ref Transaction::from_binary), поэтому после успешной проверки
+  * данные можно читать через \ref unchecked_ibstream.
+  */
+
+#pragma once
+#ifndef _CREDITS_CSDB_PRIVATE_POOL_SCAN_H_INCLUDED_
+#define _CREDITS_CSDB_PRIVATE_POOL_SCAN_H_INCLUDED_
+
+#include <cstddef>
+
+namespace csdb {
+namespace priv {
+
+class ibstream;
+
+/**
+ * @brief Проверяет структуру транзакции, начинающейся с текущей позиции потока.
+ * @return true, если транзакция может быть прочитана из потока. Позиция потока при этом
+ *         указывает на первый байт после транзакции.
+ */
+bool scan_transaction(ibstream& is);
+
+/**
+ * @brief Проверяет таблицы адресов и валют пула в форматах \ref Pool::DictionaryFormat
+ *        и \ref Pool::ColumnarFormat.
+ * @return true, если таблицы могут быть прочитаны из потока. Позиция потока при этом
+ *         указывает на первый байт после таблиц.
+ */
+bool scan_pool_tables(ibstream& is);
+
+/**
+ * @brief Проверяет заголовок пула в формате \ref Pool::MerkleFormat, следующий за заголовком
+ *        формата: хеш предыдущего пула, номер, дополнительные поля, количество транзакций и
+ *        корень дерева Меркла.
+ * @return true, если заголовок может быть прочитан из потока. Позиция потока при этом
+ *         указывает на первую транзакцию.
+ */
+bool scan_merkle_header(ibstream& is, size_t& transactions_count);
+
+/**
+ * @brief Проверяет структуру пула.
+ * @param[in]   data                Бинарное представление пула
+ * @param[in]   size                Размер бинарного представления
+ * @param[out]  transactions_count  Количество транзакций в пуле
+ * @return true, если пул может быть прочитан из данных.
+ */
+bool scan_pool(const void* data, size_t size, size_t& transactions_count);
+
+} // namespace priv
+} // namespace csdb
+
+#endif // _CREDITS_CSDB_PRIVATE_POOL_SCAN_H_INCLUDED_
@@ -0,0 +1,81 @@
+/**
+  * @file pool_tables.h
+  *
+  * Таблицы адресов и валют, общие для форматов \ref Pool::DictionaryFormat и
+  * \ref Pool::ColumnarFormat.
+  */
+
+#pragma once
+#ifndef _CREDITS_CSDB_PRIVATE_POOL_TABLES_H_INCLUDED_
+#define _CREDITS_CSDB_PRIVATE_POOL_TABLES_H_INCLUDED_
+
+#include <unordered_map>
+#include <vector>
+
+#include "binary_streams.h"
+
+namespace csdb {
+namespace priv {
+
+/// Таблица уникальных значений в порядке первого появления.
+template<typename T>
+class value_table
+{
+public:
+  explicit value_table(size_t expected_size)
+  {
+    index_.reserve(expected_size);
+    values_.reserve(expected_size);
+  }
+
+  size_t index(const T& value)
+  {
+    auto res = index_.emplace(value, values_.size());
+    if (res.second) {
+      values_.push_back(&res.first->first);
+    }
+    return res.first->second;
+  }
+
+  size_t size() const noexcept
+  {
+    return values_.size();
+  }
+
+  /// Значения в порядке номеров.
+  ::std::vector<T> values() const
+  {
+    ::std::vector<T> res;
+    res.reserve(values_.size());
+    for (const T* it : values_) {
+      res.push_back(*it);
+    }
+    return res;
+  }
+
+  void put(obstream& os) const
+  {
+    os.put(values_.size());
+    for (const T* it : values_) {
+      os.put(*it);
+    }
+  }
+
+  size_t serialized_size() const
+  {
+    size_t res = obstream::serialized_size(values_.size());
+    for (const T* it : values_) {
+      res += obstream::serialized_size(*it);
+    }
+    return res;
+  }
+
+private:
+  ::std::unordered_map<T, size_t> index_;
+  ::std::vector<const T*> values_;
+};
+
+} // namespace priv
+} // namespace csdb
+
+#endif // _CREDITS_CSDB_PRIVATE_POOL_TABLES_H_INCLUDED_
@@ -0,0 +1,328 @@
+#include "csdb/pool_validator.h"
+
+#include <algorithm>
+
+#include "csdb/csdb.h"
+#include "csdb/pool.h"
+#include "csdb/pool_columns.h"
+#include "parallel.h"
+#include "pool_p.h"
+
+namespace csdb {
+
+namespace {
+
+/// Минимальное количество транзакций на поток при проверке.
+constexpr size_t validate_min_chunk = 1024;
+
+/// Минимальное количество пулов цепочки на поток при загрузке балансов.
+constexpr size_t balance_min_pools = 16;
+
+/// Минимальное количество отправителей на поток при учёте транзакций пула.
+constexpr size_t balance_min_senders = 256;
+
+using SourceIndex = ::std::unordered_map<Address, ::std::vector<size_t>>;
+
+} // namespace
+
+PoolValidator::~PoolValidator()
+{
+}
+
+void PoolValidator::prepare(const Pool&, size_t)
+{
+}
+
+BalanceValidator::BalanceValidator(Storage storage) :
+  storage_(storage)
+{
+}
+
+void BalanceValidator::prepare(const Pool& pool, size_t threads)
+{
+  const size_t count = pool.transactions_count();
+  balances_.clear();
+  debits_.assign(count, 0_c);
+
+  // Номера транзакций каждого отправителя в порядке пула. Части пула группируются
+  // параллельно и объединяются в порядке частей.
+  const size_t chunks = ::csdb::priv::parallel_threads(count, threads, validate_min_chunk);
+  ::std::vector<SourceIndex> parts(chunks);
+  ::csdb::priv::parallel_for(count, chunks, [&](size_t chunk, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      parts[chunk][pool.transaction(i).source()].push_back(i);
+    }
+  });
+  SourceIndex sources = ::std::move(parts[0]);
+  for (size_t chunk = 1; chunk < chunks; ++chunk) {
+    for (auto& it : parts[chunk]) {
+      ::std::vector<size_t>& indexes = sources[it.first];
+      indexes.insert(indexes.end(), it.second.begin(), it.second.end());
+    }
+  }
+
+  ::std::vector<const SourceIndex::value_type*> senders;
+  senders.reserve(sources.size());
+  for (const auto& it : sources) {
+    balances_[it.first];
+    senders.push_back(&it);
+  }
+  load_balances(pool, threads);
+
+  // Транзакции разных отправителей независимы. Сумма транзакций отправителя, принятых
+  // до текущей; отклонённые не учитываются.
+  const size_t sender_chunks = ::csdb::priv::parallel_threads(senders.size(), threads, balance_min_senders);
+  ::csdb::priv::parallel_for(senders.size(), sender_chunks, [&](size_t, size_t begin, size_t end) {
+    for (size_t s = begin; s < end; ++s) {
+      ::std::unordered_map<Currency, Amount> debits;
+      for (size_t i : senders[s]->second) {
+        const Transaction transaction = pool.transaction(i);
+        Amount& debit = debits[transaction.currency()];
+        debits_[i] = debit;
+        if (Valid == check(transaction.amount(), balance(senders[s]->first, transaction.currency()), debit)) {
+          debit += transaction.amount();
+        }
+      }
+    }
+  });
+}
+
+void BalanceValidator::load_balances(const Pool& pool, size_t threads)
+{
+  Storage storage = storage_;
+  if (!storage.isOpen()) {
+    storage = pool.storage();
+  }
+  if (!storage.isOpen()) {
+    storage = ::csdb::defaultStorage();
+  }
+  if ((!storage.isOpen()) || balances_.empty()) {
+    return;
+  }
+
+  // Отправители нумеруются, и части цепочки учитываются по номерам, без копирования адресов.
+  using Part = ::std::vector<::std::unordered_map<Currency, Amount>>;
+  ::std::vector<const Address*> addresses;
+  ::std::unordered_map<Address, size_t> positions;
+  for (const auto& it : balances_) {
+    positions.emplace(it.first, addresses.size());
+    addresses.push_back(&it.first);
+  }
+
+  // Учёт пула цепочки в part; суммы учитываются так же, как в Wallet::get.
+  auto add_pool = [&](Part& part, const PoolColumns& columns, const Pool& loaded) {
+    if (loaded.is_valid()) {
+      for (size_t i = 0; i < loaded.transactions_count(); ++i) {
+        const Transaction t = loaded.transaction(i);
+        const auto source = positions.find(t.source());
+        if (source != positions.end()) {
+          part[source->second][t.currency()] -= t.amount();
+        }
+        const auto target = positions.find(t.target());
+        if (target != positions.end()) {
+          part[target->second][t.currency()] += t.amount();
+        }
+      }
+      return;
+    }
+
+    ::std::vector<Amount> amounts;
+    for (size_t position = 0; position < addresses.size(); ++position) {
+      const size_t index = columns.find_address(*addresses[position]);
+      if (PoolColumns::npos == index) {
+        continue;
+      }
+      if (amounts.empty()) {
+        amounts = columns.amounts();
+      }
+      for (size_t i : columns.find_by_address(index)) {
+        Amount& amount = part[position][columns.currency(columns.currency_index(i))];
+        if (columns.source_index(i) == index) {
+          amount -= amounts[i];
+        }
+        if (columns.target_index(i) == index) {
+          amount += amounts[i];
+        }
+      }
+    }
+  };
+
+  ::std::vector<Part> parts;
+  if (1 == ::csdb::priv::parallel_threads(storage.size(), threads, balance_min_pools)) {
+    // В одном потоке цепочка проходится один раз, без предварительного чтения заголовков.
+    parts.emplace_back(addresses.size());
+    PoolColumns columns;
+    Pool loaded;
+    for (PoolHash hash = storage.last_hash(); storage.pool_load_scan(hash, columns, loaded);
+         hash = loaded.is_valid() ? loaded.previous_hash() : columns.previous_hash()) {
+      add_pool(parts[0], columns, loaded);
+    }
+  } else {
+    // Хеши цепочки читаются по заголовкам пулов, а сами пулы загружаются и учитываются
+    // параллельно, непрерывными частями цепочки. Если заголовок не прочитан, предыдущий хеш
+    // пуст; такой пул не загрузится и при полном чтении.
+    ::std::vector<PoolHash> hashes;
+    size_t cnt;
+    for (PoolHash hash = storage.last_hash(); !hash.is_empty();
+         hash = storage.pool_load_meta(hash, cnt).previous_hash()) {
+      hashes.push_back(hash);
+    }
+
+    const size_t chunks = ::csdb::priv::parallel_threads(hashes.size(), threads, balance_min_pools);
+    parts.assign(chunks, Part(addresses.size()));
+    ::std::vector<size_t> loaded_count(chunks, 0);
+    ::csdb::priv::parallel_for(hashes.size(), chunks, [&](size_t chunk, size_t begin, size_t end) {
+      PoolColumns columns;
+      Pool loaded;
+      for (size_t p = begin; (p < end) && storage.pool_load_scan(hashes[p], columns, loaded); ++p) {
+        add_pool(parts[chunk], columns, loaded);
+        ++loaded_count[chunk];
+      }
+    });
+
+    // Как и при последовательном проходе, учитываются только пулы до первого незагруженного.
+    for (size_t chunk = 0; chunk < chunks; ++chunk) {
+      const size_t begin = ::csdb::priv::parallel_chunk_begin(hashes.size(), chunks, chunk);
+      if (begin + loaded_count[chunk] < ::csdb::priv::parallel_chunk_begin(hashes.size(), chunks, chunk + 1)) {
+        parts.resize(chunk + 1);
+        break;
+      }
+    }
+  }
+
+  for (const Part& part : parts) {
+    for (size_t position = 0; position < addresses.size(); ++position) {
+      auto& balance = balances_[*addresses[position]];
+      for (const auto& it : part[position]) {
+        balance[it.first] += it.second;
+      }
+    }
+  }
+}
+
+Amount BalanceValidator::balance(const Address& source, const Currency& currency) const
+{
+  const auto it = balances_.find(source);
+  if (it != balances_.end()) {
+    const auto amount = it->second.find(currency);
+    if (amount != it->second.end()) {
+      return amount->second;
+    }
+  }
+  return 0_c;
+}
+
+PoolValidator::Verdict BalanceValidator::check(Amount amount, Amount balance, Amount debit)
+{
+  if (amount > balance) {
+    return InsufficientFunds;
+  }
+  if (debit + amount > balance) {
+    return DoubleSpend;
+  }
+  return Valid;
+}
+
+PoolValidator::Verdict BalanceValidator::validate(const Transaction& transaction, size_t index) const
+{
+  return check(transaction.amount(), balance(transaction.source(), transaction.currency()),
+               (index < debits_.size()) ? debits_[index] : 0_c);
+}
+
+void UserFieldValidator::require(user_field_id_t id, UserField::Type type)
+{
+  required_.emplace_back(id, type);
+}
+
+void UserFieldValidator::add_constraint(user_field_id_t id, Constraint constraint)
+{
+  constraints_.emplace_back(id, ::std::move(constraint));
+}
+
+PoolValidator::Verdict UserFieldValidator::validate(const Transaction& transaction, size_t) const
+{
+  for (const auto& it : required_) {
+    const UserField field = transaction.user_field(it.first);
+    if ((!field.is_valid()) || (field.type() != it.second)) {
+      return UserFieldViolation;
+    }
+  }
+  for (const auto& it : constraints_) {
+    const UserField field = transaction.user_field(it.first);
+    if (field.is_valid() && (!it.second(field))) {
+      return UserFieldViolation;
+    }
+  }
+  return Valid;
+}
+
+void PoolValidatorChain::add(::std::shared_ptr<PoolValidator> validator)
+{
+  if (validator) {
+    validators_.push_back(::std::move(validator));
+  }
+}
+
+void PoolValidatorChain::prepare(const Pool& pool, size_t threads)
+{
+  for (const auto& it : validators_) {
+    it->prepare(pool, threads);
+  }
+}
+
+PoolValidator::Verdict PoolValidatorChain::validate(const Transaction& transaction, size_t index) const
+{
+  for (const auto& it : validators_) {
+    const Verdict res = it->validate(transaction, index);
+    if (Valid != res) {
+      return res;
+    }
+  }
+  return Valid;
+}
+
+::std::vector<PoolValidator::Verdict> Pool::validate(PoolValidator& validator, size_t threads) const
+{
+  validator.prepare(*this, threads);
+
+  const PoolValidator& checker = validator;
+  const ::std::vector<Transaction>& transactions = d.constData()->transactions_;
+  ::std::vector<PoolValidator::Verdict> res(transactions.size(), PoolValidator::Valid);
+  threads = ::csdb::priv::parallel_threads(transactions.size(), threads, validate_min_chunk);
+  ::csdb::priv::parallel_for(transactions.size(), threads, [&](size_t, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      res[i] = checker.validate(transactions[i], i);
+    }
+  });
+  return res;
+}
+
+bool Pool::compose(PoolValidator& validator, ::std::vector<PoolValidator::Verdict>* verdicts, size_t threads)
+{
+  if (d.constData()->read_only_) {
+    if (nullptr != verdicts) {
+      verdicts->clear();
+    }
+    return true;
+  }
+
+  if (!d.constData()->is_valid_) {
+    return false;
+  }
+
+  ::std::vector<PoolValidator::Verdict> res = validate(validator, threads);
+  const bool valid = ::std::all_of(res.begin(), res.end(), [](PoolValidator::Verdict verdict) {
+    return PoolValidator::Valid == verdict;
+  });
+  if (nullptr != verdicts) {
+    *verdicts = ::std::move(res);
+  }
+  if (!valid) {
+    return false;
+  }
+
+  d->compose(threads);
+  return true;
+}
+
+} // namespace csdb
@@ -12,18 +12,90 @@ namespace priv {
 #ifndef CSDB_UNIT_TEST
 const size_t crypto::hash_size = cscrypto::Hash::sizeBytes;
 const size_t crypto::public_key_size = cscrypto::PublicKey::sizeBytes;
+static_assert(cscrypto::Hash::sizeBytes <= crypto::max_hash_size, "crypto::max_hash_size is too small.");
+static_assert(cscrypto::PublicKey::sizeBytes <= crypto::max_public_key_size,
+              "crypto::max_public_key_size is too small.");
+static_assert(cscrypto::Hash::sizeBytes == blake2s::digest_size,
+              "crypto::hasher digest size differs from cscrypto::Hash.");
 #else
 const size_t crypto::hash_size = sizeof(size_t);
 const size_t crypto::public_key_size = 20;
 #endif
 
+constexpr size_t crypto::max_hash_size;
+constexpr size_t crypto::max_public_key_size;
+
 internal::byte_array crypto::calc_hash(const internal::byte_array &buffer) noexcept
 {
 #ifndef CSDB_UNIT_TEST
   const cscrypto::Hash result = cscrypto::blake2s(buffer);
   return internal::byte_array(result.bytes.begin(), result.bytes.end());
 #else
-  const size_t result = std::hash<std::string>()( std::string(buffer.begin(), buffer.end()) );
+  return calc_hash(buffer.data(), buffer.size());
+#endif
+}
+
+internal::byte_array crypto::calc_hash(const void *data, size_t size) noexcept
+{
+#ifndef CSDB_UNIT_TEST
+  internal::byte_array res(blake2s::digest_size);
+  blake2s::calc(data, size, res.data());
+  return res;
+#else
+  const size_t result = std::hash<std::string>()( std::string(static_cast<const char*>(data), size) );
+  return internal::byte_array(reinterpret_cast<const uint8_t*>(&result), reinterpret_cast<const uint8_t*>(&result) + hash_size);
+#endif
+}
+
+::std::vector<internal::byte_array> crypto::calc_hashes(const ::std::vector<const internal::byte_array*> &buffers)
+{
+  ::std::vector<const void*> data(buffers.size());
+  ::std::vector<size_t> sizes(buffers.size());
+  for (size_t i = 0; i < buffers.size(); ++i) {
+    data[i] = buffers[i]->data();
+    sizes[i] = buffers[i]->size();
+  }
+  return calc_hashes(data.data(), sizes.data(), buffers.size());
+}
+
+::std::vector<internal::byte_array> crypto::calc_hashes(const void *const *data, const size_t *sizes, size_t count)
+{
+  ::std::vector<internal::byte_array> res;
+  res.reserve(count);
+#ifndef CSDB_UNIT_TEST
+  internal::byte_array digests(count * blake2s::digest_size);
+  blake2s::calc_batch(data, sizes, count, digests.data());
+  for (size_t i = 0; i < count; ++i) {
+    const auto begin = digests.begin() + i * blake2s::digest_size;
+    res.emplace_back(begin, begin + blake2s::digest_size);
+  }
+#else
+  for (size_t i = 0; i < count; ++i) {
+    res.push_back(calc_hash(data[i], sizes[i]));
+  }
+#endif
+  return res;
+}
+
+void crypto::hasher::update(const void *data, size_t size)
+{
+#ifndef CSDB_UNIT_TEST
+  state_.update(data, size);
+#else
+  data_.append(static_cast<const char*>(data), size);
+#endif
+}
+
+internal::byte_array crypto::hasher::finalize()
+{
+#ifndef CSDB_UNIT_TEST
+  internal::byte_array res(blake2s::digest_size);
+  state_.final(res.data());
+  state_.reset();
+  return res;
+#else
+  const size_t result = std::hash<std::string>()(data_);
+  data_.clear();
   return internal::byte_array(reinterpret_cast<const uint8_t*>(&result), reinterpret_cast<const uint8_t*>(&result) + hash_size);
 #endif
 }
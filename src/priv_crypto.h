@@ -8,8 +8,12 @@
 #define _CREDITS_CSDB_PRIVATE_CRYPTO_H_H_INCLUDED_
 
 #include <cinttypes>
+#include <string>
+#include <vector>
 #include "csdb/internal/types.h"
 
+#include "blake2s.h"
+
 namespace csdb {
 namespace priv {
 
@@ -17,7 +21,42 @@ struct crypto
 {
   static const size_t hash_size;
   static const size_t public_key_size;
+
+  /// Ограничения сверху для \ref hash_size и \ref public_key_size, известные на этапе компиляции.
+  static constexpr size_t max_hash_size = 32;
+  static constexpr size_t max_public_key_size = 32;
+
   static internal::byte_array calc_hash(const internal::byte_array &buffer) noexcept;
+  static internal::byte_array calc_hash(const void *data, size_t size) noexcept;
+
+  /**
+   * @brief Хеши нескольких независимых буферов.
+   *
+   * Результат совпадает с вызовом \ref calc_hash для каждого буфера, но буферы хешируются
+   * одновременно (см. \ref blake2s::calc_batch).
+   */
+  static ::std::vector<internal::byte_array> calc_hashes(const ::std::vector<const internal::byte_array*> &buffers);
+  static ::std::vector<internal::byte_array> calc_hashes(const void *const *data, const size_t *sizes, size_t count);
+
+  /**
+   * @brief Инкрементальное вычисление хеша.
+   *
+   * Данные можно подавать частями; результат \ref finalize совпадает с результатом
+   * \ref calc_hash для тех же данных, переданных одним буфером.
+   */
+  class hasher
+  {
+  public:
+    void update(const void *data, size_t size);
+    internal::byte_array finalize();
+
+  private:
+#ifndef CSDB_UNIT_TEST
+    blake2s state_;
+#else
+    ::std::string data_;
+#endif
+  };
 };
 
 } // namespace priv
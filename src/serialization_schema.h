@@ -0,0 +1,219 @@
+/**
+  * @file serialization_schema.h
+  *
+  * Описание формата сериализации класса списком его полей. По списку полей на этапе
+  * компиляции формируются запись, чтение (с проверками и без) и вычисление размера
+  * сериализованного представления, совпадающие с последовательными вызовами
+  * obstream::put / ibstream::get для каждого поля.
+  */
+
+#pragma once
+#ifndef _CREDITS_CSDB_PRIVATE_SERIALIZATION_SCHEMA_H_INCLUDED_
+#define _CREDITS_CSDB_PRIVATE_SERIALIZATION_SCHEMA_H_INCLUDED_
+
+#include <cinttypes>
+#include <type_traits>
+
+#include "csdb/internal/fixed_byte_array.h"
+
+#include "binary_streams.h"
+#include "integral_encdec.h"
+
+namespace csdb {
+namespace priv {
+
+/**
+ * @brief Поле класса, участвующее в сериализации.
+ *
+ * Задаётся указателем на член класса. Для объявления поля удобнее пользоваться макросом
+ * \ref CSDB_SCHEMA_FIELD.
+ */
+template<class C, class T, T C::*Member>
+struct schema_field
+{
+  typedef T type;
+
+  static inline const T& ref(const C& obj) noexcept
+  {
+    return obj.*Member;
+  }
+
+  static inline T& ref(C& obj) noexcept
+  {
+    return obj.*Member;
+  }
+};
+
+#define CSDB_SCHEMA_FIELD(Class, member) \
+  ::csdb::priv::schema_field<Class, decltype(Class::member), &Class::member>
+
+/// Максимальный размер сериализованного значения типа T; 0, если размер не ограничен.
+template<class T, class Enable = void>
+struct max_serialized_size : std::integral_constant<size_t, 0> {};
+
+template<class T>
+struct max_serialized_size<T, typename std::enable_if<std::is_integral<T>::value
+                                                      || std::is_enum<T>::value>::type> :
+  std::integral_constant<size_t, MAX_INTEGRAL_ENCODED_SIZE> {};
+
+template<>
+struct max_serialized_size<bool> : std::integral_constant<size_t, sizeof(uint8_t)> {};
+
+template<size_t N>
+struct max_serialized_size<internal::fixed_byte_array<N>> :
+  std::integral_constant<size_t, MAX_INTEGRAL_ENCODED_SIZE + N> {};
+
+inline constexpr size_t _add_schema_bounds(size_t a, size_t b)
+{
+  return ((0 == a) || (0 == b)) ? 0 : (a + b);
+}
+
+/// Максимальный размер последовательности полей; 0, если размер хотя бы одного не ограничен.
+template<class T>
+inline constexpr size_t _schema_bound()
+{
+  return max_serialized_size<T>::value;
+}
+
+template<class T, class U, class... Rest>
+inline constexpr size_t _schema_bound()
+{
+  return _add_schema_bounds(max_serialized_size<T>::value, _schema_bound<U, Rest...>());
+}
+
+/// true, если все поля - целые числа.
+template<class T>
+inline constexpr bool _schema_integral()
+{
+  return std::is_integral<T>::value || std::is_enum<T>::value;
+}
+
+template<class T, class U, class... Rest>
+inline constexpr bool _schema_integral()
+{
+  return _schema_integral<T>() && _schema_integral<U, Rest...>();
+}
+
+/// true, если все поля можно прочитать одним вызовом \ref decode_batch_unchecked.
+template<class T>
+inline constexpr bool _schema_batch_integral()
+{
+  return _schema_integral<T>() && !std::is_same<T, bool>::value;
+}
+
+template<class T, class U, class... Rest>
+inline constexpr bool _schema_batch_integral()
+{
+  return _schema_batch_integral<T>() && _schema_batch_integral<U, Rest...>();
+}
+
+/**
+ * @brief Формат сериализации класса C - последовательность полей Fields.
+ *
+ * Пример:
+ * \code
+ * class Foo::priv
+ * {
+ *   int32_t a_;
+ *   std::string b_;
+ *   typedef ::csdb::priv::schema<priv,
+ *                                CSDB_SCHEMA_FIELD(priv, a_),
+ *                                CSDB_SCHEMA_FIELD(priv, b_)> serialization_schema;
+ * };
+ *
+ * void Foo::put(::csdb::priv::obstream& os) const
+ * {
+ *   priv::serialization_schema::put(os, *d.constData());
+ * }
+ * \endcode
+ *
+ * Если все поля - целые числа, объект кодируется в буфер на стеке и добавляется в поток
+ * одной операцией, а чтение без проверок (кроме полей типа bool) выполняется одним вызовом
+ * \ref decode_batch_unchecked.
+ *
+ * \ref max_size позволяет заранее оценить размер буфера для объектов, размер которых
+ * ограничен (целые типы и \ref internal::fixed_byte_array).
+ */
+template<class C, class... Fields>
+class schema
+{
+  static_assert(0 < sizeof...(Fields), "Serialization schema must contain at least one field.");
+
+public:
+  /// Максимальный размер сериализованного объекта; 0, если размер не ограничен.
+  static constexpr size_t max_size = _schema_bound<typename Fields::type...>();
+
+  static void put(obstream& os, const C& obj)
+  {
+    put(os, obj, std::integral_constant<bool, _schema_integral<typename Fields::type...>()>());
+  }
+
+  static bool get(ibstream& is, C& obj)
+  {
+    bool res = true;
+    // Элементы списка инициализации вычисляются по порядку; после первой ошибки
+    // оставшиеся поля не читаются.
+    const int order[] = {(res = res && is.get(Fields::ref(obj)), 0)...};
+    (void)order;
+    return res;
+  }
+
+  static void get(unchecked_ibstream& is, C& obj)
+  {
+    get(is, obj, std::integral_constant<bool, _schema_batch_integral<typename Fields::type...>()>());
+  }
+
+  static size_t serialized_size(const C& obj) noexcept
+  {
+    size_t res = 0;
+    const int order[] = {(res += obstream::serialized_size(Fields::ref(obj)), 0)...};
+    (void)order;
+    return res;
+  }
+
+private:
+  static void put(obstream& os, const C& obj, std::false_type)
+  {
+    const int order[] = {(os.put(Fields::ref(obj)), 0)...};
+    (void)order;
+  }
+
+  static void put(obstream& os, const C& obj, std::true_type)
+  {
+    uint8_t buf[max_size];
+    uint8_t* pos = buf;
+    const int order[] = {(pos = write(pos, Fields::ref(obj)), 0)...};
+    (void)order;
+    os.put(buf, static_cast<size_t>(pos - buf));
+  }
+
+  static void get(unchecked_ibstream& is, C& obj, std::false_type)
+  {
+    const int order[] = {(is.get(Fields::ref(obj)), 0)...};
+    (void)order;
+  }
+
+  static void get(unchecked_ibstream& is, C& obj, std::true_type)
+  {
+    uint64_t values[sizeof...(Fields)];
+    is.get_integrals(values, sizeof...(Fields));
+    size_t i = 0;
+    const int order[] = {(Fields::ref(obj) = static_cast<typename Fields::type>(values[i++]), 0)...};
+    (void)order;
+  }
+
+  template<typename T>
+  static inline uint8_t* write(uint8_t* pos, T value)
+  {
+    return pos + encode(pos, value);
+  }
+
+};
+
+template<class C, class... Fields>
+constexpr size_t schema<C, Fields...>::max_size;
+
+} // namespace priv
+} // namespace csdb
+
+#endif // _CREDITS_CSDB_PRIVATE_SERIALIZATION_SCHEMA_H_INCLUDED_
@@ -5,18 +5,31 @@
 #include <algorithm>
 #include <set>
 #include <list>
-#include <map>
+#include <unordered_map>
 #include <deque>
 #include <cassert>
 #include <stdexcept>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
 
 #include "csdb/address.h"
 #include "csdb/wallet.h"
 #include "csdb/pool.h"
+#include "csdb/pool_columns.h"
 #include "csdb/database.h"
 #include "csdb/database_leveldb.h"
 #include "csdb/internal/utils.h"
 #include "binary_streams.h"
+#include "block_compression.h"
+#include "crc32c.h"
+#include "integral_encdec.h"
+#include "pool_format.h"
+#include "pool_merkle.h"
+#include "pool_scan.h"
+#include "priv_crypto.h"
 
 namespace csdb {
 
@@ -29,8 +42,213 @@ struct head_info_t
   PoolHash next_;     // хеш следующего пула, или пустая строка для первого пула
                       // в цепочее (нет родителя, начало цепочки).
 };
-using heads_t = std::map<PoolHash, head_info_t>;
-using tails_t = std::map<PoolHash, PoolHash>;
+using heads_t = std::unordered_map<PoolHash, head_info_t>;
+using tails_t = std::unordered_map<PoolHash, PoolHash>;
+
+/**
+ * Запись пула в базе данных начинается со значения record_marker, за которым следуют способ
+ * хранения (record_codec), для сжатых записей - размер несжатого пула и номер словаря (только для
+ * record_lz_dictionary), затем данные пула. Если в способе хранения установлен флаг
+ * record_crc32c, запись заканчивается контрольной суммой CRC-32C всех предыдущих байт записи
+ * (4 байта, little-endian). Маркер не совпадает ни с длиной хеша предыдущего пула, ни с маркером
+ * формата пула, поэтому записи, сделанные до появления маркера, читаются как пул без изменений.
+ */
+constexpr uint64_t record_marker = 0xC5DC;
+static_assert((record_marker > ::csdb::priv::crypto::max_hash_size)
+              && (record_marker != ::csdb::priv::pool_format_marker),
+              "Record marker must not be a valid pool header.");
+
+enum record_codec : uint8_t {
+  record_plain = 0,
+  record_lz = 1,
+  record_lz_dictionary = 2,
+  record_codec_mask = 0x7F,
+  record_crc32c = 0x80,
+};
+
+constexpr size_t record_checksum_size = sizeof(uint32_t);
+
+/// Ограничения на количество и суммарный размер пулов, хешируемых при открытии за один раз.
+constexpr size_t rescan_batch_size = 64;
+constexpr size_t rescan_batch_bytes = 16 * 1024 * 1024;
+
+/// Фоновая проверка пересоздаёт итератор после стольких записей, чтобы не удерживать снимок базы.
+constexpr size_t scrubber_iterator_records = 1024;
+
+/// Минимальная пауза между проходами фоновой проверки.
+constexpr ::std::chrono::milliseconds scrubber_pass_pause(100);
+
+/// Ключи служебных записей. Не совпадают по длине с хешами пулов.
+const char dictionary_key_prefix[] = "csdb.dictionary";
+
+/// Ключ записи с номером словаря, используемого для сжатия.
+::csdb::internal::byte_array current_dictionary_key()
+{
+  return ::csdb::internal::byte_array(dictionary_key_prefix,
+                                      dictionary_key_prefix + sizeof(dictionary_key_prefix) - 1);
+}
+
+::csdb::internal::byte_array dictionary_key(uint32_t id)
+{
+  ::csdb::internal::byte_array res = current_dictionary_key();
+  res.push_back('.');
+  for (size_t i = 0; i < sizeof(id); ++i) {
+    res.push_back(static_cast<uint8_t>(id >> (i * 8)));
+  }
+  return res;
+}
+
+/// Ключ записи с границей проверенных пулов (см. Storage::IncrementalVerification).
+const char verified_key_name[] = "csdb.verified";
+
+::csdb::internal::byte_array verified_key()
+{
+  return ::csdb::internal::byte_array(verified_key_name, verified_key_name + sizeof(verified_key_name) - 1);
+}
+
+bool is_service_key(const ::csdb::internal::byte_array& key)
+{
+  const ::csdb::internal::byte_array prefix = current_dictionary_key();
+  return ((key.size() >= prefix.size()) && ::std::equal(prefix.begin(), prefix.end(), key.begin()))
+      || (key == verified_key());
+}
+
+/// Поиск записи итератором. В отличие от Database::get, не изменяет последнюю ошибку базы.
+bool seek_value(const Database::IteratorPtr& it, const ::csdb::internal::byte_array& key,
+                ::csdb::internal::byte_array& value)
+{
+  it->seek(key);
+  if ((!it->is_valid()) || (it->key() != key)) {
+    return false;
+  }
+  value = it->value();
+  return true;
+}
+
+/// Граница проверенных пулов: проверены все count пулов с номером не больше sequence.
+struct verified_watermark
+{
+  Pool::sequence_t sequence;
+  size_t count;
+};
+
+::csdb::internal::byte_array put_watermark(const verified_watermark& watermark)
+{
+  ::csdb::priv::obstream os;
+  os.put(watermark.sequence);
+  os.put(watermark.count);
+  return ::std::move(os.buffer());
+}
+
+bool get_watermark(const ::csdb::internal::byte_array& data, verified_watermark& watermark)
+{
+  ::csdb::priv::ibstream is(data);
+  return is.get(watermark.sequence) && is.get(watermark.count);
+}
+
+/// Хеш предыдущего пула и номер пула из заголовка бинарного представления.
+bool get_pool_header(const ::csdb::internal::byte_array& data, PoolHash& previous_hash,
+                     Pool::sequence_t& sequence)
+{
+  ::csdb::priv::ibstream is(data);
+  Pool::Format format;
+  return ::csdb::priv::get_pool_format(is, format) && is.get(previous_hash) && is.get(sequence);
+}
+
+/// Совпадает ли контрольная сумма в конце записи с флагом record_crc32c с остальными байтами.
+bool record_checksum_valid(const ::csdb::internal::byte_array& record)
+{
+  if (record.size() < record_checksum_size) {
+    return false;
+  }
+  const size_t end = record.size() - record_checksum_size;
+  uint32_t crc = 0;
+  for (size_t i = 0; i < record_checksum_size; ++i) {
+    crc |= static_cast<uint32_t>(record[end + i]) << (i * 8);
+  }
+  return ::csdb::priv::crc32c(record.data(), end) == crc;
+}
+
+/// Поиск словаря по номеру. Возвращает nullptr, если словаря нет.
+using dictionary_lookup = ::std::function<const ::csdb::internal::byte_array*(uint32_t id)>;
+
+/**
+ * @brief Бинарное представление пула из записи в базе данных.
+ * @param[out] checksum        Если не nullptr, сюда записывается, была ли в записи контрольная сумма.
+ * @param[in]  verify_checksum Проверять ли контрольную сумму записи.
+ * @return false, если запись повреждена (в том числе, если не совпала контрольная сумма).
+ *
+ * record и pool_data могут быть одним и тем же объектом.
+ */
+bool decode_record(const ::csdb::internal::byte_array& record, ::csdb::internal::byte_array& pool_data,
+                   bool* checksum, const dictionary_lookup& dictionary, bool verify_checksum = true)
+{
+  if (nullptr != checksum) {
+    *checksum = false;
+  }
+
+  ::csdb::priv::ibstream is(record);
+  uint64_t marker;
+  if ((!is.get(marker)) || (record_marker != marker)) {
+    pool_data = record;
+    return true;
+  }
+
+  uint8_t codec;
+  if (!is.get(codec)) {
+    return false;
+  }
+
+  size_t end = record.size();
+  if (0 != (codec & record_crc32c)) {
+    if (is.size() < record_checksum_size) {
+      return false;
+    }
+    end -= record_checksum_size;
+    if (verify_checksum && (!record_checksum_valid(record))) {
+      return false;
+    }
+    if (nullptr != checksum) {
+      *checksum = true;
+    }
+    codec &= record_codec_mask;
+  } else if (record_plain == codec) {
+    return false;
+  }
+
+  if (record_plain == codec) {
+    const size_t begin = record.size() - is.size();
+    if (&record == &pool_data) {
+      pool_data.resize(end);
+      pool_data.erase(pool_data.begin(), pool_data.begin() + begin);
+    } else {
+      pool_data.assign(record.begin() + begin, record.begin() + end);
+    }
+    return true;
+  }
+
+  size_t size;
+  if (!is.get(size)) {
+    return false;
+  }
+
+  const ::csdb::internal::byte_array* dict = nullptr;
+  if (record_lz_dictionary == codec) {
+    uint32_t id;
+    if (!is.get(id) || (nullptr == (dict = dictionary(id)))) {
+      return false;
+    }
+  } else if (record_lz != codec) {
+    return false;
+  }
+
+  const size_t data_size = end - (record.size() - is.size());
+  if (data_size > end) {
+    return false;
+  }
+  return ::csdb::priv::lz_decompress(is.data(), data_size, size,
+                                     (nullptr != dict) ? *dict : ::csdb::internal::byte_array{}, pool_data);
+}
 
 void update_heads_and_tails(heads_t &heads, tails_t &tails, const PoolHash &cur_hash, const PoolHash &prev_hash)
 {
@@ -40,14 +258,16 @@ void update_heads_and_tails(heads_t &heads, tails_t &tails, const PoolHash &cur_
   bool eitt = (tails.end() != itt);
   if (eith && eitt) {
     // Склеиваем две подцепочки.
-    assert(1 == heads.count(itt->second));
-    head_info_t& ith1 = heads[itt->second];
+    // Вставка в tails может вызвать rehash и инвалидировать itt, поэтому копируем значение.
+    const PoolHash head = itt->second;
+    assert(1 == heads.count(head));
+    head_info_t& ith1 = heads[head];
     ith1.next_ = ith->second.next_;
     ith1.len_ += (1 + ith->second.len_);
     if (!ith->second.next_.is_empty()) {
       /// \todo Проверить, почему выпадает assert!
       // assert(1 == tails.count(ith->second.next_));
-      tails[ith->second.next_] = itt->second;
+      tails[ith->second.next_] = head;
     }
     heads.erase(ith);
     // Мы, возможно, уже изменили tails - поэтому нельзя удалять по итератору!
@@ -93,12 +313,63 @@ void update_heads_and_tails(heads_t &heads, tails_t &tails, const PoolHash &cur_
 class Storage::priv
 {
 private:
-  bool rescan(Storage::OpenCallback callback);
+  /// reported - количество пулов, о которых уже сообщено callback при предыдущем проходе.
+  bool rescan(Storage::OpenCallback callback, Storage::Verification verification, uint64_t reported = 0);
 
   std::shared_ptr<Database> db = nullptr;
   PoolHash last_hash;           // Хеш последнего пула
   size_t count_pool = 0;        // Количество пулов транзакций в хранилище (первоночально заполняется в check)
 
+  Storage::Compression compression_ = Storage::NoCompression;
+  ::std::unordered_map<uint32_t, ::csdb::internal::byte_array> dictionaries_; // Загруженные словари
+  ::std::mutex dictionaries_mutex_;  // Словари подгружаются при чтении пулов из разных потоков
+  bool has_dictionary_ = false;
+  uint32_t dictionary_id_ = 0;  // Словарь для записи новых пулов
+
+  size_t load_verification_interval_ = 0;
+  ::std::atomic<size_t> loads_{0};  // Количество пулов, прочитанных из записей с контрольной суммой
+
+  /**
+   * @brief Можно ли взять хеш пула из ключа записи, не вычисляя его.
+   * @param[in] checksum Контрольная сумма записи проверена.
+   *
+   * Каждый load_verification_interval_-й пул всё равно хешируется и сравнивается с ключом.
+   */
+  bool trust_record(bool checksum)
+  {
+    const size_t interval = load_verification_interval_;
+    return checksum && ((0 == interval) || (0 != (++loads_ % interval)));
+  }
+
+  /// Запись пула в базу данных (сжатая, если это выгодно).
+  ::csdb::internal::byte_array make_record(const ::csdb::internal::byte_array& pool_data);
+
+  /// Бинарное представление пула из записи в базе данных (см. decode_record).
+  bool read_record(const ::csdb::internal::byte_array& record, ::csdb::internal::byte_array& pool_data,
+                   bool* checksum = nullptr, bool verify_checksum = true);
+
+  const ::csdb::internal::byte_array* dictionary(uint32_t id);
+
+  /// Служебная запись (см. \ref is_service_key), прочитанная при открытии хранилища.
+  void read_service_record(const ::csdb::internal::byte_array& key, const ::csdb::internal::byte_array& value);
+
+  // Фоновая проверка (см. Storage::start_scrubber).
+  ::std::thread scrubber_;
+  ::std::mutex scrubber_mutex_;
+  ::std::condition_variable scrubber_cv_;
+  bool scrubber_stop_ = false;
+  ::std::atomic<uint64_t> scrubber_passes_{0};
+
+  /// Тело потока фоновой проверки. Поток использует только db и собственный кеш словарей.
+  void scrub(::std::shared_ptr<Database> db, uint64_t bytes_per_second, Storage::ScrubCallback callback);
+
+  /// Ожидание до момента deadline. Возвращает false, если проверку требуется остановить.
+  bool scrubber_wait_until(::std::chrono::steady_clock::time_point deadline);
+
+  void stop_scrubber();
+
+  // Пулы можно читать из нескольких потоков одновременно, поэтому ошибка защищена мьютексом.
+  mutable ::std::mutex error_mutex_;
   Storage::Error last_error_ = Storage::NoError;
   ::std::string last_error_message_;
   void set_last_error(Storage::Error error = Storage::NoError, const ::std::string& message = ::std::string());
@@ -107,36 +378,128 @@ private:
   // TODO: Добавить кеш для хранения последних вычитанных пулов транзакций
 
   friend class ::csdb::Storage;
+
+public:
+  ~priv();
 };
 
+Storage::priv::~priv()
+{
+  stop_scrubber();
+}
+
 void Storage::priv::set_last_error(Storage::Error error, const ::std::string& message)
 {
+  ::std::lock_guard<::std::mutex> lock(error_mutex_);
   last_error_ = error;
   last_error_message_ = message;
 }
 
 void Storage::priv::set_last_error(Storage::Error error, const char* message, ...)
 {
-  last_error_ = error;
+  ::std::string text;
   if (nullptr != message) {
     va_list args1;
     va_start(args1, message);
     va_list args2;
     va_copy(args2, args1);
-    last_error_message_.resize(std::vsnprintf(NULL, 0, message, args1) + 1);
+    text.resize(std::vsnprintf(NULL, 0, message, args1) + 1);
     va_end(args1);
-    std::vsnprintf(&(last_error_message_[0]), last_error_message_.size(), message, args2);
+    std::vsnprintf(&(text[0]), text.size(), message, args2);
     va_end(args2);
-    last_error_message_.resize(last_error_message_.size() - 1);
-  } else {
-    last_error_message_.clear();
+    text.resize(text.size() - 1);
+  }
+
+  ::std::lock_guard<::std::mutex> lock(error_mutex_);
+  last_error_ = error;
+  last_error_message_ = ::std::move(text);
+}
+
+const ::csdb::internal::byte_array* Storage::priv::dictionary(uint32_t id)
+{
+  // Элементы не удаляются до повторного открытия, поэтому указатель остаётся действительным.
+  ::std::lock_guard<::std::mutex> lock(dictionaries_mutex_);
+  auto it = dictionaries_.find(id);
+  if (it != dictionaries_.end()) {
+    return &it->second;
+  }
+
+  ::csdb::internal::byte_array data;
+  if (!db->get(dictionary_key(id), &data)) {
+    return nullptr;
+  }
+  return &dictionaries_.emplace(id, ::std::move(data)).first->second;
+}
+
+void Storage::priv::read_service_record(const ::csdb::internal::byte_array& key,
+                                        const ::csdb::internal::byte_array& value)
+{
+  const ::csdb::internal::byte_array current = current_dictionary_key();
+  if (key == current) {
+    ::csdb::priv::ibstream is(value);
+    has_dictionary_ = is.get(dictionary_id_);
+    return;
+  }
+
+  if (key.size() == current.size() + 1 + sizeof(uint32_t)) {
+    uint32_t id = 0;
+    for (size_t i = 0; i < sizeof(id); ++i) {
+      id |= static_cast<uint32_t>(key[current.size() + 1 + i]) << (i * 8);
+    }
+    dictionaries_[id] = value;
+  }
+}
+
+::csdb::internal::byte_array Storage::priv::make_record(const ::csdb::internal::byte_array& pool_data)
+{
+  uint8_t codec = record_plain;
+  ::csdb::internal::byte_array compressed;
+  if (Storage::NoCompression != compression_) {
+    const bool use_dictionary = (Storage::DictionaryCompression == compression_) && has_dictionary_;
+    ::csdb::priv::obstream os;
+    os.put(pool_data.size());
+    if (use_dictionary) {
+      os.put(dictionary_id_);
+    }
+
+    const ::csdb::internal::byte_array data = ::csdb::priv::lz_compress(
+          pool_data.data(), pool_data.size(),
+          use_dictionary ? *dictionary(dictionary_id_) : ::csdb::internal::byte_array{});
+    if (os.buffer().size() + data.size() < pool_data.size()) {
+      codec = use_dictionary ? record_lz_dictionary : record_lz;
+      os.put(data.data(), data.size());
+      compressed = ::std::move(os.buffer());
+    }
   }
+
+  const ::csdb::internal::byte_array& payload = (record_plain == codec) ? pool_data : compressed;
+  ::csdb::priv::obstream os;
+  os.reserve(2 * ::csdb::priv::MAX_INTEGRAL_ENCODED_SIZE + payload.size() + record_checksum_size);
+  os.put(record_marker);
+  os.put(static_cast<uint8_t>(codec | record_crc32c));
+  os.put(payload.data(), payload.size());
+
+  ::csdb::internal::byte_array& res = os.buffer();
+  const uint32_t crc = ::csdb::priv::crc32c(res.data(), res.size());
+  for (size_t i = 0; i < record_checksum_size; ++i) {
+    res.push_back(static_cast<uint8_t>(crc >> (i * 8)));
+  }
+  return ::std::move(res);
+}
+
+bool Storage::priv::read_record(const ::csdb::internal::byte_array& record,
+                                ::csdb::internal::byte_array& pool_data, bool* checksum, bool verify_checksum)
+{
+  return decode_record(record, pool_data, checksum, [this](uint32_t id) { return dictionary(id); },
+                       verify_checksum);
 }
 
-bool Storage::priv::rescan(Storage::OpenCallback callback)
+bool Storage::priv::rescan(Storage::OpenCallback callback, Storage::Verification verification, uint64_t reported)
 {
   last_hash = {};
   count_pool = 0;
+  dictionaries_.clear();
+  has_dictionary_ = false;
 
   heads_t heads;
   tails_t tails;
@@ -144,48 +507,147 @@ bool Storage::priv::rescan(Storage::OpenCallback callback)
   Database::IteratorPtr it = db->new_iterator();
   assert(it);
 
+  // Граница проверенных пулов, сохранённая при предыдущем открытии. Служебные записи
+  // могут идти после записей пулов, поэтому граница читается до просмотра.
+  verified_watermark watermark{0, 0};
+  ::csdb::internal::byte_array watermark_data;
+  const bool incremental = (Storage::IncrementalVerification == verification)
+      && seek_value(it, verified_key(), watermark_data) && get_watermark(watermark_data, watermark);
+  size_t watermark_count = 0;   // Количество пулов в пределах границы
+  Pool::sequence_t max_sequence = 0;
+
   Storage::OpenProgress progress{0};
+
+  // Хеши записей вычисляются пачками (см. crypto::calc_hashes), после чего записи
+  // проверяются в порядке чтения. Записи с проверенной контрольной суммой (кроме режима
+  // FullVerification) и пулы в пределах границы в режиме IncrementalVerification не хешируются.
+  struct batch_item
+  {
+    ::csdb::internal::byte_array key;
+    ::csdb::internal::byte_array value;
+    PoolHash previous_hash;
+    bool trusted;
+  };
+  ::std::vector<batch_item> batch;
+  size_t batch_bytes = 0;
+  auto process_batch = [&]() -> bool {
+    ::std::vector<const void*> data;
+    ::std::vector<size_t> sizes;
+    for (const auto& item : batch) {
+      if (!item.trusted) {
+        data.push_back(item.value.data());
+        sizes.push_back(::csdb::priv::pool_hashed_size(item.value.data(), item.value.size()));
+      }
+    }
+    const ::std::vector<::csdb::internal::byte_array> hashes =
+        ::csdb::priv::crypto::calc_hashes(data.data(), sizes.data(), data.size());
+
+    auto next_hash = hashes.begin();
+    for (const auto& item : batch) {
+      const ::csdb::internal::byte_array& k = item.key;
+      const ::csdb::internal::byte_array& v = item.value;
+
+      PoolHash hash = PoolHash::from_binary(k);
+      if(hash.is_empty())
+      {
+        set_last_error(Storage::DataIntegrityError, "Data integrity error: key '%s' is not a valid hash value",
+                       ::csdb::internal::to_hex(k).c_str());
+        return false;
+      }
+
+      // Для проверенных записей достаточно хеша предыдущего пула из заголовка.
+      if (!item.trusted) {
+        // Хеш в ключе совпадает с реальным хешем блока?
+        PoolHash real_hash = PoolHash::from_binary(*(next_hash++));
+        if(hash != real_hash)
+        {
+          set_last_error(Storage::DataIntegrityError, "Data integrity error: key does not match real hash "
+                         "(key: '%s'; real hash: '%s')", hash.to_string().c_str(), real_hash.to_string().c_str());
+          return false;
+        }
+
+        Pool p = Pool::from_binary(v);
+        if(!p.is_valid())
+        {
+          set_last_error(Storage::DataIntegrityError, "Data integrity error: Corrupted pool for key '%s'.",
+                         hash.to_string().c_str());
+          return false;
+        }
+      }
+
+      update_heads_and_tails(heads, tails, hash, item.previous_hash);
+      count_pool++;
+      progress.poolsProcessed++;
+      if ((nullptr != callback) && (progress.poolsProcessed > reported)) {
+        if(callback(progress)) {
+          set_last_error(Storage::UserCancelled);
+          return false;
+        }
+      }
+    }
+
+    batch.clear();
+    batch_bytes = 0;
+    return true;
+  };
+
   for(it->seek_to_first(); it->is_valid(); it->next())
   {
-    const ::csdb::internal::byte_array k = it->key();
-    const ::csdb::internal::byte_array v = it->value();
+    ::csdb::internal::byte_array k = it->key();
+    if (is_service_key(k)) {
+      read_service_record(k, it->value());
+      continue;
+    }
 
-    PoolHash hash = PoolHash::from_binary(k);
-    if(hash.is_empty())
-    {
-      set_last_error(Storage::DataIntegrityError, "Data integrity error: key '%s' is not a valid hash value",
+    // В режиме IncrementalVerification контрольная сумма проверяется только после того, как
+    // по заголовку станет ясно, что пул не входит в проверенные.
+    const ::csdb::internal::byte_array record = it->value();
+    ::csdb::internal::byte_array v;
+    bool checksum;
+    PoolHash previous_hash;
+    Pool::sequence_t sequence;
+    bool valid = read_record(record, v, &checksum, !incremental) && get_pool_header(v, previous_hash, sequence);
+    bool trusted = false;
+    if (valid && incremental && (sequence <= watermark.sequence)) {
+      trusted = true;
+      ++watermark_count;
+    } else if (valid) {
+      if (incremental && checksum) {
+        valid = record_checksum_valid(record);
+      }
+      trusted = checksum && (Storage::FullVerification != verification);
+    }
+    if (!valid) {
+      if (!process_batch()) {
+        return false;
+      }
+      set_last_error(Storage::DataIntegrityError, "Data integrity error: Corrupted record for key '%s'.",
                      ::csdb::internal::to_hex(k).c_str());
       return false;
     }
 
-    // Хеш в ключе совпадает с реальным хешем блока?
-    PoolHash real_hash = PoolHash::calc_from_data(v);
-    if(hash != real_hash)
-    {
-      set_last_error(Storage::DataIntegrityError, "Data integrity error: key does not match real hash "
-                     "(key: '%s'; real hash: '%s')", hash.to_string().c_str(), real_hash.to_string().c_str());
-      return false;
+    max_sequence = ::std::max(max_sequence, sequence);
+    if (!trusted) {
+      batch_bytes += v.size();
     }
-
-    Pool p = Pool::from_binary(v);
-    if(!p.is_valid())
-    {
-      set_last_error(Storage::DataIntegrityError, "Data integrity error: Corrupted pool for key '%s'.",
-                     hash.to_string().c_str());
+    batch.push_back(batch_item{::std::move(k), ::std::move(v), previous_hash, trusted});
+    if (((rescan_batch_size <= batch.size()) || (rescan_batch_bytes <= batch_bytes)) && (!process_batch())) {
       return false;
     }
+  }
+  if (!process_batch()) {
+    return false;
+  }
 
-    update_heads_and_tails(heads, tails, hash, p.previous_hash());
-    count_pool++;
-    progress.poolsProcessed++;
-    if (nullptr != callback) {
-      if(callback(progress)) {
-        set_last_error(Storage::UserCancelled);
-        return false;
-      }
-    }
+  if (incremental && (watermark_count != watermark.count)) {
+    // После предыдущего открытия в пределах границы появились пулы, которые могли быть
+    // приняты за проверенные. Хранилище проверяется заново; о пулах, уже сообщённых
+    // callback, повторно не сообщается.
+    return rescan(callback, Storage::ChecksumVerification, ::std::max(reported, progress.poolsProcessed));
   }
 
+  has_dictionary_ = has_dictionary_ && (0 != dictionaries_.count(dictionary_id_));
+
   // Посмотрим, сколько у нас завершённых цепочек.
   if([this, &heads]() -> bool {
       for(const auto it : heads)
@@ -200,6 +662,12 @@ bool Storage::priv::rescan(Storage::OpenCallback callback)
       }
       return true;
     }()) {
+    // Теперь проверены все пулы хранилища. Ошибка записи границы не мешает открытию.
+    const verified_watermark checked{max_sequence, count_pool};
+    if ((0 != count_pool) && ((!incremental) || (checked.sequence != watermark.sequence)
+                              || (checked.count != watermark.count))) {
+      db->put(verified_key(), put_watermark(checked));
+    }
     set_last_error();
     return true;
   }
@@ -221,6 +689,127 @@ bool Storage::priv::rescan(Storage::OpenCallback callback)
   return false;
 }
 
+bool Storage::priv::scrubber_wait_until(::std::chrono::steady_clock::time_point deadline)
+{
+  ::std::unique_lock<::std::mutex> lock(scrubber_mutex_);
+  return !scrubber_cv_.wait_until(lock, deadline, [this]() { return scrubber_stop_; });
+}
+
+void Storage::priv::stop_scrubber()
+{
+  if (!scrubber_.joinable()) {
+    return;
+  }
+  {
+    ::std::lock_guard<::std::mutex> lock(scrubber_mutex_);
+    scrubber_stop_ = true;
+  }
+  scrubber_cv_.notify_all();
+  scrubber_.join();
+}
+
+void Storage::priv::scrub(::std::shared_ptr<Database> db, uint64_t bytes_per_second,
+                          Storage::ScrubCallback callback)
+{
+  using clock = ::std::chrono::steady_clock;
+
+  // Словари не изменяются после записи, поэтому загруженные однажды остаются верными.
+  ::std::unordered_map<uint32_t, ::csdb::internal::byte_array> dictionaries;
+  const dictionary_lookup dictionary = [&](uint32_t id) -> const ::csdb::internal::byte_array* {
+    auto it = dictionaries.find(id);
+    if (it != dictionaries.end()) {
+      return &it->second;
+    }
+    Database::IteratorPtr di = db->new_scan_iterator();
+    ::csdb::internal::byte_array data;
+    if ((!di) || (!seek_value(di, dictionary_key(id), data))) {
+      return nullptr;
+    }
+    return &dictionaries.emplace(id, ::std::move(data)).first->second;
+  };
+
+  auto report = [&callback](const PoolHash& hash, const ::std::string& message) {
+    if (callback) {
+      callback(hash, message);
+    }
+  };
+
+  auto verify = [&](const ::csdb::internal::byte_array& key, const ::csdb::internal::byte_array& value) {
+    const PoolHash hash = PoolHash::from_binary(key);
+    if (hash.is_empty()) {
+      report(hash, "Data integrity error: key '" + ::csdb::internal::to_hex(key) + "' is not a valid hash value");
+      return;
+    }
+
+    ::csdb::internal::byte_array data;
+    if (!decode_record(value, data, nullptr, dictionary)) {
+      report(hash, "Data integrity error: Corrupted record for key '" + hash.to_string() + "'.");
+      return;
+    }
+
+    const PoolHash real_hash = PoolHash::from_binary(::csdb::priv::crypto::calc_hash(
+          data.data(), ::csdb::priv::pool_hashed_size(data.data(), data.size())));
+    if (hash != real_hash) {
+      report(hash, "Data integrity error: key does not match real hash (key: '" + hash.to_string()
+             + "'; real hash: '" + real_hash.to_string() + "')");
+      return;
+    }
+
+    if (!Pool::from_binary(data).is_valid()) {
+      report(hash, "Data integrity error: Corrupted pool for key '" + hash.to_string() + "'.");
+    }
+  };
+
+  // Прочитанный объём не должен опережать bytes_per_second * (время с начала проверки).
+  const clock::time_point start = clock::now();
+  uint64_t bytes = 0;
+
+  ::csdb::internal::byte_array last_key;
+  bool has_last_key = false;
+  for (;;) {
+    Database::IteratorPtr it = db->new_scan_iterator();
+    if (!it) {
+      return;
+    }
+    if (has_last_key) {
+      it->seek(last_key);
+      if (it->is_valid() && (it->key() == last_key)) {
+        it->next();
+      }
+    } else {
+      it->seek_to_first();
+    }
+
+    size_t records = 0;
+    for (; it->is_valid() && (records < scrubber_iterator_records); it->next(), ++records) {
+      last_key = it->key();
+      has_last_key = true;
+      const ::csdb::internal::byte_array value = it->value();
+      if (!is_service_key(last_key)) {
+        verify(last_key, value);
+      }
+
+      clock::time_point deadline;
+      if (0 != bytes_per_second) {
+        bytes += last_key.size() + value.size();
+        deadline = start + ::std::chrono::duration_cast<clock::duration>(
+              ::std::chrono::duration<double>(static_cast<double>(bytes) / bytes_per_second));
+      }
+      if (!scrubber_wait_until(deadline)) {
+        return;
+      }
+    }
+
+    if (!it->is_valid()) {
+      has_last_key = false;
+      ++scrubber_passes_;
+      if (!scrubber_wait_until(clock::now() + scrubber_pass_pause)) {
+        return;
+      }
+    }
+  }
+}
+
 Storage::Storage() :
   d(::std::make_shared<priv>())
 {
@@ -245,15 +834,21 @@ Storage::WeakPtr Storage::weak_ptr() const noexcept
 
 Storage::Error Storage::last_error() const
 {
+  ::std::lock_guard<::std::mutex> lock(d->error_mutex_);
   return d->last_error_;
 }
 
 ::std::string Storage::last_error_message() const
 {
-  if (!d->last_error_message_.empty()) {
-    return d->last_error_message_;
+  Error error;
+  {
+    ::std::lock_guard<::std::mutex> lock(d->error_mutex_);
+    if (!d->last_error_message_.empty()) {
+      return d->last_error_message_;
+    }
+    error = d->last_error_;
   }
-  switch (d->last_error_) {
+  switch (error) {
   case NoError: return "No error";
   case NotOpen: return "Storage is not open";
   case DatabaseError: return "Database error: " + db_last_error_message();
@@ -295,7 +890,7 @@ bool Storage::open(const OpenOptions &opt, OpenCallback callback)
     return false;
   }
 
-  if(!d->rescan(callback)) {
+  if(!d->rescan(callback, opt.verification)) {
     d->db.reset();
     return false;
   }
@@ -319,6 +914,7 @@ bool Storage::open(const ::std::string& path_to_base, OpenCallback callback)
 
 void Storage::close()
 {
+  d->stop_scrubber();
   d->db.reset();
   d->set_last_error();
 }
@@ -338,6 +934,132 @@ size_t Storage::size() const noexcept
   return d->count_pool;
 }
 
+void Storage::set_compression(Compression compression) noexcept
+{
+  d->compression_ = compression;
+}
+
+Storage::Compression Storage::compression() const noexcept
+{
+  return d->compression_;
+}
+
+void Storage::set_load_verification_interval(size_t interval) noexcept
+{
+  d->load_verification_interval_ = interval;
+  d->loads_ = 0;
+}
+
+size_t Storage::load_verification_interval() const noexcept
+{
+  return d->load_verification_interval_;
+}
+
+bool Storage::train_compression_dictionary(size_t pools_count, size_t max_size)
+{
+  if (!isOpen()) {
+    d->set_last_error(NotOpen);
+    return false;
+  }
+
+  // В скольких пулах встречается каждый адрес.
+  ::std::unordered_map<Address, size_t> frequency;
+  PoolHash hash = d->last_hash;
+  for (size_t i = 0; (i < pools_count) && (!hash.is_empty()); ++i) {
+    const PoolColumns columns = pool_load_columns(hash);
+    if (!columns.is_valid()) {
+      return false;
+    }
+    for (size_t a = 0; a < columns.addresses_count(); ++a) {
+      ++frequency[columns.address(a)];
+    }
+    hash = columns.previous_hash();
+  }
+
+  ::std::vector<::std::pair<size_t, Address>> addresses;
+  for (const auto& it : frequency) {
+    if (it.second > 1) {
+      addresses.emplace_back(it.second, it.first);
+    }
+  }
+  ::std::sort(addresses.begin(), addresses.end(),
+              [](const ::std::pair<size_t, Address>& a, const ::std::pair<size_t, Address>& b) {
+    return (a.first > b.first) || ((a.first == b.first) && (a.second < b.second));
+  });
+
+  size_t count = 0;
+  size_t size = 0;
+  max_size = ::std::min<size_t>(max_size, ::csdb::priv::lz_max_offset);
+  for (; count < addresses.size(); ++count) {
+    const size_t address_size = ::csdb::priv::obstream::serialized_size(addresses[count].second);
+    if (size + address_size > max_size) {
+      break;
+    }
+    size += address_size;
+  }
+  if (0 == count) {
+    d->set_last_error(InvalidParameter, "%s: Not enough data to build a dictionary", __func__);
+    return false;
+  }
+
+  // Адреса записываются в том же виде, что и в пулах. Самые частые - в конце словаря,
+  // ближе всего к сжимаемым данным.
+  ::csdb::priv::obstream os;
+  for (size_t i = count; i > 0; --i) {
+    os.put(addresses[i - 1].second);
+  }
+
+  const ::csdb::internal::byte_array hash_value = ::csdb::priv::crypto::calc_hash(os.buffer());
+  uint32_t id = 0;
+  for (size_t i = 0; i < sizeof(id); ++i) {
+    id |= static_cast<uint32_t>(hash_value[i]) << (i * 8);
+  }
+  ::csdb::priv::obstream current;
+  current.put(id);
+  if (!d->db->put(dictionary_key(id), os.buffer()) || !d->db->put(current_dictionary_key(), current.buffer())) {
+    d->set_last_error(DatabaseError);
+    return false;
+  }
+
+  {
+    ::std::lock_guard<::std::mutex> lock(d->dictionaries_mutex_);
+    d->dictionaries_[id] = os.buffer();
+  }
+  d->dictionary_id_ = id;
+  d->has_dictionary_ = true;
+  d->set_last_error();
+  return true;
+}
+
+bool Storage::start_scrubber(uint64_t bytes_per_second, ScrubCallback callback)
+{
+  if (!isOpen()) {
+    d->set_last_error(NotOpen);
+    return false;
+  }
+
+  if (d->scrubber_.joinable()) {
+    d->set_last_error(InvalidParameter, "%s: Scrubber is already running", __func__);
+    return false;
+  }
+
+  d->scrubber_stop_ = false;
+  d->scrubber_passes_ = 0;
+  d->scrubber_ = ::std::thread(&priv::scrub, d.get(), d->db, bytes_per_second, ::std::move(callback));
+  d->set_last_error();
+  return true;
+}
+
+void Storage::stop_scrubber()
+{
+  d->stop_scrubber();
+}
+
+uint64_t Storage::scrubber_passes() const noexcept
+{
+  return d->scrubber_passes_;
+}
+
 bool Storage::pool_save(Pool pool)
 {
   if (!isOpen()) {
@@ -363,7 +1085,7 @@ bool Storage::pool_save(Pool pool)
     return false;
   }
 
-  d->db->put(hash.to_binary(), pool.to_binary());
+  d->db->put(hash.to_binary(), d->make_record(pool.to_binary()));
 
   d->count_pool++;
   if (d->last_hash == pool.previous_hash()) {
@@ -373,6 +1095,65 @@ bool Storage::pool_save(Pool pool)
   return true;
 }
 
+bool Storage::pool_save_batch(const ::std::vector<::csdb::internal::byte_array>& pools)
+{
+  if (!isOpen()) {
+    d->set_last_error(NotOpen);
+    return false;
+  }
+
+  ::std::vector<PoolHash> previous_hashes(pools.size());
+  ::std::vector<const void*> data(pools.size());
+  ::std::vector<size_t> sizes(pools.size());
+  for (size_t i = 0; i < pools.size(); ++i) {
+    size_t cnt;
+    Pool::Format format;
+    ::csdb::priv::ibstream is(pools[i]);
+    if ((!::csdb::priv::scan_pool(pools[i].data(), pools[i].size(), cnt))
+        || (!::csdb::priv::get_pool_format(is, format)) || (!is.get(previous_hashes[i]))) {
+      d->set_last_error(InvalidParameter, "%s: Invalid pool passed [index: %zu]", __func__, i);
+      return false;
+    }
+    // Хеш пула в формате MerkleFormat покрывает только заголовок, поэтому соответствие
+    // транзакций корню дерева проверяется полным чтением пула.
+    if ((Pool::MerkleFormat == format) && (!Pool::from_binary(pools[i]).is_valid())) {
+      d->set_last_error(InvalidParameter, "%s: Merkle root mismatch [index: %zu]", __func__, i);
+      return false;
+    }
+    data[i] = pools[i].data();
+    sizes[i] = ::csdb::priv::pool_hashed_size(pools[i].data(), pools[i].size());
+  }
+
+  const ::std::vector<::csdb::internal::byte_array> hashes =
+      ::csdb::priv::crypto::calc_hashes(data.data(), sizes.data(), pools.size());
+
+  Database::ItemList items;
+  items.reserve(pools.size());
+  ::std::set<::csdb::internal::byte_array> unique_hashes;
+  for (size_t i = 0; i < pools.size(); ++i) {
+    if ((!unique_hashes.insert(hashes[i]).second) || d->db->get(hashes[i])) {
+      d->set_last_error(InvalidParameter, "%s: Pool already present [hash: %s]", __func__,
+                        ::csdb::internal::to_hex(hashes[i]).c_str());
+      return false;
+    }
+    items.emplace_back(hashes[i], d->make_record(pools[i]));
+  }
+
+  if (!d->db->write_batch(items)) {
+    d->set_last_error(DatabaseError);
+    return false;
+  }
+
+  for (size_t i = 0; i < pools.size(); ++i) {
+    d->count_pool++;
+    if (d->last_hash == previous_hashes[i]) {
+      d->last_hash = PoolHash::from_binary(hashes[i]);
+    }
+  }
+  d->set_last_error();
+  return true;
+}
+
 Pool Storage::pool_load(const PoolHash &hash) const
 {
   if (!isOpen()) {
@@ -392,7 +1173,19 @@ Pool Storage::pool_load(const PoolHash &hash) const
     return Pool{};
   }
 
-  Pool res = Pool::from_binary(data);
+  Pool res;
+  bool checksum;
+  if (d->read_record(data, data, &checksum)) {
+    if (d->trust_record(checksum)) {
+      // Запись не повреждена, хеш пула берётся из ключа.
+      res = Pool::from_binary(::std::move(data), hash);
+    } else {
+      res = Pool::from_binary(data);
+      if (res.is_valid() && (res.hash() != hash)) {
+        res = Pool{};
+      }
+    }
+  }
   if (!res.is_valid()) {
     d->set_last_error(DataIntegrityError, "%s: Error decoding pool [hash: %s]", __func__, hash.to_string().c_str());
   }
@@ -421,7 +1214,10 @@ Pool Storage::pool_load_meta(const PoolHash &hash, size_t& cnt) const
 		return Pool{};
 	}
 
-	Pool res = Pool::meta_from_binary(data, cnt);
+	Pool res;
+	if (d->read_record(data, data)) {
+		res = Pool::meta_from_binary(data, cnt);
+	}
 	if (!res.is_valid()) {
 		d->set_last_error(DataIntegrityError, "%s: Error decoding pool [hash: %s]", __func__, hash.to_string().c_str());
 	}
@@ -432,6 +1228,70 @@ Pool Storage::pool_load_meta(const PoolHash &hash, size_t& cnt) const
 	return res;
 }
 
+PoolColumns Storage::pool_load_columns(const PoolHash &hash) const
+{
+  PoolColumns res;
+  Pool pool;
+  if (pool_load_scan(hash, res, pool) && pool.is_valid()) {
+    res = PoolColumns(pool);
+  }
+  return res;
+}
+
+bool Storage::pool_load_scan(const PoolHash &hash, PoolColumns &columns, Pool &pool) const
+{
+  columns = PoolColumns{};
+  pool = Pool{};
+
+  if (!isOpen()) {
+    d->set_last_error(NotOpen);
+    return false;
+  }
+
+  if(hash.is_empty())
+  {
+    d->set_last_error(InvalidParameter, "%s: Empty hash passed", __func__);
+    return false;
+  }
+
+  ::csdb::internal::byte_array data;
+  if (!d->db->get(hash.to_binary(), &data)) {
+    d->set_last_error(DatabaseError);
+    return false;
+  }
+
+  bool checksum;
+  if (d->read_record(data, data, &checksum)) {
+    ::csdb::priv::ibstream is(data);
+    Pool::Format format = Pool::LegacyFormat;
+    const bool columnar = ::csdb::priv::get_pool_format(is, format) && (Pool::ColumnarFormat == format);
+    // Хеш пула берётся из ключа или проверяется так же, как в pool_load.
+    if (d->trust_record(checksum)) {
+      if (columnar) {
+        columns = PoolColumns::from_binary(::std::move(data), hash);
+      } else {
+        pool = Pool::from_binary(::std::move(data), hash);
+      }
+    } else {
+      Pool res = Pool::from_binary(data);
+      if (res.is_valid() && (res.hash() == hash)) {
+        if (columnar) {
+          columns = PoolColumns(res);
+        } else {
+          pool = res;
+        }
+      }
+    }
+  }
+  if ((!columns.is_valid()) && (!pool.is_valid())) {
+    d->set_last_error(DataIntegrityError, "%s: Error decoding pool [hash: %s]", __func__, hash.to_string().c_str());
+    return false;
+  }
+
+  d->set_last_error();
+  return true;
+}
+
 Wallet Storage::wallet(const Address &addr) const
 {
   return Wallet::get(addr);
@@ -442,67 +1302,59 @@ std::vector<Transaction> Storage::transactions(const Address &addr, size_t limit
   std::vector<Transaction> res;
   res.reserve(limit);
 
+  // Транзакции текущего пула с индексом не меньше end уже просмотрены.
+  PoolColumns curColumns;
   Pool curPool;
-  TransactionID::sequence_t curIdx = 0;
-
-  auto seekIt = [this, &curPool, &curIdx](const TransactionID &id) -> bool {
-    if(id.is_valid())
-    {
-      curPool = pool_load(id.pool_hash());
-      if(curPool.is_valid() && id.index() < curPool.transactions_count())
-      {
-        curIdx = id.index();
-        return true;
-      }
-    }
-    return false;
-  };
+  size_t end = 0;
+  if(offset.is_valid())
+  {
+    if(!pool_load_scan(offset.pool_hash(), curColumns, curPool))
+      return res;
+    const size_t count = curPool.is_valid() ? curPool.transactions_count() : curColumns.transactions_count();
+    if(offset.index() >= count)
+      return res;
+    end = static_cast<size_t>(offset.index());
+  }
+  else
+  {
+    if(!pool_load_scan(last_hash(), curColumns, curPool))
+      return res;
+    end = curPool.is_valid() ? curPool.transactions_count() : curColumns.transactions_count();
+  }
 
-  auto nextIt = [this, &curPool, &curIdx]() -> bool {
+  while(res.size() < limit)
+  {
+    PoolHash previous;
     if(curPool.is_valid())
     {
-      if(curIdx)
-      {
-        curIdx--;
-        return true;
-      }
-      else
+      for(size_t i = end; i > 0 && res.size() < limit; --i)
       {
-		  do {
-			  curPool = pool_load(curPool.previous_hash());
-		  } while (curPool.is_valid() && !(curPool.transactions_count()));
-        if(curPool.is_valid())
-        {
-          curIdx = static_cast<TransactionID::sequence_t>(curPool.transactions_count() - 1);
-          return true;
-        }
+        const Transaction t = curPool.transaction(i - 1);
+        if(t.source() == addr || t.target() == addr)
+          res.push_back(t);
       }
+      previous = curPool.previous_hash();
     }
     else
     {
-      curPool = pool_load(last_hash());
-	  while (curPool.is_valid() && !(curPool.transactions_count())) {
-		  curPool = pool_load(curPool.previous_hash());
-	  }
-
-      if(curPool.is_valid())
+      const std::vector<size_t> matches = curColumns.find_by_address(curColumns.find_address(addr));
+      auto it = std::lower_bound(matches.begin(), matches.end(), end);
+      if(it != matches.begin())
       {
-        curIdx = static_cast<TransactionID::sequence_t>(curPool.transactions_count() - 1);
-        return true;
+        // Пул декодируется целиком, только если в нём есть транзакции с этим адресом.
+        const Pool pool = curColumns.pool();
+        while(it != matches.begin() && res.size() < limit)
+        {
+          --it;
+          res.push_back(pool.transaction(*it));
+        }
       }
+      previous = curColumns.previous_hash();
     }
-    return false;
-  };
-
-  if(offset.is_valid())
-    if(!seekIt(offset))
-      return res;
 
-  while(res.size() < limit && nextIt())
-  {
-    const Transaction t = curPool.transaction(curIdx);
-    if((t.source() == addr) || (t.target() == addr))
-      res.push_back(t);
+    if(!pool_load_scan(previous, curColumns, curPool))
+      break;
+    end = curPool.is_valid() ? curPool.transactions_count() : curColumns.transactions_count();
   }
 
   return res;
@@ -520,15 +1372,22 @@ Transaction Storage::transaction(const TransactionID &id) const
 
 Transaction Storage::get_last_by_source(Address source) const noexcept
 {
-  Pool curr = pool_load(last_hash());
-
-  while (curr.is_valid())
+  PoolColumns columns;
+  Pool pool;
+  for (PoolHash hash = last_hash(); pool_load_scan(hash, columns, pool);
+       hash = pool.is_valid() ? pool.previous_hash() : columns.previous_hash())
   {
-    const auto& t = curr.get_last_by_source(source);
-    if (t.is_valid())
-      return t;
+    if (pool.is_valid())
+    {
+      const Transaction t = pool.get_last_by_source(source);
+      if (t.is_valid())
+        return t;
+      continue;
+    }
 
-    curr = pool_load(curr.previous_hash());
+    const size_t index = columns.find_last_by_source(columns.find_address(source));
+    if (PoolColumns::npos != index)
+      return columns.pool().transaction(index);
   }
 
   return Transaction{};
@@ -536,15 +1395,22 @@ Transaction Storage::get_last_by_source(Address source) const noexcept
 
 Transaction Storage::get_last_by_target(Address target) const noexcept
 {
-  Pool curr = pool_load(last_hash());
-
-  while (curr.is_valid())
+  PoolColumns columns;
+  Pool pool;
+  for (PoolHash hash = last_hash(); pool_load_scan(hash, columns, pool);
+       hash = pool.is_valid() ? pool.previous_hash() : columns.previous_hash())
   {
-    const auto& t = curr.get_last_by_target(target);
-    if (t.is_valid())
-      return t;
+    if (pool.is_valid())
+    {
+      const Transaction t = pool.get_last_by_target(target);
+      if (t.is_valid())
+        return t;
+      continue;
+    }
 
-    curr = pool_load(curr.previous_hash());
+    const size_t index = columns.find_last_by_target(columns.find_address(target));
+    if (PoolColumns::npos != index)
+      return columns.pool().transaction(index);
   }
 
   return Transaction{};
@@ -10,6 +10,7 @@
 #include "csdb/amount.h"
 #include "csdb/pool.h"
 #include "binary_streams.h"
+#include "pool_scan.h"
 
 namespace csdb {
 
@@ -83,13 +84,17 @@ bool TransactionID::operator <(const TransactionID &other) const noexcept
 
 void TransactionID::put(::csdb::priv::obstream &os) const
 {
-  os.put(d->pool_hash_);
-  os.put(d->index_);
+  priv::serialization_schema::put(os, *d.constData());
 }
 
 bool TransactionID::get(::csdb::priv::ibstream &is)
 {
-  return is.get(d->pool_hash_) && is.get(d->index_);
+  return priv::serialization_schema::get(is, *d.data());
+}
+
+size_t TransactionID::serialized_size() const noexcept
+{
+  return priv::serialization_schema::serialized_size(*d.constData());
 }
 
 SHARED_DATA_CLASS_IMPLEMENTATION(Transaction)
@@ -189,7 +194,7 @@ bool Transaction::add_user_field(user_field_id_t id, UserField field) noexcept
   if (d.constData()->read_only_ || (!field.is_valid())) {
     return false;
   }
-  d->user_fields_[id] = field;
+  d->user_fields_.insert_or_assign(id, field);
   return true;
 }
 
@@ -202,12 +207,14 @@ UserField Transaction::user_field(user_field_id_t id) const noexcept
 
 ::std::set<user_field_id_t> Transaction::user_field_ids() const noexcept
 {
-  ::std::set<user_field_id_t> res;
+  const UserFieldIdRange ids = user_field_id_range();
+  return ::std::set<user_field_id_t>(ids.begin(), ids.end());
+}
+
+UserFieldIdRange Transaction::user_field_id_range() const noexcept
+{
   const priv* data = d.constData();
-  for (const auto& it : data->user_fields_) {
-    res.insert(it.first);
-  }
-  return res;
+  return UserFieldIdRange(data->user_fields_.begin(), data->user_fields_.end());
 }
 
 ::csdb::internal::byte_array Transaction::to_binary()
@@ -216,60 +223,77 @@ UserField Transaction::user_field(user_field_id_t id) const noexcept
     return ::csdb::internal::byte_array();
   }
   ::csdb::priv::obstream os;
+  os.reserve(serialized_size());
   put(os);
-  return os.buffer();
+  return ::std::move(os.buffer());
 }
 
 Transaction Transaction::from_binary(const ::csdb::internal::byte_array data)
 {
-  Transaction t;
-  ::csdb::priv::ibstream is(data.data(), data.size());
-  if (!t.get(is)) {
-    return Transaction();
-  }
-  else {
-    return t;
-  }
+  return from_byte_stream(reinterpret_cast<const char*>(data.data()), data.size());
 }
 
 Transaction Transaction::from_byte_stream(const char* data, size_t m_size) {
-  Transaction t;
-  ::csdb::priv::ibstream is(data, m_size);
-  if (!t.get(is)) {
+  // Структура проверяется один раз, после чего поля читаются без проверок.
+  ::csdb::priv::ibstream check(data, m_size);
+  if (!::csdb::priv::scan_transaction(check)) {
     return Transaction();
   }
-  else {
-    return t;
-  }
+
+  Transaction t;
+  ::csdb::priv::unchecked_ibstream is(data, m_size);
+  t.get(is);
+  return t;
 }
 
 std::vector<uint8_t> Transaction::to_byte_stream() const {
 	::csdb::priv::obstream os;
+	os.reserve(serialized_size());
 	put(os);
-	return os.buffer();
+	return ::std::move(os.buffer());
+}
+
+size_t Transaction::byte_stream_size() const noexcept
+{
+  return serialized_size();
+}
+
+void Transaction::to_byte_stream(::csdb::internal::byte_array& buffer) const
+{
+  // Поток пишет прямо в буфер вызывающей стороны: буфер передаётся потоку и возвращается обратно.
+  ::csdb::priv::obstream os;
+  os.buffer().swap(buffer);
+  os.reserve(serialized_size());
+  put(os);
+  os.buffer().swap(buffer);
 }
 
 
 void Transaction::put(::csdb::priv::obstream &os) const
 {
-  const priv* data = d.constData();
-  os.put(data->source_);
-  os.put(data->target_);
-  os.put(data->currency_);
-  os.put(data->amount_);
-  os.put(data->balance_);
-  os.put(data->user_fields_);
+  priv::serialization_schema::put(os, *d.constData());
 }
 
 bool Transaction::get(::csdb::priv::ibstream &is)
 {
-  priv* data = d.data();
-  return is.get(data->source_)
-      && is.get(data->target_)
-      && is.get(data->currency_)
-      && is.get(data->amount_)
-      && is.get(data->balance_)
-      && is.get(data->user_fields_);
+  return priv::serialization_schema::get(is, *d.data());
+}
+
+void Transaction::get(::csdb::priv::unchecked_ibstream &is)
+{
+  priv::serialization_schema::get(is, *d.data());
+}
+
+size_t Transaction::serialized_size() const noexcept
+{
+  return priv::serialization_schema::serialized_size(*d.constData());
 }
 
 } // namespace csdb
+
+size_t std::hash<::csdb::TransactionID>::operator()(const ::csdb::TransactionID &value) const noexcept
+{
+  // Хеш пула уже равномерно распределён, индекс "размазываем" по всему слову.
+  const size_t index = static_cast<size_t>(value.d->index_);
+  return std::hash<::csdb::PoolHash>()(value.d->pool_hash_) ^ (index * static_cast<size_t>(0x9E3779B97F4A7C15ULL));
+}
@@ -7,9 +7,8 @@
 #ifndef _CREDITS_CSDB_TRANSACTION_PRIVATE_H_INCLUDED_
 #define _CREDITS_CSDB_TRANSACTION_PRIVATE_H_INCLUDED_
 
-#include <map>
-
 #include "csdb/internal/shared_data_ptr_implementation.h"
+#include "csdb/internal/small_flat_map.h"
 
 #include "csdb/transaction.h"
 
@@ -18,8 +17,14 @@
 #include "csdb/currency.h"
 #include "csdb/pool.h"
 
+#include "serialization_schema.h"
+
 namespace csdb {
 
+/// Дополнительные поля транзакции или пула. Почти всегда их не больше трёх, поэтому
+/// они хранятся в упорядоченном массиве внутри объекта.
+using user_field_map_t = ::csdb::internal::small_flat_map<::csdb::user_field_id_t, ::csdb::UserField, 3>;
+
 class TransactionID::priv : public ::csdb::internal::shared_data
 {
   inline priv() :
@@ -39,9 +44,15 @@ class TransactionID::priv : public ::csdb::internal::shared_data
 
   PoolHash pool_hash_;
   TransactionID::sequence_t index_ = 0;
+
+  typedef ::csdb::priv::schema<priv,
+                               CSDB_SCHEMA_FIELD(priv, pool_hash_),
+                               CSDB_SCHEMA_FIELD(priv, index_)> serialization_schema;
+
   friend class TransactionID;
   friend class Transaction;
   friend class Pool;
+  friend struct ::std::hash<::csdb::TransactionID>;
 };
 
 class Transaction::priv : public ::csdb::internal::shared_data
@@ -84,7 +95,15 @@ class Transaction::priv : public ::csdb::internal::shared_data
   Currency currency_;
   Amount amount_;
   Amount balance_;
-  ::std::map<::csdb::user_field_id_t, ::csdb::UserField> user_fields_;
+  user_field_map_t user_fields_;
+
+  typedef ::csdb::priv::schema<priv,
+                               CSDB_SCHEMA_FIELD(priv, source_),
+                               CSDB_SCHEMA_FIELD(priv, target_),
+                               CSDB_SCHEMA_FIELD(priv, currency_),
+                               CSDB_SCHEMA_FIELD(priv, amount_),
+                               CSDB_SCHEMA_FIELD(priv, balance_),
+                               CSDB_SCHEMA_FIELD(priv, user_fields_)> serialization_schema;
 
   friend class Transaction;
   friend class Pool;
@@ -52,6 +52,24 @@ class UserField::priv : public ::csdb::internal::shared_data
     }
   }
 
+  inline size_t serialized_size() const noexcept
+  {
+    using ::csdb::priv::obstream;
+    switch (type_) {
+    case UserField::Integer:
+      return obstream::serialized_size(type_) + obstream::serialized_size(i_value_);
+
+    case UserField::String:
+      return obstream::serialized_size(type_) + obstream::serialized_size(s_value_);
+
+    case UserField::Amount:
+      return obstream::serialized_size(type_) + obstream::serialized_size(a_value_);
+
+    default:
+      return 0;
+    }
+  }
+
   inline bool get(::csdb::priv::ibstream& is)
   {
     UserField::Type type;
@@ -84,6 +102,27 @@ class UserField::priv : public ::csdb::internal::shared_data
     return true;
   }
 
+  inline void get(::csdb::priv::unchecked_ibstream& is)
+  {
+    is.get(type_);
+    switch (type_) {
+    case UserField::Integer:
+      is.get(i_value_);
+      break;
+
+    case UserField::String:
+      is.get(s_value_);
+      break;
+
+    case UserField::Amount:
+      is.get(a_value_);
+      break;
+
+    default:
+      break;
+    }
+  }
+
   inline bool is_equal(const priv* other) const
   {
     if (type_ != other->type_) {
@@ -175,4 +214,14 @@ bool UserField::get(::csdb::priv::ibstream &is)
   return d->get(is);
 }
 
+void UserField::get(::csdb::priv::unchecked_ibstream &is)
+{
+  d->get(is);
+}
+
+size_t UserField::serialized_size() const noexcept
+{
+  return d->serialized_size();
+}
+
 } // namespace csdb
@@ -1,10 +1,12 @@
 #include "csdb/wallet.h"
-#include <map>
+#include <algorithm>
+#include <unordered_map>
 
 #include "csdb/amount.h"
 #include "csdb/address.h"
 #include "csdb/csdb.h"
 #include "csdb/pool.h"
+#include "csdb/pool_columns.h"
 #include "csdb/internal/shared_data_ptr_implementation.h"
 
 namespace csdb {
@@ -15,7 +17,7 @@ class Wallet::priv : public ::csdb::internal::shared_data
   priv(Address address) : address_(address) {}
 
   Address address_;
-  std::map<Currency, Amount> amounts_;
+  std::unordered_map<Currency, Amount> amounts_;
 
   friend class Wallet;
 };
@@ -39,6 +41,8 @@ CurrencyList Wallet::currencies() const noexcept
   for(const auto &it : d->amounts_) {
     res.push_back( it.first );
   }
+  // Порядок unordered_map не определён; валюты возвращаются по возрастанию, как из std::map.
+  std::sort(res.begin(), res.end());
 
   return res;
 }
@@ -59,17 +63,38 @@ Wallet Wallet::get(Address address, Storage storage)
   }
   priv *d = new priv(address);
 
-  for (Pool pool = Pool::load(storage.last_hash(), storage);
-       pool.is_valid();
-       pool = Pool::load(pool.previous_hash(), storage)) {
-    for (size_t i = 0; i < pool.transactions_count(); ++i) {
-      const Transaction t = pool.transaction(i);
-      const Currency currency = t.currency();
-      if (t.source() == address) {
-        d->amounts_[currency] -= t.amount();
+  PoolColumns columns;
+  Pool pool;
+  for (PoolHash hash = storage.last_hash(); storage.pool_load_scan(hash, columns, pool);
+       hash = pool.is_valid() ? pool.previous_hash() : columns.previous_hash()) {
+    if (pool.is_valid()) {
+      for (size_t i = 0; i < pool.transactions_count(); ++i) {
+        const Transaction t = pool.transaction(i);
+        const Currency currency = t.currency();
+        if (t.source() == address) {
+          d->amounts_[currency] -= t.amount();
+        }
+        if (t.target() == address) {
+          d->amounts_[currency] += t.amount();
+        }
       }
-      if (t.target() == address) {
-        d->amounts_[currency] += t.amount();
+      continue;
+    }
+
+    const size_t index = columns.find_address(address);
+    if (PoolColumns::npos == index) {
+      continue;
+    }
+
+    // Суммы учитываются в порядке транзакций, как при полном переборе.
+    const std::vector<Amount> amounts = columns.amounts();
+    for (size_t i : columns.find_by_address(index)) {
+      Amount& amount = d->amounts_[columns.currency(columns.currency_index(i))];
+      if (columns.source_index(i) == index) {
+        amount -= amounts[i];
+      }
+      if (columns.target_index(i) == index) {
+        amount += amounts[i];
       }
     }
   }
@@ -2,6 +2,9 @@
 #include "binary_streams.h"
 #include <gtest/gtest.h>
 
+#include <limits>
+#include <vector>
+
 class AmountTest : public ::testing::Test
 {
 };
@@ -94,6 +97,73 @@ TEST_F(AmountTest, Serialization)
   EXPECT_EQ(a, Amount(-5, 40, 10000));
 }
 
+TEST_F(AmountTest, CompactSerialization)
+{
+  ::std::vector<Amount> values{Amount(0), Amount(1), Amount(-1), Amount(31), Amount(-32), Amount(32),
+                               Amount(5, 25, 100), Amount(-5, 25, 100), Amount(0, 1, 1000000),
+                               Amount(::std::numeric_limits<int32_t>::max()),
+                               Amount(::std::numeric_limits<int32_t>::min())};
+  // Все возможные количества значащих знаков дробной части на границах диапазона целой части.
+  for (int32_t integral : {::std::numeric_limits<int32_t>::min(), -1, 0, 1,
+                           ::std::numeric_limits<int32_t>::max()}) {
+    uint64_t fraction = Amount::AMOUNT_MAX_FRACTION;
+    for (int digits = 0; digits < 18; ++digits) {
+      fraction /= 10;
+      values.push_back(Amount(integral, fraction, Amount::AMOUNT_MAX_FRACTION));
+      values.push_back(Amount(integral, Amount::AMOUNT_MAX_FRACTION - fraction, Amount::AMOUNT_MAX_FRACTION));
+      values.push_back(Amount(integral, fraction * 7 + 3, Amount::AMOUNT_MAX_FRACTION));
+    }
+    values.push_back(Amount(integral, Amount::AMOUNT_MAX_FRACTION - 1, Amount::AMOUNT_MAX_FRACTION));
+  }
+
+  ::csdb::priv::obstream o;
+  size_t size = 0;
+  for (const auto& it : values) {
+    it.put_compact(o);
+    size += it.compact_serialized_size();
+    EXPECT_EQ(o.buffer().size(), size) << it.to_string(18);
+  }
+
+  ::csdb::priv::ibstream i(o.buffer());
+  ::csdb::priv::unchecked_ibstream u(o.buffer().data(), o.buffer().size());
+  for (const auto& it : values) {
+    Amount a, b;
+    EXPECT_TRUE(a.get_compact(i));
+    b.get_compact(u);
+    EXPECT_EQ(a, it) << it.to_string(18);
+    EXPECT_EQ(b, it) << it.to_string(18);
+  }
+  EXPECT_TRUE(i.empty());
+
+  // Типичные суммы значительно короче исходного представления.
+  EXPECT_EQ(Amount(5).compact_serialized_size(), static_cast<size_t>(1));
+  EXPECT_EQ(Amount(5, 25, 100).compact_serialized_size(), static_cast<size_t>(3));
+  EXPECT_LT(Amount(5, 25, 100).compact_serialized_size(), Amount(5, 25, 100).serialized_size());
+}
+
+TEST_F(AmountTest, CompactSerializationInvalid)
+{
+  auto decode = [](::std::initializer_list<int64_t> integrals) {
+    ::csdb::priv::obstream o;
+    for (int64_t it : integrals) {
+      o.put(it);
+    }
+    ::csdb::priv::ibstream i(o.buffer());
+    Amount a;
+    return a.get_compact(i);
+  };
+
+  EXPECT_TRUE(decode({10}));
+  EXPECT_TRUE(decode({11, 25 * 18 + 16}));
+  EXPECT_FALSE(decode({}));
+  EXPECT_FALSE(decode({11}));                                          // нет дробной части
+  EXPECT_FALSE(decode({11, 0}));                                       // нулевая дробная часть
+  EXPECT_FALSE(decode({11, 10 * 18 + 17}));                            // дробная часть >= 1
+  EXPECT_FALSE(decode({11, static_cast<int64_t>(Amount::AMOUNT_MAX_FRACTION * 18)}));
+  EXPECT_FALSE(decode({static_cast<int64_t>(::std::numeric_limits<int32_t>::max()) * 2 + 2}));
+  EXPECT_FALSE(decode({static_cast<int64_t>(::std::numeric_limits<int32_t>::min()) * 2 - 1}));
+}
+
 TEST_F(AmountTest, LiteralOperator)
 {
   EXPECT_EQ(Amount(5), 5_c);
@@ -19,6 +19,13 @@ protected:
       os.put(s);
     }
 
+    inline size_t serialized_size() const
+    {
+      return obstream::serialized_size(i)
+          + obstream::serialized_size(b)
+          + obstream::serialized_size(s);
+    }
+
     inline bool get(ibstream& is)
     {
       return is.get(i)
@@ -49,6 +56,7 @@ inline ::csdb::internal::byte_array from_string(const std::string &src)
     o.put(v1); \
     const ::csdb::internal::byte_array &s = o.buffer(); \
     EXPECT_EQ(s, from_string(string_literal(encoded))); \
+    EXPECT_EQ(obstream::serialized_size(v1), s.size()); \
     ibstream i(s); \
     type v2; \
     EXPECT_TRUE(i.get(v2)); \
@@ -245,6 +253,7 @@ TEST_F(BinaryStreams, MapFilled)
 
   const ::csdb::internal::byte_array &s = o.buffer();
   EXPECT_EQ(s, from_string(string_literal("\x06\x02\x08Key1\x04\x08Key2\x06\x08Key3")));
+  EXPECT_EQ(obstream::serialized_size(v1), s.size());
 
   ::std::map<int, ::std::string> v2;
   ibstream i(s);
@@ -252,3 +261,35 @@ TEST_F(BinaryStreams, MapFilled)
   EXPECT_TRUE(i.empty());
   EXPECT_EQ(v1, v2);
 }
+
+TEST_F(BinaryStreams, SmallFlatMapUnordered)
+{
+  // Ключи в обратном порядке и повтор: остаётся первое значение, как в ::std::map::emplace.
+  const size_t count = 200000;
+  obstream o;
+  o.put(count + 1);
+  for (size_t i = 0; i < count; ++i) {
+    o.put(static_cast<uint32_t>(count - i));
+    o.put(static_cast<uint32_t>(i));
+  }
+  o.put(static_cast<uint32_t>(1));
+  o.put(static_cast<uint32_t>(0));
+
+  ::csdb::internal::small_flat_map<uint32_t, uint32_t, 3> v1;
+  ibstream i(o.buffer());
+  EXPECT_TRUE(i.get(v1));
+  EXPECT_TRUE(i.empty());
+
+  ::csdb::internal::small_flat_map<uint32_t, uint32_t, 3> v2;
+  unchecked_ibstream u(o.buffer().data(), o.buffer().size());
+  u.get(v2);
+
+  for (const auto* v : {&v1, &v2}) {
+    ASSERT_EQ(v->size(), count);
+    uint32_t key = 0;
+    for (const auto& it : *v) {
+      ASSERT_EQ(it.first, ++key);
+      ASSERT_EQ(it.second, count - key);
+    }
+  }
+}
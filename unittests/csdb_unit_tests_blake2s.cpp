@@ -0,0 +1,135 @@
+#include "blake2s.h"
+
+#include <string>
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "csdb/internal/utils.h"
+#include "priv_crypto.h"
+
+using namespace ::csdb::internal;
+using ::csdb::priv::blake2s;
+
+namespace {
+
+std::string calc(const byte_array &data)
+{
+  uint8_t digest[blake2s::digest_size];
+  blake2s::calc(data.data(), data.size(), digest);
+  return to_hex(digest, digest + sizeof(digest));
+}
+
+byte_array sequence(size_t size, size_t modulo)
+{
+  byte_array res(size);
+  for (size_t i = 0; i < size; ++i) {
+    res[i] = static_cast<uint8_t>(i % modulo);
+  }
+  return res;
+}
+
+} // namespace
+
+TEST(Blake2s, KnownVectors)
+{
+  EXPECT_EQ(calc(byte_array{}),
+            "69217A3079908094E11121D042354A7C1F55B6482CA1A51E1B250DFD1ED0EEF9");
+  EXPECT_EQ(calc(byte_array{'a', 'b', 'c'}),
+            "508C5E8C327C14E2E1A72BA34EEB452F37458B209ED63A294D999B4C86675982");
+  // Ровно один блок: последний блок не должен сжиматься в update().
+  EXPECT_EQ(calc(sequence(64, 256)),
+            "56F34E8B96557E90C1F24B52D0C89D51086ACF1B00F634CF1DDE9233B8EAAA3E");
+  EXPECT_EQ(calc(sequence(1000, 251)),
+            "1C067A5E746FB0F6734EFAC9A8CDB0E11061F0077F255184365C690115392501");
+}
+
+TEST(Blake2s, Incremental)
+{
+  const byte_array data = sequence(1000, 251);
+  const std::string expected = calc(data);
+
+  for (size_t step : {1, 7, 63, 64, 65, 333}) {
+    blake2s state;
+    for (size_t pos = 0; pos < data.size(); pos += step) {
+      state.update(data.data() + pos, std::min(step, data.size() - pos));
+    }
+    uint8_t digest[blake2s::digest_size];
+    state.final(digest);
+    EXPECT_EQ(to_hex(digest, digest + sizeof(digest)), expected) << "step = " << step;
+  }
+}
+
+TEST(Blake2s, Reset)
+{
+  blake2s state;
+  state.update("garbage", 7);
+  state.reset();
+  state.update("abc", 3);
+  uint8_t digest[blake2s::digest_size];
+  state.final(digest);
+  EXPECT_EQ(to_hex(digest, digest + sizeof(digest)),
+            "508C5E8C327C14E2E1A72BA34EEB452F37458B209ED63A294D999B4C86675982");
+}
+
+TEST(Blake2s, HasherMatchesCalcHash)
+{
+  const byte_array data = sequence(1000, 251);
+  ::csdb::priv::crypto::hasher hasher;
+  hasher.update(data.data(), 10);
+  hasher.update(data.data() + 10, data.size() - 10);
+  EXPECT_EQ(hasher.finalize(), ::csdb::priv::crypto::calc_hash(data));
+
+  // После finalize вычислитель готов к повторному использованию.
+  hasher.update(data.data(), data.size());
+  EXPECT_EQ(hasher.finalize(), ::csdb::priv::crypto::calc_hash(data));
+}
+
+TEST(Blake2s, Batch)
+{
+  const byte_array data = sequence(1000, 251);
+  for (size_t count : {0, 1, 2, 3, 7, 8, 9, 17, 40}) {
+    SCOPED_TRACE(count);
+    // Буферы разной длины, в том числе пустые и кратные размеру блока.
+    std::vector<const void*> buffers(count);
+    std::vector<size_t> sizes(count);
+    for (size_t i = 0; i < count; ++i) {
+      sizes[i] = (i * 37 + count * 64) % (data.size() + 1);
+      if (0 == (i % 5)) {
+        sizes[i] = (i % 3) * blake2s::block_size;
+      }
+      buffers[i] = data.data() + (i % 7);
+      sizes[i] = std::min(sizes[i], data.size() - (i % 7));
+    }
+
+    byte_array digests(count * blake2s::digest_size);
+    blake2s::calc_batch(buffers.data(), sizes.data(), count, digests.data());
+    for (size_t i = 0; i < count; ++i) {
+      uint8_t digest[blake2s::digest_size];
+      blake2s::calc(buffers[i], sizes[i], digest);
+      EXPECT_EQ(to_hex(digests.data() + i * blake2s::digest_size,
+                       digests.data() + (i + 1) * blake2s::digest_size),
+                to_hex(digest, digest + sizeof(digest))) << "i = " << i;
+    }
+  }
+}
+
+TEST(Blake2s, CalcHashesMatchesCalcHash)
+{
+  std::vector<byte_array> buffers;
+  for (size_t size : {0, 3, 64, 65, 200, 1000}) {
+    buffers.push_back(sequence(size, 251));
+  }
+  std::vector<const byte_array*> pointers;
+  for (const auto& it : buffers) {
+    pointers.push_back(&it);
+  }
+
+  const std::vector<byte_array> hashes = ::csdb::priv::crypto::calc_hashes(pointers);
+  ASSERT_EQ(hashes.size(), buffers.size());
+  for (size_t i = 0; i < buffers.size(); ++i) {
+    EXPECT_EQ(hashes[i], ::csdb::priv::crypto::calc_hash(buffers[i]));
+  }
+  EXPECT_TRUE(::csdb::priv::crypto::calc_hashes({}).empty());
+}
@@ -0,0 +1,114 @@
+#include "block_compression.h"
+
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace ::csdb::internal;
+using ::csdb::priv::lz_compress;
+using ::csdb::priv::lz_decompress;
+
+namespace {
+
+byte_array random_bytes(size_t size, uint32_t seed, uint8_t alphabet = 0xFF)
+{
+  std::mt19937 gen(seed);
+  byte_array res(size);
+  for (auto& it : res) {
+    it = static_cast<uint8_t>(gen() % (static_cast<uint32_t>(alphabet) + 1));
+  }
+  return res;
+}
+
+/// Данные из повторяющихся "адресов" вперемешку со случайными байтами.
+byte_array address_heavy(size_t records, const std::vector<byte_array>& addresses, uint32_t seed)
+{
+  std::mt19937 gen(seed);
+  byte_array res;
+  for (size_t i = 0; i < records; ++i) {
+    const byte_array& address = addresses[gen() % addresses.size()];
+    res.insert(res.end(), address.begin(), address.end());
+    for (int j = 0; j < 3; ++j) {
+      res.push_back(static_cast<uint8_t>(gen()));
+    }
+  }
+  return res;
+}
+
+void check_round_trip(const byte_array& data, const byte_array& dictionary = byte_array{})
+{
+  const byte_array compressed = lz_compress(data.data(), data.size(), dictionary);
+  byte_array result;
+  ASSERT_TRUE(lz_decompress(compressed.data(), compressed.size(), data.size(), dictionary, result));
+  EXPECT_EQ(result, data);
+  EXPECT_FALSE(lz_decompress(compressed.data(), compressed.size(), data.size() + 1, dictionary, result));
+}
+
+} // namespace
+
+TEST(BlockCompression, RoundTrip)
+{
+  for (size_t size : {0, 1, 3, 4, 5, 15, 16, 19, 100, 300, 70000, 200000}) {
+    SCOPED_TRACE(size);
+    check_round_trip(random_bytes(size, 1));
+    check_round_trip(random_bytes(size, 2, 3));
+    check_round_trip(byte_array(size, 0x5A));
+  }
+}
+
+TEST(BlockCompression, Ratio)
+{
+  const byte_array zeros(100000, 0);
+  EXPECT_LT(lz_compress(zeros.data(), zeros.size()).size(), zeros.size() / 200);
+
+  const byte_array random = random_bytes(100000, 3);
+  EXPECT_LT(lz_compress(random.data(), random.size()).size(), random.size() + random.size() / 100);
+}
+
+TEST(BlockCompression, Dictionary)
+{
+  std::vector<byte_array> addresses;
+  byte_array dictionary;
+  for (uint32_t i = 0; i < 100; ++i) {
+    addresses.push_back(random_bytes(32, 100 + i));
+    dictionary.insert(dictionary.end(), addresses.back().begin(), addresses.back().end());
+  }
+
+  const byte_array data = address_heavy(50, addresses, 4);
+  check_round_trip(data, dictionary);
+  const size_t plain = lz_compress(data.data(), data.size()).size();
+  const byte_array compressed = lz_compress(data.data(), data.size(), dictionary);
+  EXPECT_LT(compressed.size() * 3, plain);
+
+  // Для распаковки нужен тот же словарь.
+  byte_array result;
+  EXPECT_FALSE(lz_decompress(compressed.data(), compressed.size(), data.size(), byte_array{}, result)
+               && (result == data));
+
+  // Используется только конец слишком большого словаря.
+  byte_array large(::csdb::priv::lz_max_offset * 2, 0xAB);
+  large.insert(large.end(), dictionary.begin(), dictionary.end());
+  check_round_trip(data, large);
+}
+
+TEST(BlockCompression, Corrupted)
+{
+  std::vector<byte_array> addresses{random_bytes(32, 5), random_bytes(32, 6)};
+  const byte_array data = address_heavy(40, addresses, 7);
+  const byte_array compressed = lz_compress(data.data(), data.size());
+
+  byte_array result;
+  for (size_t size = 0; size < compressed.size(); ++size) {
+    EXPECT_FALSE(lz_decompress(compressed.data(), size, data.size(), byte_array{}, result)) << size;
+  }
+  for (size_t pos = 0; pos < compressed.size(); ++pos) {
+    for (uint8_t value : {uint8_t(0x00), uint8_t(0xFF), uint8_t(compressed[pos] ^ 0x10)}) {
+      byte_array corrupted = compressed;
+      corrupted[pos] = value;
+      // Главное - не выйти за границы буферов; результат может и совпасть.
+      lz_decompress(corrupted.data(), corrupted.size(), data.size(), byte_array{}, result);
+    }
+  }
+  EXPECT_FALSE(lz_decompress(compressed.data(), compressed.size(), size_t(1) << 40, byte_array{}, result));
+}
@@ -0,0 +1,62 @@
+#include "crc32c.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "csdb/internal/types.h"
+
+using namespace ::csdb::internal;
+using ::csdb::priv::crc32c;
+using ::csdb::priv::crc32c_table;
+
+TEST(Crc32c, KnownVectors)
+{
+  const std::string check = "123456789";
+  EXPECT_EQ(crc32c(check.data(), check.size()), 0xE3069283U);
+  EXPECT_EQ(crc32c(nullptr, 0), 0U);
+
+  // RFC 3720, B.4.
+  byte_array data(32, 0x00);
+  EXPECT_EQ(crc32c(data.data(), data.size()), 0x8A9136AAU);
+  data.assign(32, 0xFF);
+  EXPECT_EQ(crc32c(data.data(), data.size()), 0x62A8AB43U);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<uint8_t>(i);
+  }
+  EXPECT_EQ(crc32c(data.data(), data.size()), 0x46DD794EU);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<uint8_t>(31 - i);
+  }
+  EXPECT_EQ(crc32c(data.data(), data.size()), 0x113FDB5CU);
+  EXPECT_EQ(crc32c_table(data.data(), data.size()), 0x113FDB5CU);
+}
+
+TEST(Crc32c, TableMatchesHardware)
+{
+  byte_array data(1000);
+  uint32_t state = 1;
+  for (auto& it : data) {
+    state = state * 1103515245U + 12345U;
+    it = static_cast<uint8_t>(state >> 16);
+  }
+
+  // Разные размеры и невыровненные начала.
+  for (size_t offset = 0; offset < 9; ++offset) {
+    for (size_t size : {0, 1, 3, 4, 7, 8, 9, 15, 16, 17, 63, 64, 65, 500, 991}) {
+      SCOPED_TRACE(::testing::Message() << "offset = " << offset << ", size = " << size);
+      EXPECT_EQ(crc32c(data.data() + offset, size), crc32c_table(data.data() + offset, size));
+    }
+  }
+}
+
+TEST(Crc32c, Parts)
+{
+  const std::string text = "The quick brown fox jumps over the lazy dog";
+  const uint32_t whole = crc32c(text.data(), text.size());
+  for (size_t split = 0; split <= text.size(); ++split) {
+    EXPECT_EQ(crc32c(text.data() + split, text.size() - split, crc32c(text.data(), split)), whole);
+    EXPECT_EQ(crc32c_table(text.data() + split, text.size() - split, crc32c_table(text.data(), split)), whole);
+  }
+}
@@ -1,5 +1,7 @@
 #include "csdb_unit_tests_environment.h"
 
+#include "priv_crypto.h"
+
 namespace csdb {
 
 bool operator ==(const Transaction& a, const Transaction& b)
@@ -95,3 +97,30 @@ bool operator ==(const Pool& a, const Pool& b)
   os << "}";
   return os;
 }
+
+::csdb::Address make_test_address(size_t index)
+{
+  ::csdb::internal::byte_array key(::csdb::priv::crypto::public_key_size, 0xAA);
+  key[0] = static_cast<uint8_t>(index);
+  key[1] = static_cast<uint8_t>(index >> 8);
+  return ::csdb::Address::from_public_key(key);
+}
+
+::csdb::Pool make_test_pool(::csdb::Pool::Format format, size_t count, size_t addresses,
+                            ::csdb::PoolHash previous, ::csdb::Pool::sequence_t sequence)
+{
+  ::csdb::Pool res{previous, sequence};
+  res.set_format(format);
+  for (size_t i = 0; i < count; ++i) {
+    ::csdb::Transaction t(make_test_address((i * 7) % addresses), make_test_address((i * 3 + 1) % addresses),
+                          ::csdb::Currency((0 == (i % 5)) ? "RUB" : "CS"),
+                          ::csdb::Amount(static_cast<int32_t>(i + 1), 25, 100), ::csdb::Amount(-static_cast<int32_t>(i)));
+    if (0 == (i % 4)) {
+      t.add_user_field(1, static_cast<int32_t>(i));
+    }
+    EXPECT_TRUE(res.add_transaction(t, true));
+  }
+  EXPECT_TRUE(res.add_user_field(1, "Pool"));
+  EXPECT_TRUE(res.compose());
+  return res;
+}
@@ -38,4 +38,17 @@ inline bool operator !=(const Pool& a, const Pool& b)
 
 ::std::ostream& operator <<(::std::ostream& os, const ::csdb::UserField& value);
 
+/// Адрес из открытого ключа, однозначно определяемого номером index (меньше 65536).
+::csdb::Address make_test_address(size_t index);
+
+/**
+ * @brief Сформированный пул из count транзакций между addresses адресами (\ref make_test_address).
+ *
+ * Транзакции идут в двух валютах, у части из них есть дополнительное поле 1, у пула -
+ * дополнительное поле 1. При чётном addresses отправитель и получатель не совпадают.
+ */
+::csdb::Pool make_test_pool(::csdb::Pool::Format format, size_t count, size_t addresses,
+                            ::csdb::PoolHash previous = ::csdb::PoolHash{},
+                            ::csdb::Pool::sequence_t sequence = 0);
+
 #endif // _CREDITS_CSDB_UNIT_TESTS_ENVIRONMENT_H_INCLUDED_
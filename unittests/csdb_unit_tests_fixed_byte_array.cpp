@@ -0,0 +1,92 @@
+#include "csdb/internal/fixed_byte_array.h"
+
+#include <set>
+
+#include <gtest/gtest.h>
+
+using namespace ::csdb::internal;
+
+using test_array = fixed_byte_array<32>;
+
+TEST(FixedByteArray, Empty)
+{
+  test_array a;
+  EXPECT_TRUE(a.empty());
+  EXPECT_EQ(a.size(), static_cast<size_t>(0));
+  EXPECT_EQ(a.begin(), a.end());
+  EXPECT_TRUE(a.to_byte_array().empty());
+  EXPECT_EQ(a, test_array{});
+}
+
+TEST(FixedByteArray, Assign)
+{
+  const byte_array src{1, 2, 3, 4, 5};
+  test_array a;
+  EXPECT_TRUE(a.assign(src));
+  EXPECT_FALSE(a.empty());
+  EXPECT_EQ(a.size(), src.size());
+  EXPECT_EQ(a.to_byte_array(), src);
+
+  EXPECT_TRUE(a.assign(byte_array(test_array::capacity(), 0xFF)));
+  EXPECT_EQ(a.size(), test_array::capacity());
+
+  EXPECT_FALSE(a.assign(byte_array(test_array::capacity() + 1, 0x01)));
+  EXPECT_EQ(a.to_byte_array(), byte_array(test_array::capacity(), 0xFF));
+
+  a.clear();
+  EXPECT_TRUE(a.empty());
+  EXPECT_EQ(a, test_array{});
+}
+
+TEST(FixedByteArray, Shrink)
+{
+  test_array a, b;
+  EXPECT_TRUE(a.assign(byte_array{1, 2, 3, 4}));
+  EXPECT_TRUE(a.assign(byte_array{1, 2}));
+  EXPECT_TRUE(b.assign(byte_array{1, 2}));
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(a.hash(), b.hash());
+}
+
+TEST(FixedByteArray, Compare)
+{
+  const byte_array v1{1, 2, 3};
+  const byte_array v2{1, 2, 4};
+  const byte_array v3{1, 2};
+  const byte_array v4{};
+  test_array a1, a2, a3, a4;
+  a1.assign(v1);
+  a2.assign(v2);
+  a3.assign(v3);
+  a4.assign(v4);
+
+  EXPECT_NE(a1, a2);
+  EXPECT_NE(a1, a3);
+  EXPECT_NE(a3, a4);
+
+  // Порядок должен совпадать с порядком byte_array
+  const test_array* all[] = {&a1, &a2, &a3, &a4};
+  const byte_array* all_v[] = {&v1, &v2, &v3, &v4};
+  for (size_t i = 0; i < 4; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      EXPECT_EQ(*all[i] < *all[j], *all_v[i] < *all_v[j]);
+    }
+  }
+}
+
+TEST(FixedByteArray, Hash)
+{
+  test_array a, b;
+  a.assign(byte_array{1, 2, 3, 4, 5, 6, 7, 8, 9});
+  b.assign(byte_array{1, 2, 3, 4, 5, 6, 7, 8, 9});
+  EXPECT_EQ(a.hash(), b.hash());
+  EXPECT_EQ(test_array{}.hash(), static_cast<size_t>(0));
+
+  std::set<size_t> hashes;
+  for (uint8_t i = 0; i < 16; ++i) {
+    test_array c;
+    c.assign(byte_array(test_array::capacity(), i));
+    hashes.insert(c.hash());
+  }
+  EXPECT_EQ(hashes.size(), static_cast<size_t>(16));
+}
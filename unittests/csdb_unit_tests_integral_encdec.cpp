@@ -1,6 +1,9 @@
 #include "integral_encdec.h"
 
 #include <limits>
+#include <cstring>
+#include <vector>
+#include <algorithm>
 
 #include <gtest/gtest.h>
 
@@ -16,6 +19,7 @@ class IntegralEncDec : public ::testing::Test
     type v1 = value, v2; \
     std::size_t size = ::csdb::priv::encode(buf, v1); \
     EXPECT_EQ(std::string(buf, size), string_literal(encoded)); \
+    EXPECT_EQ(::csdb::priv::encoded_size(v1), size); \
     EXPECT_EQ(::csdb::priv::decode(buf, size, v2), size); \
     EXPECT_EQ(v1, v2); \
     EXPECT_EQ(::csdb::priv::decode(buf, size - 1, v2), 0); \
@@ -90,3 +94,84 @@ TEST_F(IntegralEncDec, Enum)
   EXPECT_EQ(v1, v2);
   EXPECT_EQ(::csdb::priv::decode(buf, size - 1, v2), 0);
 }
+
+TEST_F(IntegralEncDec, EncodedSizeAllWidths)
+{
+  char buf[::csdb::priv::MAX_INTEGRAL_ENCODED_SIZE];
+  for (unsigned shift = 0; shift < 64; ++shift) {
+    const uint64_t base = static_cast<uint64_t>(1) << shift;
+    for (uint64_t v : {base - 1, base, base + 1, ~(base - 1), ~base, ~(base + 1)}) {
+      EXPECT_EQ(::csdb::priv::encoded_size(v), ::csdb::priv::encode(buf, v)) << v;
+      const int64_t sv = static_cast<int64_t>(v);
+      EXPECT_EQ(::csdb::priv::encoded_size(sv), ::csdb::priv::encode(buf, sv)) << sv;
+      const uint32_t uv = static_cast<uint32_t>(v);
+      EXPECT_EQ(::csdb::priv::encoded_size(uv), ::csdb::priv::encode(buf, uv)) << uv;
+    }
+  }
+}
+
+TEST_F(IntegralEncDec, RoundTripAllWidths)
+{
+  // Декодирование из буфера ровно по размеру значения и из буфера с запасом
+  // (когда доступно чтение целого 64-битного слова) должно давать одинаковый результат.
+  char buf[::csdb::priv::MAX_INTEGRAL_ENCODED_SIZE * 2];
+  for (unsigned shift = 0; shift < 64; ++shift) {
+    const uint64_t base = static_cast<uint64_t>(1) << shift;
+    for (uint64_t v1 : {base - 1, base, base + 1, ~(base - 1), ~base, ~(base + 1)}) {
+      std::memset(buf, 0xA5, sizeof(buf));
+      const std::size_t size = ::csdb::priv::encode(buf, v1);
+      uint64_t v2 = 0, v3 = 0;
+      EXPECT_EQ(::csdb::priv::decode(buf, size, v2), size) << v1;
+      EXPECT_EQ(v2, v1);
+      EXPECT_EQ(::csdb::priv::decode(buf, sizeof(buf), v3), size) << v1;
+      EXPECT_EQ(v3, v1);
+      EXPECT_EQ(::csdb::priv::decode(buf, size - 1, v2), 0u) << v1;
+    }
+  }
+}
+
+TEST_F(IntegralEncDec, DecodeBatch)
+{
+  // Серии однобайтовых значений разной длины (в том числе длиннее блока сканирования),
+  // перемежающиеся многобайтовыми.
+  std::vector<uint64_t> values;
+  for (size_t run = 0; run < 70; run += 3) {
+    for (size_t i = 0; i < run; ++i) {
+      values.push_back(static_cast<uint64_t>(static_cast<int64_t>(i % 128) - 64));
+    }
+    values.push_back(static_cast<uint64_t>(1) << (run % 64));
+  }
+
+  std::vector<uint8_t> buf;
+  std::vector<size_t> offsets;
+  for (uint64_t v : values) {
+    offsets.push_back(buf.size());
+    uint8_t tmp[::csdb::priv::MAX_INTEGRAL_ENCODED_SIZE];
+    buf.insert(buf.end(), tmp, tmp + ::csdb::priv::encode(tmp, v));
+  }
+  offsets.push_back(buf.size());
+
+  std::vector<uint64_t> res(values.size());
+  EXPECT_EQ(::csdb::priv::decode_batch(buf.data(), buf.size(), res.data(), res.size()), buf.size());
+  EXPECT_EQ(res, values);
+
+  res.assign(values.size(), 0);
+  EXPECT_EQ(::csdb::priv::decode_batch_unchecked(buf.data(), buf.size(), res.data(), res.size()),
+            buf.size());
+  EXPECT_EQ(res, values);
+
+  // Частичное чтение и чтение с произвольной позиции.
+  for (size_t first = 0; first < values.size(); first += 7) {
+    for (size_t count = 1; first + count <= values.size(); count += 11) {
+      const size_t size = offsets[first + count] - offsets[first];
+      EXPECT_EQ(::csdb::priv::decode_batch(buf.data() + offsets[first], buf.size() - offsets[first],
+                                           res.data(), count), size);
+      EXPECT_TRUE(std::equal(res.begin(), res.begin() + count, values.begin() + first));
+    }
+  }
+
+  // Недостаточно данных.
+  for (size_t size = 0; size < buf.size(); ++size) {
+    EXPECT_EQ(::csdb::priv::decode_batch(buf.data(), size, res.data(), res.size()), 0u) << size;
+  }
+}
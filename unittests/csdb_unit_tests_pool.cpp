@@ -3,6 +3,8 @@
 #include <iostream>
 #include <set>
 #include <map>
+#include <unordered_set>
+#include <unordered_map>
 #include <stdexcept>
 
 #include <gtest/gtest.h>
@@ -129,6 +131,34 @@ TEST_F(PoolHashTest, StdMap)
   EXPECT_EQ(hm.at(PoolHash{}), (internal::byte_array{}));
 }
 
+TEST_F(PoolHashTest, StdUnorderedSet)
+{
+  ::std::unordered_set<PoolHash> hs;
+  EXPECT_TRUE(hs.insert(PoolHash::calc_from_data({1,2,3})).second);
+  EXPECT_FALSE(hs.insert(PoolHash::calc_from_data({1,2,3})).second);
+  EXPECT_TRUE(hs.insert(PoolHash::calc_from_data({1,2,4})).second);
+  EXPECT_TRUE(hs.insert(PoolHash{}).second);
+  EXPECT_FALSE(hs.insert(PoolHash{}).second);
+
+  EXPECT_EQ(hs.size(), static_cast<size_t>(3));
+  EXPECT_EQ(hs.count(PoolHash::calc_from_data({1,2,3})), static_cast<size_t>(1));
+  EXPECT_EQ(hs.count(PoolHash::calc_from_data({1,4,2})), static_cast<size_t>(0));
+  EXPECT_EQ(hs.count(PoolHash{}), static_cast<size_t>(1));
+
+  EXPECT_EQ(hs.erase(PoolHash::calc_from_data({1,2,3})), static_cast<size_t>(1));
+  EXPECT_EQ(hs.erase(PoolHash::calc_from_data({1,2,3})), static_cast<size_t>(0));
+  EXPECT_EQ(hs.size(), static_cast<size_t>(2));
+}
+
+TEST_F(PoolHashTest, StdHash)
+{
+  ::std::hash<PoolHash> h;
+  EXPECT_EQ(h(PoolHash::calc_from_data({1,2,3})), h(PoolHash::calc_from_data({1,2,3})));
+  EXPECT_EQ(h(PoolHash::calc_from_data({1,2,3})),
+            h(PoolHash::from_string(PoolHash::calc_from_data({1,2,3}).to_string())));
+  EXPECT_NE(h(PoolHash::calc_from_data({1,2,3})), h(PoolHash::calc_from_data({1,2,4})));
+}
+
 TEST_F(PoolHashTest, FromValidString)
 {
   {
@@ -329,6 +359,78 @@ TEST_F(PoolTest, SetReadOnlyAfterCompose)
   EXPECT_EQ(p.transactions_count(), static_cast<size_t>(1));
 }
 
+TEST_F(PoolTest, AddTransactionMove)
+{
+  Pool p(PoolHash::calc_from_data({1}), 1);
+
+  // Единственный владелец - данные забираются пулом.
+  Transaction t1{addr1, addr2, Currency("CS"), 1_c};
+  EXPECT_TRUE(t1.add_user_field(1, "Text"));
+  EXPECT_TRUE(p.add_transaction(::std::move(t1), true));
+
+  // Данные разделяются с другим объектом - транзакция копируется.
+  Transaction t2{addr2, addr3, Currency("CS"), 2_c};
+  Transaction t2_copy = t2;
+  EXPECT_TRUE(p.add_transaction(::std::move(t2_copy), true));
+
+  // Невалидная транзакция не добавляется.
+  EXPECT_FALSE(p.add_transaction(Transaction{addr1, addr1, Currency("CS"), 1_c}, true));
+  EXPECT_EQ(p.transactions_count(), static_cast<size_t>(2));
+
+  EXPECT_TRUE(p.compose());
+  EXPECT_EQ(p.transaction(0).user_field(1), UserField("Text"));
+  EXPECT_TRUE(p.transaction(1).id().is_valid());
+  EXPECT_FALSE(t2.is_read_only());
+  EXPECT_FALSE(t2.id().is_valid());
+  EXPECT_EQ(p.transaction(1), t2);
+
+  EXPECT_FALSE(p.add_transaction(Transaction{addr1, addr2, Currency("CS"), 1_c}, true));
+}
+
+TEST_F(PoolTest, AddTransactionMoveFromComposedPool)
+{
+  Pool p_src{PoolHash{}, 0};
+  ASSERT_TRUE(p_src.add_transaction(Transaction{addr1, addr2, Currency("CS"), 1_c}, true));
+  ASSERT_TRUE(p_src.compose());
+  Transaction t = p_src.transaction(0);
+  p_src = Pool{};
+
+  // После уничтожения исходного пула транзакция имеет единственного владельца.
+  Pool p_dst{PoolHash{}, 1};
+  ASSERT_TRUE(p_dst.add_transaction(::std::move(t), true));
+  Transaction t_dst = p_dst.transaction(0);
+  EXPECT_FALSE(t_dst.is_read_only());
+  EXPECT_FALSE(t_dst.id().is_valid());
+
+  ASSERT_TRUE(p_dst.compose());
+  EXPECT_TRUE(p_dst.transaction(0).id().is_valid());
+  EXPECT_EQ(p_dst.transaction(0).id().pool_hash(), p_dst.hash());
+}
+
+TEST_F(PoolTest, AddTransactions)
+{
+  Pool p(PoolHash::calc_from_data({1}), 1);
+  EXPECT_TRUE(p.add_transaction(Transaction{addr1, addr2, Currency("CS"), 1_c}, true));
+
+  ::std::vector<Transaction> ts;
+  ts.emplace_back(addr1, addr2, Currency("CS"), 2_c);
+  ts.emplace_back(addr2, addr2, Currency("CS"), 3_c);
+  ts.emplace_back(addr2, addr3, Currency("CS"), 4_c);
+  EXPECT_EQ(p.add_transactions(::std::move(ts), true), static_cast<size_t>(2));
+  EXPECT_TRUE(ts.empty());
+
+  ASSERT_EQ(p.transactions_count(), static_cast<size_t>(3));
+  EXPECT_EQ(p.transaction(0).amount(), 1_c);
+  EXPECT_EQ(p.transaction(1).amount(), 2_c);
+  EXPECT_EQ(p.transaction(2).amount(), 4_c);
+
+  p.reserve(100);
+  EXPECT_TRUE(p.compose());
+  ts.emplace_back(addr1, addr2, Currency("CS"), 2_c);
+  EXPECT_EQ(p.add_transactions(::std::move(ts), true), static_cast<size_t>(0));
+  EXPECT_EQ(p.transactions_count(), static_cast<size_t>(3));
+}
+
 TEST_F(PoolTest, ToFromBinaryValidEmpty)
 {
   {
@@ -512,6 +614,213 @@ TEST_F(PoolTest, FromToBinaryWithTransactions)
   }
 }
 
+TEST_F(PoolTest, DictionaryFormatFromToBinary)
+{
+  Pool legacy{PoolHash{}, 0};
+  EXPECT_EQ(legacy.format(), Pool::LegacyFormat);
+  for (int i = 1; i <= 10; ++i) {
+    EXPECT_TRUE(legacy.add_transaction(Transaction(addr1, addr2, Currency("RUB"), Amount(i)), true));
+    EXPECT_TRUE(legacy.add_transaction(Transaction(addr2, addr3, Currency("CS"), Amount(i, 5, 10)), true));
+  }
+  EXPECT_TRUE(legacy.add_user_field(1, "Pool"));
+
+  Pool src = legacy;
+  src.set_format(Pool::DictionaryFormat);
+  EXPECT_EQ(src.format(), Pool::DictionaryFormat);
+  EXPECT_EQ(legacy.format(), Pool::LegacyFormat);
+
+  EXPECT_TRUE(legacy.compose());
+  EXPECT_TRUE(src.compose());
+  EXPECT_NE(src.hash(), legacy.hash());
+  EXPECT_LT(src.to_binary().size(), legacy.to_binary().size());
+
+  // После формирования формат не изменяется.
+  src.set_format(Pool::LegacyFormat);
+  EXPECT_EQ(src.format(), Pool::DictionaryFormat);
+
+  Pool dst = Pool::from_binary(src.to_binary());
+  EXPECT_TRUE(dst.is_valid());
+  EXPECT_TRUE(dst.is_read_only());
+  EXPECT_EQ(dst.format(), Pool::DictionaryFormat);
+  EXPECT_EQ(src, dst);
+  EXPECT_EQ(dst.user_field(1), legacy.user_field(1));
+
+  ASSERT_EQ(dst.transactions_count(), legacy.transactions_count());
+  for (size_t i = 0; i < dst.transactions_count(); ++i) {
+    Transaction t = dst.transaction(i);
+    Transaction expected = legacy.transaction(i);
+    EXPECT_EQ(t.id(), src.transaction(i).id());
+    EXPECT_EQ(t.id().pool_hash(), dst.hash());
+    EXPECT_EQ(t.source(), expected.source());
+    EXPECT_EQ(t.target(), expected.target());
+    EXPECT_EQ(t.currency(), expected.currency());
+    EXPECT_EQ(t.amount(), expected.amount());
+  }
+
+  size_t cnt = 0;
+  Pool meta = Pool::meta_from_binary(src.to_binary(), cnt);
+  EXPECT_EQ(cnt, src.transactions_count());
+  EXPECT_EQ(meta.sequence(), src.sequence());
+  EXPECT_EQ(meta.previous_hash(), src.previous_hash());
+}
+
+TEST_F(PoolTest, DictionaryFormatSaveLoad)
+{
+  Storage s;
+  ASSERT_TRUE(s.open(path_to_tests_));
+
+  Pool src(PoolHash{}, 0, s);
+  src.set_format(Pool::DictionaryFormat);
+  EXPECT_TRUE(src.add_transaction(Transaction(addr1, addr2, Currency("RUB"), 1_c), true));
+  EXPECT_TRUE(src.add_transaction(Transaction(addr1, addr3, Currency("RUB"), 2_c), true));
+  EXPECT_TRUE(src.compose());
+  EXPECT_TRUE(src.save());
+
+  Pool res = Pool::load(src.hash(), s);
+  EXPECT_TRUE(res.is_valid());
+  EXPECT_EQ(res.format(), Pool::DictionaryFormat);
+  EXPECT_EQ(src, res);
+
+  size_t cnt = 0;
+  Pool meta = s.pool_load_meta(src.hash(), cnt);
+  EXPECT_EQ(cnt, static_cast<size_t>(2));
+  EXPECT_EQ(meta.sequence(), src.sequence());
+}
+
+TEST_F(PoolTest, FromBinaryWithHash)
+{
+  Pool src{PoolHash{}, 0};
+  for (int i = 1; i <= 5; ++i) {
+    EXPECT_TRUE(src.add_transaction(Transaction(addr1, addr2, Currency("RUB"), Amount(i)), true));
+  }
+  EXPECT_TRUE(src.compose());
+  EXPECT_TRUE(src.verify_hash());
+
+  Pool dst = Pool::from_binary(src.to_binary(), src.hash());
+  EXPECT_TRUE(dst.is_valid());
+  EXPECT_TRUE(dst.is_read_only());
+  EXPECT_EQ(dst, src);
+  EXPECT_EQ(dst.hash(), src.hash());
+  EXPECT_EQ(dst.transaction(0).id(), src.transaction(0).id());
+  EXPECT_TRUE(dst.verify_hash());
+
+  // Хеш не вычисляется, поэтому несоответствие обнаруживается только проверкой.
+  const PoolHash other = PoolHash::calc_from_data({1, 2, 3});
+  Pool wrong = Pool::from_binary(src.to_binary(), other);
+  EXPECT_TRUE(wrong.is_valid());
+  EXPECT_EQ(wrong.hash(), other);
+  EXPECT_EQ(wrong.transaction(0).id().pool_hash(), other);
+  EXPECT_FALSE(wrong.verify_hash());
+
+  EXPECT_FALSE(Pool::from_binary(src.to_binary(), PoolHash{}).is_valid());
+  EXPECT_FALSE(Pool::from_binary(::csdb::internal::byte_array{1, 2, 3}, src.hash()).is_valid());
+  EXPECT_FALSE(Pool{}.verify_hash());
+}
+
+TEST_F(PoolTest, FromBinaryUnknownFormat)
+{
+  Pool src{PoolHash{}, 0};
+  src.set_format(static_cast<Pool::Format>(100));
+  EXPECT_EQ(src.format(), Pool::LegacyFormat);
+
+  src.set_format(Pool::DictionaryFormat);
+  EXPECT_TRUE(src.compose());
+  ::csdb::internal::byte_array data = src.to_binary();
+  ASSERT_TRUE(Pool::from_binary(data).is_valid());
+
+  // Маркер формата занимает три байта, за ним следует номер формата.
+  data[3] = 0x7E;
+  EXPECT_FALSE(Pool::from_binary(data).is_valid());
+}
+
+TEST_F(PoolTest, ByteStreamBuffers)
+{
+  Pool src{PoolHash{}, 0};
+  for (int i = 1; i <= 20; ++i) {
+    EXPECT_TRUE(src.add_transaction(Transaction(addr1, addr2, Currency("RUB"), Amount(i)), true));
+  }
+  EXPECT_TRUE(src.compose());
+  const ::csdb::internal::byte_array binary = src.to_binary();
+
+  // Копия пула разделяет с ним бинарное представление.
+  Pool copy = src;
+  ASSERT_EQ(copy.byte_stream_size(), binary.size());
+
+  ::csdb::internal::byte_array buffer(binary.size() + 10, 0xFF);
+  EXPECT_EQ(copy.to_byte_stream(buffer.data(), binary.size() - 1), static_cast<size_t>(0));
+  EXPECT_EQ(copy.to_byte_stream(buffer.data(), buffer.size()), binary.size());
+  EXPECT_TRUE(::std::equal(binary.begin(), binary.end(), buffer.begin()));
+  EXPECT_EQ(buffer.back(), 0xFF);
+
+  // Запись по частям: пустой буфер пропускается, последний заполняется частично.
+  ::csdb::internal::byte_array part1(7), part2(0), part3(binary.size() / 2), part4(binary.size());
+  const Pool::ByteStreamBuffer buffers[] = {{part1.data(), part1.size()}, {part2.data(), part2.size()},
+                                            {part3.data(), part3.size()}, {part4.data(), part4.size()}};
+  EXPECT_EQ(copy.to_byte_stream(buffers, 3), static_cast<size_t>(0));
+  EXPECT_EQ(copy.to_byte_stream(buffers, 4), binary.size());
+  ::csdb::internal::byte_array joined = part1;
+  joined.insert(joined.end(), part3.begin(), part3.end());
+  joined.insert(joined.end(), part4.begin(), part4.begin() + (binary.size() - joined.size()));
+  EXPECT_EQ(joined, binary);
+
+  // Принятые данные становятся бинарным представлением пула без копирования.
+  ::csdb::internal::byte_array received = binary;
+  const uint8_t* received_data = received.data();
+  Pool dst = Pool::from_byte_stream(::std::move(received));
+  EXPECT_TRUE(dst.is_valid());
+  EXPECT_TRUE(dst.is_read_only());
+  EXPECT_EQ(dst, src);
+  EXPECT_EQ(dst.hash(), src.hash());
+  EXPECT_TRUE(received.empty());
+  size_t size = 0;
+  EXPECT_EQ(reinterpret_cast<const uint8_t*>(dst.to_byte_stream(size)), received_data);
+  EXPECT_EQ(size, binary.size());
+
+  ::csdb::internal::byte_array invalid{1, 2, 3};
+  EXPECT_FALSE(Pool::from_byte_stream(::std::move(invalid)).is_valid());
+  EXPECT_EQ(invalid.size(), static_cast<size_t>(3));
+}
+
+TEST_F(PoolTest, ReceiveSaveLoad)
+{
+  Storage s;
+  ASSERT_TRUE(s.open(path_to_tests_));
+
+  Pool src{PoolHash{}, 0};
+  src.set_format(Pool::MerkleFormat);
+  for (int i = 1; i <= 5; ++i) {
+    EXPECT_TRUE(src.add_transaction(Transaction(addr1, addr2, Currency("RUB"), Amount(i)), true));
+  }
+  EXPECT_TRUE(src.compose());
+  const ::csdb::internal::byte_array received = src.to_binary();
+
+  // Принятый пул уже сформирован, и в хранилище записываются принятые данные.
+  Pool dst = Pool::from_byte_stream(::csdb::internal::byte_array(received));
+  EXPECT_TRUE(dst.is_valid());
+  EXPECT_TRUE(dst.is_read_only());
+  EXPECT_EQ(dst.hash(), src.hash());
+  EXPECT_TRUE(dst.compose());
+  EXPECT_EQ(dst.to_binary(), received);
+  EXPECT_TRUE(dst.save(s));
+
+  const Pool res = Pool::load(src.hash(), s);
+  EXPECT_TRUE(res.is_valid());
+  EXPECT_EQ(res.to_binary(), received);
+
+  // Пул из байтового потока можно изменять, как и до приёма.
+  Pool editable = Pool::from_byte_stream(reinterpret_cast<const char*>(received.data()), received.size());
+  EXPECT_TRUE(editable.is_valid());
+  EXPECT_FALSE(editable.is_read_only());
+  EXPECT_EQ(editable.transactions_count(), src.transactions_count());
+  editable.set_sequence(1);
+  editable.set_previous_hash(src.hash());
+  EXPECT_TRUE(editable.add_transaction(Transaction(addr2, addr1, Currency("RUB"), 1_c), true));
+  EXPECT_TRUE(editable.compose());
+  EXPECT_EQ(editable.sequence(), 1u);
+  EXPECT_EQ(editable.previous_hash(), src.hash());
+  EXPECT_NE(editable.hash(), src.hash());
+}
+
 TEST_F(PoolTest, UserFieldCompare)
 {
   Pool p1{PoolHash{}, 0}, p2{PoolHash{}, 0};
@@ -675,4 +984,92 @@ TEST_F(PoolTest, GetTransactionByTarget)
   // Case if target appears multiple times, should return last transaction
 
   EXPECT_EQ(pool.get_last_by_target(addr2).amount(), 32_c);
-}
\ No newline at end of file
+}
+
+TEST_F(PoolTest, AddressIndex)
+{
+  Pool pool{PoolHash{}, 0};
+  ASSERT_TRUE(pool.add_transaction(Transaction{addr1, addr2, Currency("CS"), 10_c}, true));
+  ASSERT_TRUE(pool.add_transaction(Transaction{addr1, addr3, Currency("RUB"), 1_c}, true));
+  ASSERT_TRUE(pool.add_transaction(Transaction{addr2, addr1, Currency("CS"), 2_c}, true));
+  ASSERT_TRUE(pool.add_transaction(Transaction{addr1, addr2, Currency("CS"), 5_c}, true));
+
+  // По индексу и перебором результаты совпадают.
+  auto check = [this](Pool& p) {
+    EXPECT_EQ(p.find_by_address(addr1), (::std::vector<size_t>{0, 1, 2, 3}));
+    EXPECT_EQ(p.find_by_address(addr2), (::std::vector<size_t>{0, 2, 3}));
+    EXPECT_EQ(p.find_by_address(addr3), (::std::vector<size_t>{1}));
+    EXPECT_TRUE(p.find_by_address(Address::from_string("0000000000000000000000000000000000000003")).empty());
+    EXPECT_EQ(p.debit(addr1, Currency("CS")), 15_c);
+    EXPECT_EQ(p.debit(addr1, Currency("RUB")), 1_c);
+    EXPECT_EQ(p.debit(addr2, Currency("CS")), 2_c);
+    EXPECT_EQ(p.debit(addr3, Currency("CS")), 0_c);
+    EXPECT_EQ(p.get_last_by_source(addr2).amount(), 2_c);
+    EXPECT_EQ(p.get_last_by_target(addr2).amount(), 5_c);
+    EXPECT_FALSE(p.get_last_by_source(addr3).is_valid());
+  };
+  check(pool);
+
+  Pool copy = pool;
+  ASSERT_TRUE(copy.compose());
+  check(copy);
+  Pool loaded = Pool::from_binary(copy.to_binary());
+  ASSERT_TRUE(loaded.is_valid());
+  check(loaded);
+
+  // После изменения списка транзакций напрямую индекс не используется.
+  pool.transactions().pop_back();
+  ASSERT_TRUE(pool.add_transaction(Transaction{addr1, addr2, Currency("CS"), 5_c}, true));
+  check(pool);
+  pool.transactions().erase(pool.transactions().begin());
+  EXPECT_EQ(pool.debit(addr1, Currency("CS")), 5_c);
+  EXPECT_EQ(pool.find_by_address(addr3), (::std::vector<size_t>{0}));
+
+  // После очистки пул индексируется заново.
+  EXPECT_TRUE(pool.clear());
+  ASSERT_TRUE(pool.add_transaction(Transaction{addr3, addr1, Currency("CS"), 7_c}, true));
+  EXPECT_EQ(pool.debit(addr3, Currency("CS")), 7_c);
+  EXPECT_EQ(pool.get_last_by_target(addr1).amount(), 7_c);
+  EXPECT_TRUE(pool.find_by_address(addr2).empty());
+}
+TEST_F(PoolTest, ComposeParallel)
+{
+  for (Pool::Format format : {Pool::LegacyFormat, Pool::DictionaryFormat, Pool::MerkleFormat}) {
+    for (size_t count : {0, 1, 100, 5000, 20001}) {
+      Pool src{PoolHash::calc_from_data({1, 2, 3}), 7};
+      src.set_format(format);
+      for (size_t i = 0; i < count; ++i) {
+        Transaction t((0 == (i % 2)) ? addr1 : addr3, addr2, Currency((0 == (i % 3)) ? "RUB" : "CS"),
+                      Amount(static_cast<int32_t>(i + 1)));
+        if (0 == (i % 7)) {
+          t.add_user_field(1, static_cast<int32_t>(i));
+        }
+        ASSERT_TRUE(src.add_transaction(t, true));
+      }
+      EXPECT_TRUE(src.add_user_field(2, "Pool"));
+
+      Pool expected = src;
+      ASSERT_TRUE(expected.compose());
+
+      for (size_t threads : {0, 2, 3, 8}) {
+        SCOPED_TRACE(::testing::Message() << "format = " << int(format) << ", count = " << count
+                     << ", threads = " << threads);
+        // Копия пула не должна измениться при формировании.
+        Pool pool = src;
+        ASSERT_TRUE(pool.compose(threads));
+        EXPECT_FALSE(src.is_read_only());
+        EXPECT_TRUE(pool.is_read_only());
+        EXPECT_EQ(pool.hash(), expected.hash());
+        EXPECT_EQ(pool.to_binary(), expected.to_binary());
+        ASSERT_EQ(pool.transactions_count(), count);
+        for (size_t i = 0; i < count; ++i) {
+          EXPECT_EQ(pool.transaction(i).id(), expected.transaction(i).id());
+        }
+        EXPECT_TRUE(pool.compose(threads));
+      }
+    }
+  }
+
+  Pool invalid;
+  EXPECT_FALSE(invalid.compose(2));
+}
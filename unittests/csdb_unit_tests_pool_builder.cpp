@@ -0,0 +1,132 @@
+#include "csdb/pool_builder.h"
+
+#include <gtest/gtest.h>
+
+#include "csdb_unit_tests_environment.h"
+
+#include "csdb/pool.h"
+#include "csdb/currency.h"
+
+using namespace csdb;
+
+class PoolBuilderTest : public ::testing::Test
+{
+protected:
+  Pool make_reference(size_t count, bool with_user_fields)
+  {
+    Pool res{previous_, 42};
+    for (size_t i = 0; i < count; ++i) {
+      res.add_transaction(make_transaction(i), true);
+    }
+    if (with_user_fields) {
+      res.add_user_field(1, 100);
+      res.add_user_field(2, "Text");
+    }
+    res.compose();
+    return res;
+  }
+
+  Transaction make_transaction(size_t i)
+  {
+    Transaction res(addr1, addr2, Currency("RUB"), Amount(static_cast<int32_t>(i + 1)));
+    res.add_user_field(1, static_cast<int32_t>(i));
+    return res;
+  }
+
+  PoolHash previous_ = PoolHash::calc_from_data({1, 2, 3});
+  Address addr1 = Address::from_string("0000000000000000000000000000000000000001");
+  Address addr2 = Address::from_string("0000000000000000000000000000000000000002");
+};
+
+TEST_F(PoolBuilderTest, Invalid)
+{
+  PoolBuilder b;
+  EXPECT_FALSE(b.is_valid());
+  EXPECT_FALSE(b.add_transaction(make_transaction(0), true));
+  EXPECT_FALSE(b.add_user_field(1, 100));
+  EXPECT_FALSE(b.compose().is_valid());
+}
+
+TEST_F(PoolBuilderTest, SameAsPoolCompose)
+{
+  for (size_t count : {0, 1, 3, 100}) {
+    for (bool with_user_fields : {false, true}) {
+      const Pool reference = make_reference(count, with_user_fields);
+
+      PoolBuilder b{previous_, 42, count};
+      EXPECT_TRUE(b.is_valid());
+      EXPECT_EQ(b.expected_transactions_count(), count);
+      for (size_t i = 0; i < count; ++i) {
+        if (0 == (i % 2)) {
+          EXPECT_TRUE(b.add_transaction(make_transaction(i), true));
+        } else {
+          const Transaction t = make_transaction(i);
+          EXPECT_TRUE(b.add_transaction(t, true));
+        }
+      }
+      EXPECT_EQ(b.transactions_count(), count);
+      if (with_user_fields) {
+        EXPECT_TRUE(b.add_user_field(2, "Text"));
+        EXPECT_TRUE(b.add_user_field(1, 100));
+      }
+
+      const Pool res = b.compose();
+      EXPECT_FALSE(b.is_valid());
+      ASSERT_TRUE(res.is_valid());
+      EXPECT_TRUE(res.is_read_only());
+      EXPECT_EQ(res.to_binary(), reference.to_binary());
+      EXPECT_EQ(res.hash(), reference.hash());
+      EXPECT_EQ(res, reference);
+      for (size_t i = 0; i < res.transactions_count(); ++i) {
+        EXPECT_EQ(res.transaction(i).id(), reference.transaction(i).id());
+      }
+    }
+  }
+}
+
+TEST_F(PoolBuilderTest, CountMismatch)
+{
+  for (size_t count : {0, 2, 5}) {
+    const Pool reference = make_reference(3, true);
+
+    PoolBuilder b{previous_, 42, count};
+    for (size_t i = 0; i < 3; ++i) {
+      EXPECT_TRUE(b.add_transaction(make_transaction(i), true));
+    }
+    EXPECT_TRUE(b.add_user_field(1, 100));
+    EXPECT_TRUE(b.add_user_field(2, "Text"));
+
+    const Pool res = b.compose();
+    EXPECT_EQ(res.to_binary(), reference.to_binary());
+    EXPECT_EQ(res.hash(), reference.hash());
+  }
+}
+
+TEST_F(PoolBuilderTest, FromBinary)
+{
+  PoolBuilder b{previous_, 42, 2};
+  EXPECT_TRUE(b.add_transaction(make_transaction(0), true));
+  EXPECT_TRUE(b.add_transaction(make_transaction(1), true));
+  const Pool src = b.compose();
+
+  const Pool dst = Pool::from_binary(src.to_binary());
+  EXPECT_TRUE(dst.is_valid());
+  EXPECT_EQ(dst.hash(), src.hash());
+  EXPECT_EQ(dst, src);
+}
+
+TEST_F(PoolBuilderTest, Copy)
+{
+  PoolBuilder b1{previous_, 42, 2};
+  EXPECT_TRUE(b1.add_transaction(make_transaction(0), true));
+  PoolBuilder b2 = b1;
+  EXPECT_TRUE(b1.add_transaction(make_transaction(1), true));
+  EXPECT_EQ(b1.transactions_count(), static_cast<size_t>(2));
+  EXPECT_EQ(b2.transactions_count(), static_cast<size_t>(1));
+
+  EXPECT_TRUE(b2.add_transaction(make_transaction(1), true));
+  const Pool p1 = b1.compose();
+  const Pool p2 = b2.compose();
+  EXPECT_EQ(p1.hash(), make_reference(2, false).hash());
+  EXPECT_EQ(p2.hash(), p1.hash());
+}
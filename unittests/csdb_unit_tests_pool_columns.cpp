@@ -0,0 +1,276 @@
+#include "csdb/pool_columns.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "csdb_unit_tests_environment.h"
+
+#include "csdb/wallet.h"
+#include "csdb/internal/utils.h"
+#include "pool_columnar.h"
+
+using namespace csdb;
+
+class PoolColumnsTest : public ::testing::Test
+{
+protected:
+  PoolColumnsTest() :
+    path_to_tests_(::csdb::internal::app_data_path() + "csdb_unittests_pool_columns")
+  {
+  }
+
+  void TearDown() override
+  {
+    ASSERT_TRUE(::csdb::internal::path_remove(path_to_tests_));
+  }
+
+  /// Сравнивает столбцы с транзакциями пула.
+  static void check_columns(const PoolColumns& columns, const Pool& pool)
+  {
+    ASSERT_TRUE(columns.is_valid());
+    EXPECT_EQ(columns.format(), pool.format());
+    EXPECT_EQ(columns.previous_hash(), pool.previous_hash());
+    EXPECT_EQ(columns.sequence(), pool.sequence());
+    ASSERT_EQ(columns.transactions_count(), pool.transactions_count());
+
+    const ::std::vector<Amount> amounts = columns.amounts();
+    ASSERT_EQ(amounts.size(), pool.transactions_count());
+    for (size_t i = 0; i < pool.transactions_count(); ++i) {
+      const Transaction t = pool.transaction(i);
+      EXPECT_EQ(columns.address(columns.source_index(i)), t.source());
+      EXPECT_EQ(columns.address(columns.target_index(i)), t.target());
+      EXPECT_EQ(columns.currency(columns.currency_index(i)), t.currency());
+      EXPECT_EQ(amounts[i], t.amount());
+    }
+
+    for (size_t a = 0; a < columns.addresses_count(); ++a) {
+      const Address address = columns.address(a);
+      EXPECT_EQ(columns.find_address(address), a);
+
+      ::std::vector<size_t> sources, targets, both;
+      for (size_t i = 0; i < pool.transactions_count(); ++i) {
+        const Transaction t = pool.transaction(i);
+        if (t.source() == address) {
+          sources.push_back(i);
+        }
+        if (t.target() == address) {
+          targets.push_back(i);
+        }
+        if ((t.source() == address) || (t.target() == address)) {
+          both.push_back(i);
+        }
+      }
+      EXPECT_EQ(columns.find_by_source(a), sources);
+      EXPECT_EQ(columns.find_by_target(a), targets);
+      EXPECT_EQ(columns.find_by_address(a), both);
+      EXPECT_EQ(columns.find_last_by_source(a), sources.empty() ? PoolColumns::npos : sources.back());
+      EXPECT_EQ(columns.find_last_by_target(a), targets.empty() ? PoolColumns::npos : targets.back());
+    }
+  }
+
+  ::std::string path_to_tests_;
+};
+
+TEST_F(PoolColumnsTest, Invalid)
+{
+  PoolColumns c;
+  EXPECT_FALSE(c.is_valid());
+  EXPECT_EQ(c.transactions_count(), static_cast<size_t>(0));
+  EXPECT_EQ(c.find_address(make_test_address(1)), PoolColumns::npos);
+  EXPECT_TRUE(c.find_by_source(0).empty());
+  EXPECT_EQ(c.find_last_by_target(0), PoolColumns::npos);
+  EXPECT_TRUE(c.amounts().empty());
+  EXPECT_FALSE(c.pool().is_valid());
+
+  EXPECT_FALSE(PoolColumns(Pool{}).is_valid());
+  EXPECT_FALSE(PoolColumns::from_binary({}).is_valid());
+  EXPECT_FALSE(PoolColumns::from_binary({1, 2, 3}).is_valid());
+}
+
+TEST_F(PoolColumnsTest, ColumnarFormatFromToBinary)
+{
+  const Pool src = make_test_pool(Pool::ColumnarFormat, 100, 10);
+  EXPECT_EQ(src.format(), Pool::ColumnarFormat);
+  EXPECT_LT(src.to_binary().size(), make_test_pool(Pool::LegacyFormat, 100, 10).to_binary().size());
+
+  Pool dst = Pool::from_binary(src.to_binary());
+  EXPECT_TRUE(dst.is_valid());
+  EXPECT_EQ(dst.format(), Pool::ColumnarFormat);
+  EXPECT_EQ(src, dst);
+  EXPECT_EQ(dst.user_field(1), src.user_field(1));
+  for (size_t i = 0; i < dst.transactions_count(); ++i) {
+    const Transaction expected = src.transaction(i);
+    const Transaction t = dst.transaction(expected.id());
+    EXPECT_TRUE(t.is_valid());
+    EXPECT_EQ(t.balance(), expected.balance());
+    EXPECT_EQ(t.user_field(1), expected.user_field(1));
+  }
+
+  size_t cnt = 0;
+  Pool meta = Pool::meta_from_binary(src.to_binary(), cnt);
+  EXPECT_EQ(cnt, src.transactions_count());
+  EXPECT_EQ(meta.sequence(), src.sequence());
+}
+
+TEST_F(PoolColumnsTest, AllFormats)
+{
+  for (Pool::Format format : {Pool::LegacyFormat, Pool::DictionaryFormat, Pool::ColumnarFormat,
+                              Pool::MerkleFormat}) {
+    for (size_t count : {0, 1, 15, 16, 17, 100}) {
+      SCOPED_TRACE(::testing::Message() << "format = " << int(format) << ", count = " << count);
+      const Pool pool = make_test_pool(format, count, 10);
+      check_columns(PoolColumns(pool), pool);
+      check_columns(PoolColumns::from_binary(pool.to_binary()), pool);
+      EXPECT_EQ(PoolColumns::from_binary(pool.to_binary()).pool(), pool);
+
+      // С известным хешем пул не хешируется, а хеш берётся как есть.
+      const PoolHash fake = PoolHash::calc_from_data({1, 2, 3});
+      const PoolColumns trusted = PoolColumns::from_binary(pool.to_binary(), fake);
+      check_columns(trusted, pool);
+      EXPECT_EQ(trusted.pool().hash(), fake);
+      EXPECT_FALSE(trusted.pool().verify_hash());
+    }
+  }
+}
+
+TEST_F(PoolColumnsTest, WideIndices)
+{
+  // Больше 256 адресов - номера занимают два байта.
+  const Pool pool = make_test_pool(Pool::ColumnarFormat, 600, 300);
+  const PoolColumns columns = PoolColumns::from_binary(pool.to_binary());
+  EXPECT_GT(columns.addresses_count(), static_cast<size_t>(256));
+  check_columns(columns, pool);
+}
+
+TEST_F(PoolColumnsTest, UnknownAddress)
+{
+  const Pool pool = make_test_pool(Pool::ColumnarFormat, 300, 256);
+  const PoolColumns columns = PoolColumns::from_binary(pool.to_binary());
+  EXPECT_EQ(columns.find_address(make_test_address(1000)), PoolColumns::npos);
+  // Номер за пределами таблицы не совпадает с усечёнными номерами в столбце.
+  EXPECT_TRUE(columns.find_by_source(PoolColumns::npos).empty());
+  EXPECT_TRUE(columns.find_by_address(columns.addresses_count()).empty());
+  EXPECT_EQ(columns.find_last_by_target(columns.addresses_count() + 0x100), PoolColumns::npos);
+}
+
+TEST_F(PoolColumnsTest, FindColumnIndex)
+{
+  for (uint8_t width : {1, 2, 4}) {
+    for (size_t count = 0; count < 40; ++count) {
+      SCOPED_TRACE(::testing::Message() << "width = " << int(width) << ", count = " << count);
+      ::csdb::internal::byte_array column(count * width + 1);
+      for (size_t i = 0; i < count; ++i) {
+        ::csdb::priv::put_column_index(column.data() + 1 + i * width, (i * i) % 5, width);
+      }
+      const uint8_t* begin = column.data() + 1;
+      for (size_t value = 0; value < 6; ++value) {
+        ::std::vector<size_t> expected;
+        for (size_t i = 0; i < count; ++i) {
+          if (((i * i) % 5) == value) {
+            expected.push_back(i);
+          }
+        }
+        ::std::vector<size_t> matches;
+        ::csdb::priv::find_column_index(begin, count, width, value, matches);
+        EXPECT_EQ(matches, expected);
+        EXPECT_EQ(::csdb::priv::find_last_column_index(begin, count, width, value),
+                  expected.empty() ? count : expected.back());
+      }
+      EXPECT_TRUE(::csdb::priv::check_column_indices(begin, count, width, 5));
+      EXPECT_EQ(::csdb::priv::check_column_indices(begin, count, width, 4), count < 3);
+    }
+  }
+}
+
+TEST_F(PoolColumnsTest, StorageScans)
+{
+  Storage s;
+  ASSERT_TRUE(s.open(path_to_tests_));
+
+  // Пулы в разных форматах в одной цепочке.
+  ::std::vector<Pool> pools;
+  PoolHash previous;
+  for (Pool::Format format : {Pool::LegacyFormat, Pool::ColumnarFormat, Pool::DictionaryFormat,
+                              Pool::MerkleFormat, Pool::ColumnarFormat}) {
+    Pool pool = make_test_pool(format, 50, 20, previous, pools.size());
+    ASSERT_TRUE(pool.save(s));
+    previous = pool.hash();
+    pools.push_back(pool);
+  }
+
+  for (const Pool& pool : pools) {
+    check_columns(s.pool_load_columns(pool.hash()), pool);
+    check_columns(PoolColumns::load(pool.hash(), s), pool);
+
+    // Для перебора столбцы читаются только из ColumnarFormat, остальные пулы - целиком.
+    PoolColumns columns;
+    Pool loaded;
+    ASSERT_TRUE(s.pool_load_scan(pool.hash(), columns, loaded));
+    if (Pool::ColumnarFormat == pool.format()) {
+      EXPECT_FALSE(loaded.is_valid());
+      check_columns(columns, pool);
+    } else {
+      EXPECT_FALSE(columns.is_valid());
+      EXPECT_EQ(loaded, pool);
+    }
+  }
+  EXPECT_FALSE(s.pool_load_columns(PoolHash::calc_from_data({1, 2, 3})).is_valid());
+  PoolColumns columns = PoolColumns(pools[1]);
+  Pool loaded = pools[0];
+  EXPECT_FALSE(s.pool_load_scan(PoolHash::calc_from_data({1, 2, 3}), columns, loaded));
+  EXPECT_FALSE(columns.is_valid());
+  EXPECT_FALSE(loaded.is_valid());
+
+  for (size_t a = 0; a < 21; ++a) {
+    const Address address = make_test_address(a);
+    SCOPED_TRACE(a);
+
+    // Эталон - полный перебор транзакций, как до появления столбцов.
+    ::std::vector<Transaction> expected;
+    Transaction last_source, last_target;
+    Amount rub, cs;
+    for (auto pool = pools.rbegin(); pool != pools.rend(); ++pool) {
+      for (size_t i = 0; i < pool->transactions_count(); ++i) {
+        const Transaction t = pool->transaction(i);
+        Amount& amount = (t.currency() == Currency("RUB")) ? rub : cs;
+        if (t.source() == address) {
+          amount -= t.amount();
+        }
+        if (t.target() == address) {
+          amount += t.amount();
+        }
+      }
+      for (size_t i = pool->transactions_count(); i > 0; --i) {
+        const Transaction t = pool->transaction(i - 1);
+        if ((t.source() == address) && !last_source.is_valid()) {
+          last_source = t;
+        }
+        if ((t.target() == address) && !last_target.is_valid()) {
+          last_target = t;
+        }
+        if ((t.source() == address) || (t.target() == address)) {
+          expected.push_back(t);
+        }
+      }
+    }
+
+    const Wallet w = Wallet::get(address, s);
+    EXPECT_EQ(w.amount(Currency("RUB")), rub);
+    EXPECT_EQ(w.amount(Currency("CS")), cs);
+    EXPECT_EQ(s.get_last_by_source(address), last_source);
+    EXPECT_EQ(s.get_last_by_target(address), last_target);
+    EXPECT_EQ(s.transactions(address, 1000), expected);
+
+    // Постраничный просмотр с продолжением от последней полученной транзакции.
+    ::std::vector<Transaction> paged = s.transactions(address, 7);
+    while ((!paged.empty()) && (paged.size() < expected.size())) {
+      const ::std::vector<Transaction> next = s.transactions(address, 7, paged.back().id());
+      if (next.empty()) {
+        break;
+      }
+      paged.insert(paged.end(), next.begin(), next.end());
+    }
+    EXPECT_EQ(paged, expected);
+  }
+}
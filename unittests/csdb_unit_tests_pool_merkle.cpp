@@ -0,0 +1,262 @@
+#include "pool_merkle.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "csdb_unit_tests_environment.h"
+
+#include "csdb/database_leveldb.h"
+#include "csdb/pool.h"
+#include "csdb/storage.h"
+#include "csdb/internal/utils.h"
+#include "priv_crypto.h"
+
+using namespace csdb;
+
+class PoolMerkleTest : public ::testing::Test
+{
+protected:
+  PoolMerkleTest() :
+    path_to_tests_(::csdb::internal::app_data_path() + "csdb_unittests_pool_merkle")
+  {
+  }
+
+  void TearDown() override
+  {
+    ASSERT_TRUE(::csdb::internal::path_remove(path_to_tests_));
+  }
+
+  /// Пул в формате MerkleFormat.
+  static Pool make_pool(size_t count, PoolHash previous = PoolHash{}, Pool::sequence_t sequence = 0)
+  {
+    return make_test_pool(Pool::MerkleFormat, count, 20, previous, sequence);
+  }
+
+  static ::csdb::internal::byte_array node(const ::csdb::internal::byte_array& left,
+                                           const ::csdb::internal::byte_array& right)
+  {
+    ::csdb::internal::byte_array data{0x01};
+    data.insert(data.end(), left.begin(), left.end());
+    data.insert(data.end(), right.begin(), right.end());
+    return ::csdb::priv::crypto::calc_hash(data);
+  }
+
+  ::std::string path_to_tests_;
+};
+
+TEST_F(PoolMerkleTest, Tree)
+{
+  const ::csdb::internal::byte_array data{10, 11, 12, 20, 21, 30};
+  const ::std::vector<size_t> sizes{3, 2, 1};
+  const ::csdb::priv::merkle_level leaves = ::csdb::priv::merkle_leaves(data.data(), sizes);
+  ASSERT_EQ(leaves.size(), sizes.size());
+  EXPECT_EQ(leaves[1], ::csdb::priv::crypto::calc_hash({0x00, 20, 21}));
+
+  // Непарный последний узел переходит на следующий уровень без изменений.
+  const ::csdb::internal::byte_array root = node(node(leaves[0], leaves[1]), leaves[2]);
+  EXPECT_EQ(::csdb::priv::merkle_root(leaves), root);
+  EXPECT_EQ(::csdb::priv::merkle_root({}), ::csdb::priv::crypto::calc_hash(::csdb::internal::byte_array{}));
+  EXPECT_EQ(::csdb::priv::merkle_root({leaves[0]}), leaves[0]);
+
+  EXPECT_EQ(::csdb::priv::merkle_path(leaves, 0),
+            (::csdb::priv::merkle_level{leaves[1], leaves[2]}));
+  EXPECT_EQ(::csdb::priv::merkle_path(leaves, 2),
+            (::csdb::priv::merkle_level{node(leaves[0], leaves[1])}));
+  EXPECT_TRUE(::csdb::priv::merkle_path(leaves, 3).empty());
+
+  for (size_t count = 1; count <= 33; ++count) {
+    ::std::vector<size_t> all_sizes(count, 1);
+    ::csdb::internal::byte_array all_data(count);
+    for (size_t i = 0; i < count; ++i) {
+      all_data[i] = static_cast<uint8_t>(i);
+    }
+    const ::csdb::priv::merkle_level all = ::csdb::priv::merkle_leaves(all_data.data(), all_sizes);
+    const ::csdb::internal::byte_array all_root = ::csdb::priv::merkle_root(all);
+    for (size_t i = 0; i < count; ++i) {
+      SCOPED_TRACE(::testing::Message() << "count = " << count << ", index = " << i);
+      ::csdb::priv::merkle_level path = ::csdb::priv::merkle_path(all, i);
+      const ::csdb::internal::byte_array transaction{all_data[i]};
+      EXPECT_EQ(::csdb::priv::merkle_root_from_path(transaction, i, count, path), all_root);
+      if (count > 1) {
+        EXPECT_NE(::csdb::priv::merkle_root_from_path(transaction, (i + 1) % count, count, path), all_root);
+      }
+      EXPECT_TRUE(::csdb::priv::merkle_root_from_path(transaction, i, i, path).empty());
+      path.push_back(all_root);
+      EXPECT_TRUE(::csdb::priv::merkle_root_from_path(transaction, i, count, path).empty());
+    }
+  }
+}
+
+TEST_F(PoolMerkleTest, FromToBinary)
+{
+  for (size_t count : {0, 1, 2, 3, 7, 8, 9, 100}) {
+    SCOPED_TRACE(count);
+    const Pool src = make_pool(count, PoolHash::calc_from_data({1, 2, 3}), 5);
+    EXPECT_EQ(src.format(), Pool::MerkleFormat);
+    EXPECT_EQ(src.merkle_root().size(), ::csdb::priv::crypto::hash_size);
+
+    const Pool dst = Pool::from_binary(src.to_binary());
+    ASSERT_TRUE(dst.is_valid());
+    EXPECT_EQ(dst, src);
+    EXPECT_EQ(dst.hash(), src.hash());
+    EXPECT_EQ(dst.merkle_root(), src.merkle_root());
+    EXPECT_EQ(dst.user_field(1), src.user_field(1));
+    for (size_t i = 0; i < count; ++i) {
+      EXPECT_EQ(dst.transaction(i).id(), TransactionID(src.hash(), i));
+      EXPECT_EQ(dst.transaction(i).user_field(1), src.transaction(i).user_field(1));
+    }
+
+    size_t cnt = 0;
+    const Pool meta = Pool::meta_from_binary(src.to_binary(), cnt);
+    EXPECT_EQ(cnt, count);
+    EXPECT_EQ(meta.sequence(), src.sequence());
+    EXPECT_EQ(meta.previous_hash(), src.previous_hash());
+  }
+
+  // Корень входит в заголовок, поэтому хеш зависит от транзакций.
+  EXPECT_NE(make_pool(3).hash(), make_pool(4).hash());
+  EXPECT_TRUE(make_pool(3).merkle_root() != make_pool(4).merkle_root());
+
+  Pool legacy{PoolHash{}, 0};
+  EXPECT_TRUE(legacy.compose());
+  EXPECT_TRUE(legacy.merkle_root().empty());
+}
+
+TEST_F(PoolMerkleTest, CorruptedTransaction)
+{
+  const Pool src = make_pool(10);
+  const ::csdb::internal::byte_array binary = src.to_binary();
+  const Pool::InclusionProof proof = src.inclusion_proof(src.transaction(4).id());
+  ASSERT_FALSE(proof.header.empty());
+
+  // Изменение транзакции не меняет заголовок, но нарушает корень дерева.
+  size_t pos = proof.header.size();
+  for (size_t i = 0; i < 4; ++i) {
+    pos += src.inclusion_proof(src.transaction(i).id()).transaction.size();
+  }
+  ::csdb::internal::byte_array corrupted = binary;
+  corrupted[pos + proof.transaction.size() - 3] ^= 0x01;
+  EXPECT_FALSE(Pool::from_binary(corrupted).is_valid());
+  EXPECT_FALSE(Pool::from_byte_stream(reinterpret_cast<const char*>(corrupted.data()), corrupted.size()).is_valid());
+  EXPECT_EQ(::csdb::priv::pool_hashed_size(corrupted.data(), corrupted.size()), proof.header.size());
+  EXPECT_EQ(::csdb::priv::pool_hashed_size(binary.data(), binary.size() - 1), proof.header.size());
+  EXPECT_EQ(::csdb::priv::pool_hashed_size(binary.data(), 5), static_cast<size_t>(5));
+
+  // То же при открытии хранилища: ключ совпадает с хешем заголовка, но пул повреждён.
+  {
+    Storage s;
+    ASSERT_TRUE(s.open(path_to_tests_));
+    ASSERT_TRUE(s.pool_save(src));
+    EXPECT_EQ(s.pool_load(src.hash()), src);
+  }
+  {
+    auto leveldb = ::std::make_shared<DatabaseLevelDB>();
+    ASSERT_TRUE(leveldb->open(path_to_tests_));
+    ::std::shared_ptr<Database> db(leveldb);
+    ASSERT_TRUE(db->put(src.hash().to_binary(), corrupted));
+    Storage s;
+    EXPECT_FALSE(s.open(Storage::OpenOptions{db}));
+    EXPECT_EQ(s.last_error(), Storage::DataIntegrityError);
+  }
+}
+
+TEST_F(PoolMerkleTest, InclusionProof)
+{
+  for (size_t count : {1, 2, 3, 5, 16, 17, 100}) {
+    SCOPED_TRACE(count);
+    const Pool pool = make_pool(count);
+    for (size_t i = 0; i < count; ++i) {
+      const Transaction expected = pool.transaction(i);
+      const Pool::InclusionProof proof = pool.inclusion_proof(expected.id());
+      EXPECT_EQ(::csdb::PoolHash::calc_from_data(proof.header), pool.hash());
+      EXPECT_LE(proof.path.size(), static_cast<size_t>(7));
+
+      const Transaction t = Pool::verify_inclusion_proof(expected.id(), proof);
+      ASSERT_TRUE(t.is_valid()) << "i = " << i;
+      EXPECT_EQ(t.id(), expected.id());
+      EXPECT_EQ(t, expected);
+      EXPECT_EQ(t.user_field(1), expected.user_field(1));
+
+      // Доказательство относится только к своей транзакции.
+      EXPECT_FALSE(Pool::verify_inclusion_proof(TransactionID(pool.hash(), (i + 1) % (count + 1)), proof)
+                   .is_valid());
+    }
+  }
+
+  const Pool pool = make_pool(20);
+  const TransactionID id = pool.transaction(6).id();
+  const Pool::InclusionProof proof = pool.inclusion_proof(id);
+  ASSERT_TRUE(Pool::verify_inclusion_proof(id, proof).is_valid());
+
+  Pool::InclusionProof bad = proof;
+  bad.transaction.back() ^= 0x01;
+  EXPECT_FALSE(Pool::verify_inclusion_proof(id, bad).is_valid());
+  bad = proof;
+  bad.header.back() ^= 0x01;
+  EXPECT_FALSE(Pool::verify_inclusion_proof(id, bad).is_valid());
+  bad = proof;
+  bad.header.push_back(0);
+  EXPECT_FALSE(Pool::verify_inclusion_proof(id, bad).is_valid());
+  bad = proof;
+  bad.path[1].front() ^= 0x01;
+  EXPECT_FALSE(Pool::verify_inclusion_proof(id, bad).is_valid());
+  bad = proof;
+  bad.path.pop_back();
+  EXPECT_FALSE(Pool::verify_inclusion_proof(id, bad).is_valid());
+  EXPECT_FALSE(Pool::verify_inclusion_proof(TransactionID(make_pool(21).hash(), 6), proof).is_valid());
+  EXPECT_FALSE(Pool::verify_inclusion_proof(TransactionID(), proof).is_valid());
+
+  // Доказательства есть только для транзакций сформированных пулов в формате MerkleFormat.
+  EXPECT_TRUE(pool.inclusion_proof(TransactionID(pool.hash(), 20)).header.empty());
+  EXPECT_TRUE(pool.inclusion_proof(TransactionID(PoolHash::calc_from_data({1}), 0)).header.empty());
+  Pool legacy{PoolHash{}, 0};
+  EXPECT_TRUE(legacy.add_transaction(Transaction(make_test_address(1), make_test_address(2), Currency("CS"), 1_c), true));
+  EXPECT_TRUE(legacy.compose());
+  EXPECT_TRUE(legacy.inclusion_proof(legacy.transaction(0).id()).header.empty());
+  EXPECT_FALSE(Pool::verify_inclusion_proof(legacy.transaction(0).id(), proof).is_valid());
+}
+
+TEST_F(PoolMerkleTest, Storage)
+{
+  ::std::vector<Pool> pools;
+  {
+    Storage s;
+    ASSERT_TRUE(s.open(path_to_tests_));
+    PoolHash previous;
+    for (Pool::sequence_t i = 0; i < 5; ++i) {
+      pools.push_back(make_pool(10 + i, previous, i));
+      previous = pools.back().hash();
+    }
+    ASSERT_TRUE(s.pool_save(pools[0]));
+    ::std::vector<::csdb::internal::byte_array> rest;
+    for (size_t i = 1; i < pools.size(); ++i) {
+      rest.push_back(pools[i].to_binary());
+    }
+
+    // Пул с изменённой транзакцией имеет тот же хеш заголовка; пакет отклоняется целиком.
+    ::std::vector<::csdb::internal::byte_array> tampered = rest;
+    tampered.back()[tampered.back().size() - 3] ^= 0x01;
+    EXPECT_EQ(::csdb::priv::pool_hashed_size(tampered.back().data(), tampered.back().size()),
+              ::csdb::priv::pool_hashed_size(rest.back().data(), rest.back().size()));
+    EXPECT_FALSE(s.pool_save_batch(tampered));
+    EXPECT_EQ(s.last_error(), Storage::InvalidParameter);
+    EXPECT_EQ(s.size(), static_cast<size_t>(1));
+    EXPECT_EQ(s.last_hash(), pools[0].hash());
+
+    ASSERT_TRUE(s.pool_save_batch(rest));
+    EXPECT_EQ(s.last_hash(), pools.back().hash());
+  }
+
+  Storage s;
+  ASSERT_TRUE(s.open(path_to_tests_));
+  EXPECT_EQ(s.size(), pools.size());
+  EXPECT_EQ(s.last_hash(), pools.back().hash());
+  for (const auto& pool : pools) {
+    const Pool loaded = s.pool_load(pool.hash());
+    EXPECT_EQ(loaded, pool);
+    const TransactionID id = pool.transaction(3).id();
+    EXPECT_EQ(s.transaction(id), pool.transaction(3));
+    EXPECT_EQ(Pool::verify_inclusion_proof(id, loaded.inclusion_proof(id)), pool.transaction(3));
+  }
+}
@@ -0,0 +1,290 @@
+#include "pool_scan.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "csdb_unit_tests_environment.h"
+
+#include "csdb/pool.h"
+#include "csdb/currency.h"
+#include "binary_streams.h"
+#include "pool_columnar.h"
+#include "pool_format.h"
+#include "transaction_p.h"
+
+using namespace csdb;
+using ::csdb::priv::ibstream;
+using ::csdb::priv::scan_pool;
+
+class PoolScanTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    Pool pool{PoolHash::calc_from_data({1, 2, 3}), 1000};
+    Transaction t1(addr1, addr2, Currency("CS"), 1.5_c);
+    t1.add_user_field(1, 100);
+    t1.add_user_field(2, "Text");
+    t1.add_user_field(3, -123.456_c);
+    Transaction t2(addr2, addr1, Currency("RUB"), 1000000_c, -5_c);
+    EXPECT_TRUE(pool.add_transaction(t1, true));
+    EXPECT_TRUE(pool.add_transaction(t2, true));
+    EXPECT_TRUE(pool.add_user_field(7, "Pool"));
+    Pool dictionary = pool;
+    dictionary.set_format(Pool::DictionaryFormat);
+    Pool columnar = pool;
+    columnar.set_format(Pool::ColumnarFormat);
+    ASSERT_TRUE(pool.compose());
+    ASSERT_TRUE(dictionary.compose());
+    ASSERT_TRUE(columnar.compose());
+    binary_ = pool.to_binary();
+    dictionary_ = dictionary.to_binary();
+    columnar_ = columnar.to_binary();
+  }
+
+  /// Чтение пула через проверяющий поток (повторяет Pool::priv::get).
+  static bool safe_decode(const internal::byte_array& data, ::std::vector<Transaction>& transactions)
+  {
+    ibstream is(data.data(), data.size());
+    Pool::Format format;
+    PoolHash previous_hash;
+    Pool::sequence_t sequence;
+    if (!::csdb::priv::get_pool_format(is, format) || !is.get(previous_hash) || !is.get(sequence)) {
+      return false;
+    }
+    if ((Pool::DictionaryFormat == format) && !safe_decode_dictionary(is, transactions)) {
+      return false;
+    }
+    if ((Pool::ColumnarFormat == format) && !safe_decode_columnar(is, transactions)) {
+      return false;
+    }
+    if (Pool::LegacyFormat == format) {
+      size_t count;
+      if (!is.get(count)) {
+        return false;
+      }
+      for (size_t i = 0; i < count; ++i) {
+        Transaction t;
+        if (!is.get(t)) {
+          return false;
+        }
+        transactions.push_back(t);
+      }
+    }
+    user_field_map_t user_fields;
+    return is.get(user_fields);
+  }
+
+  /// Таблицы и транзакции формата Pool::DictionaryFormat.
+  static bool safe_decode_dictionary(ibstream& is, ::std::vector<Transaction>& transactions)
+  {
+    ::std::vector<Address> addresses;
+    ::std::vector<Currency> currencies;
+    size_t count;
+    if (!is.get(addresses) || !is.get(currencies) || !is.get(count)) {
+      return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+      size_t source, target, currency;
+      Amount amount, balance;
+      user_field_map_t user_fields;
+      if (!is.get(source) || !is.get(target) || !is.get(currency)
+          || (source >= addresses.size()) || (target >= addresses.size())
+          || (currency >= currencies.size())
+          || !amount.get_compact(is) || !balance.get_compact(is) || !is.get(user_fields)) {
+        return false;
+      }
+      Transaction t(addresses[source], addresses[target], currencies[currency], amount, balance);
+      for (const auto& it : user_fields) {
+        t.add_user_field(it.first, it.second);
+      }
+      transactions.push_back(t);
+    }
+    return true;
+  }
+
+  /// Таблицы и столбцы формата Pool::ColumnarFormat.
+  static bool safe_decode_columnar(ibstream& is, ::std::vector<Transaction>& transactions)
+  {
+    ::std::vector<Address> addresses;
+    ::std::vector<Currency> currencies;
+    size_t count;
+    ::csdb::priv::columnar_layout layout;
+    if (!is.get(addresses) || !is.get(currencies) || !is.get(count) || !layout.get(is, count)) {
+      return false;
+    }
+
+    const uint8_t* indices = static_cast<const uint8_t*>(is.data());
+    const size_t column_size = layout.index_column_size(count);
+    if (!is.skip(3 * column_size)) {
+      return false;
+    }
+    ibstream amounts(is.data(), layout.amounts_size);
+    if (!is.skip(layout.amounts_size)) {
+      return false;
+    }
+    ibstream balances(is.data(), layout.balances_size);
+    if (!is.skip(layout.balances_size)) {
+      return false;
+    }
+    ibstream user_fields(is.data(), layout.user_fields_size);
+    if (!is.skip(layout.user_fields_size)) {
+      return false;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+      const size_t source = ::csdb::priv::get_column_index(indices, i, layout.index_width);
+      const size_t target = ::csdb::priv::get_column_index(indices + column_size, i, layout.index_width);
+      const size_t currency = ::csdb::priv::get_column_index(indices + 2 * column_size, i, layout.index_width);
+      Amount amount, balance;
+      user_field_map_t fields;
+      if ((source >= addresses.size()) || (target >= addresses.size())
+          || (currency >= currencies.size())
+          || !amount.get_compact(amounts) || !balance.get_compact(balances) || !user_fields.get(fields)) {
+        return false;
+      }
+      Transaction t(addresses[source], addresses[target], currencies[currency], amount, balance);
+      for (const auto& it : fields) {
+        t.add_user_field(it.first, it.second);
+      }
+      transactions.push_back(t);
+    }
+    return amounts.empty() && balances.empty() && user_fields.empty();
+  }
+
+  /// Проверяет, что быстрый путь принимает те же данные и читает то же, что и проверяющий.
+  static void check_same(const internal::byte_array& data)
+  {
+    ::std::vector<Transaction> expected;
+    const bool safe = safe_decode(data, expected);
+    size_t count = 0;
+    ASSERT_EQ(scan_pool(data.data(), data.size(), count), safe);
+
+    const Pool pool = Pool::from_binary(data);
+    ASSERT_EQ(pool.is_valid(), safe);
+    if (safe) {
+      ASSERT_EQ(pool.transactions_count(), expected.size());
+      for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(pool.transaction(i), expected[i]);
+      }
+    }
+  }
+
+  internal::byte_array binary_;
+  internal::byte_array dictionary_;
+  internal::byte_array columnar_;
+  Address addr1 = Address::from_string("0000000000000000000000000000000000000001");
+  Address addr2 = Address::from_string("0000000000000000000000000000000000000002");
+};
+
+TEST_F(PoolScanTest, Valid)
+{
+  size_t count = 0;
+  EXPECT_TRUE(scan_pool(binary_.data(), binary_.size(), count));
+  EXPECT_EQ(count, static_cast<size_t>(2));
+  check_same(binary_);
+}
+
+TEST_F(PoolScanTest, Truncated)
+{
+  for (size_t size = 0; size < binary_.size(); ++size) {
+    SCOPED_TRACE(size);
+    check_same(internal::byte_array(binary_.begin(), binary_.begin() + size));
+  }
+}
+
+TEST_F(PoolScanTest, Corrupted)
+{
+  for (size_t pos = 0; pos < binary_.size(); ++pos) {
+    const uint8_t original = binary_[pos];
+    for (uint8_t value : {uint8_t(0x00), uint8_t(0xFF), uint8_t(0x7F),
+                          uint8_t(original ^ 0x01), uint8_t(original ^ 0x80)}) {
+      SCOPED_TRACE(::testing::Message() << "pos = " << pos << ", value = " << int(value));
+      internal::byte_array data = binary_;
+      data[pos] = value;
+      check_same(data);
+    }
+  }
+}
+
+TEST_F(PoolScanTest, TrailingData)
+{
+  internal::byte_array data = binary_;
+  data.push_back(0xFF);
+  check_same(data);
+}
+
+TEST_F(PoolScanTest, Transaction)
+{
+  Transaction t(addr1, addr2, Currency("CS"), 1.5_c);
+  t.add_user_field(2, "Text");
+  const internal::byte_array data = t.to_binary();
+  for (size_t size = 0; size <= data.size(); ++size) {
+    const internal::byte_array part(data.begin(), data.begin() + size);
+    ibstream is(part.data(), part.size());
+    EXPECT_EQ(::csdb::priv::scan_transaction(is), size == data.size());
+    EXPECT_EQ(Transaction::from_binary(part).is_valid(), size == data.size());
+  }
+  EXPECT_EQ(Transaction::from_binary(data), t);
+}
+
+TEST_F(PoolScanTest, DictionaryValid)
+{
+  size_t count = 0;
+  EXPECT_TRUE(scan_pool(dictionary_.data(), dictionary_.size(), count));
+  EXPECT_EQ(count, static_cast<size_t>(2));
+  check_same(dictionary_);
+}
+
+TEST_F(PoolScanTest, DictionaryTruncated)
+{
+  for (size_t size = 0; size < dictionary_.size(); ++size) {
+    SCOPED_TRACE(size);
+    check_same(internal::byte_array(dictionary_.begin(), dictionary_.begin() + size));
+  }
+}
+
+TEST_F(PoolScanTest, DictionaryCorrupted)
+{
+  for (size_t pos = 0; pos < dictionary_.size(); ++pos) {
+    const uint8_t original = dictionary_[pos];
+    for (uint8_t value : {uint8_t(0x00), uint8_t(0xFF), uint8_t(0x7F), uint8_t(0x7E),
+                          uint8_t(original ^ 0x01), uint8_t(original ^ 0x80)}) {
+      SCOPED_TRACE(::testing::Message() << "pos = " << pos << ", value = " << int(value));
+      internal::byte_array data = dictionary_;
+      data[pos] = value;
+      check_same(data);
+    }
+  }
+}
+
+TEST_F(PoolScanTest, ColumnarValid)
+{
+  size_t count = 0;
+  EXPECT_TRUE(scan_pool(columnar_.data(), columnar_.size(), count));
+  EXPECT_EQ(count, static_cast<size_t>(2));
+  check_same(columnar_);
+}
+
+TEST_F(PoolScanTest, ColumnarTruncated)
+{
+  for (size_t size = 0; size < columnar_.size(); ++size) {
+    SCOPED_TRACE(size);
+    check_same(internal::byte_array(columnar_.begin(), columnar_.begin() + size));
+  }
+}
+
+TEST_F(PoolScanTest, ColumnarCorrupted)
+{
+  for (size_t pos = 0; pos < columnar_.size(); ++pos) {
+    const uint8_t original = columnar_[pos];
+    for (uint8_t value : {uint8_t(0x00), uint8_t(0xFF), uint8_t(0x7F), uint8_t(0x7E),
+                          uint8_t(original ^ 0x01), uint8_t(original ^ 0x80)}) {
+      SCOPED_TRACE(::testing::Message() << "pos = " << pos << ", value = " << int(value));
+      internal::byte_array data = columnar_;
+      data[pos] = value;
+      check_same(data);
+    }
+  }
+}
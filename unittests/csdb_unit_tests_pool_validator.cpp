@@ -0,0 +1,262 @@
+#include "csdb/pool_validator.h"
+
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "csdb_unit_tests_environment.h"
+
+#include "csdb/csdb.h"
+#include "csdb/pool.h"
+#include "csdb/storage.h"
+#include "csdb/internal/utils.h"
+
+using namespace csdb;
+
+class PoolValidatorTest : public ::testing::Test
+{
+protected:
+  PoolValidatorTest() :
+    path_to_tests_(::csdb::internal::app_data_path() + "csdb_unittests_pool_validator")
+  {
+  }
+
+  void TearDown() override
+  {
+    ASSERT_TRUE(::csdb::internal::path_remove(path_to_tests_));
+  }
+
+  ::std::string path_to_tests_;
+};
+
+namespace {
+
+/// Отклоняет транзакции с нечётными номерами и запоминает потоки, в которых вызывалась.
+class OddRejector : public PoolValidator
+{
+public:
+  Verdict validate(const Transaction&, size_t index) const override
+  {
+    {
+      ::std::lock_guard<::std::mutex> lock(mutex_);
+      threads_.insert(::std::this_thread::get_id());
+    }
+    return (0 == (index % 2)) ? Valid : Rejected;
+  }
+
+  size_t threads_count() const
+  {
+    ::std::lock_guard<::std::mutex> lock(mutex_);
+    return threads_.size();
+  }
+
+private:
+  mutable ::std::mutex mutex_;
+  mutable ::std::set<::std::thread::id> threads_;
+};
+
+/// Отклоняет транзакции с суммой больше заданной.
+class AmountLimit : public PoolValidator
+{
+public:
+  explicit AmountLimit(Amount limit) : limit_(limit) {}
+
+  Verdict validate(const Transaction& transaction, size_t) const override
+  {
+    return (transaction.amount() > limit_) ? Rejected : Valid;
+  }
+
+private:
+  Amount limit_;
+};
+
+} // namespace
+
+TEST_F(PoolValidatorTest, Balance)
+{
+  Storage s;
+  ASSERT_TRUE(s.open(path_to_tests_));
+
+  const Address a = make_test_address(1), b = make_test_address(2), c = make_test_address(3);
+  Pool genesis{PoolHash{}, 0, s};
+  EXPECT_TRUE(genesis.add_transaction(Transaction(c, a, Currency("RUB"), 100_c), true));
+  EXPECT_TRUE(genesis.add_transaction(Transaction(c, a, Currency("USD"), 10_c), true));
+  EXPECT_TRUE(genesis.add_transaction(Transaction(a, b, Currency("RUB"), 10_c), true));
+  ASSERT_TRUE(genesis.compose());
+  ASSERT_TRUE(genesis.save());
+
+  // Баланс a: 90 RUB и 10 USD.
+  Pool pool{genesis.hash(), 1, s};
+  EXPECT_TRUE(pool.add_transaction(Transaction(a, b, Currency("RUB"), 50_c), true));
+  EXPECT_TRUE(pool.add_transaction(Transaction(a, c, Currency("USD"), 10_c), true));
+  EXPECT_TRUE(pool.add_transaction(Transaction(a, c, Currency("RUB"), 40_c), true));
+  EXPECT_TRUE(pool.add_transaction(Transaction(a, c, Currency("RUB"), 1_c), true));
+  EXPECT_TRUE(pool.add_transaction(Transaction(b, a, Currency("RUB"), 11_c), true));
+  EXPECT_TRUE(pool.add_transaction(Transaction(b, a, Currency("RUB"), 10_c), true));
+  EXPECT_TRUE(pool.add_transaction(Transaction(a, b, Currency("EUR"), 1_c), true));
+
+  BalanceValidator validator(s);
+  const ::std::vector<PoolValidator::Verdict> expected{
+    PoolValidator::Valid, PoolValidator::Valid, PoolValidator::Valid, PoolValidator::DoubleSpend,
+    PoolValidator::InsufficientFunds, PoolValidator::Valid, PoolValidator::InsufficientFunds};
+  EXPECT_EQ(pool.validate(validator), expected);
+
+  // Без хранилища балансы нулевые.
+  Pool detached{PoolHash{}, 0};
+  EXPECT_TRUE(detached.add_transaction(Transaction(a, b, Currency("RUB"), 1_c), true));
+  BalanceValidator empty{Storage{}};
+  if (!::csdb::defaultStorage().isOpen()) {
+    EXPECT_EQ(detached.validate(empty), ::std::vector<PoolValidator::Verdict>{PoolValidator::InsufficientFunds});
+  }
+}
+
+TEST_F(PoolValidatorTest, ParallelBalance)
+{
+  Storage s;
+  ASSERT_TRUE(s.open(path_to_tests_));
+
+  // Цепочка из пулов разных форматов, по которой каждый отправитель получает 2 RUB.
+  const size_t senders = 600, pools = 40;
+  const Address whale = make_test_address(senders);
+  PoolHash previous;
+  for (size_t p = 0; p < pools; ++p) {
+    Pool pool{previous, p, s};
+    pool.set_format((0 == (p % 2)) ? Pool::LegacyFormat : Pool::ColumnarFormat);
+    for (size_t i = 0; i < senders * 2 / pools; ++i) {
+      const Address target = make_test_address((p * senders * 2 / pools + i) % senders);
+      EXPECT_TRUE(pool.add_transaction(Transaction(whale, target, Currency("RUB"), 1_c), true));
+    }
+    ASSERT_TRUE(pool.compose());
+    ASSERT_TRUE(pool.save());
+    previous = pool.hash();
+  }
+
+  Pool pool{previous, pools, s};
+  for (size_t n = 0; n < 3; ++n) {
+    for (size_t i = 0; i < senders; ++i) {
+      EXPECT_TRUE(pool.add_transaction(Transaction(make_test_address(i), whale, Currency("RUB"), 1_c), true));
+    }
+  }
+
+  // Цепочка и отправители делятся между потоками, результат не зависит от их количества.
+  BalanceValidator validator(s);
+  const ::std::vector<PoolValidator::Verdict> serial = pool.validate(validator, 1);
+  ASSERT_EQ(serial.size(), senders * 3);
+  for (size_t i = 0; i < serial.size(); ++i) {
+    ASSERT_EQ(serial[i], (i < senders * 2) ? PoolValidator::Valid : PoolValidator::DoubleSpend) << i;
+  }
+  EXPECT_EQ(pool.validate(validator, 4), serial);
+}
+
+TEST_F(PoolValidatorTest, UserFields)
+{
+  UserFieldValidator validator;
+  validator.require(1, UserField::Integer);
+  validator.add_constraint(2, [](const UserField& field) {
+    return (UserField::String == field.type()) && (!field.value<::std::string>().empty());
+  });
+
+  Pool pool{PoolHash{}, 0};
+  const Address a = make_test_address(1), b = make_test_address(2);
+  auto add = [&](UserField f1, UserField f2) {
+    Transaction t(a, b, Currency("RUB"), 1_c);
+    if (f1.is_valid()) {
+      EXPECT_TRUE(t.add_user_field(1, f1));
+    }
+    if (f2.is_valid()) {
+      EXPECT_TRUE(t.add_user_field(2, f2));
+    }
+    EXPECT_TRUE(pool.add_transaction(t, true));
+  };
+  add(UserField(5), UserField{});
+  add(UserField(5), UserField("text"));
+  add(UserField{}, UserField("text"));
+  add(UserField("5"), UserField{});
+  add(UserField(5), UserField(""));
+  add(UserField(5), UserField(7));
+
+  const ::std::vector<PoolValidator::Verdict> expected{
+    PoolValidator::Valid, PoolValidator::Valid, PoolValidator::UserFieldViolation,
+    PoolValidator::UserFieldViolation, PoolValidator::UserFieldViolation, PoolValidator::UserFieldViolation};
+  EXPECT_EQ(pool.validate(validator), expected);
+}
+
+TEST_F(PoolValidatorTest, ParallelAndChain)
+{
+  const size_t count = 10000;
+  Pool pool{PoolHash{}, 0};
+  for (size_t i = 0; i < count; ++i) {
+    Transaction t(make_test_address(i % 7), make_test_address(i % 7 + 7), Currency("RUB"), 1_c);
+    if (0 == (i % 3)) {
+      EXPECT_TRUE(t.add_user_field(1, "Text"));
+    }
+    EXPECT_TRUE(pool.add_transaction(t, true));
+  }
+
+  auto rejector = ::std::make_shared<OddRejector>();
+  auto fields = ::std::make_shared<UserFieldValidator>();
+  fields->require(1, UserField::String);
+  PoolValidatorChain chain;
+  chain.add(fields);
+  chain.add(rejector);
+
+  const ::std::vector<PoolValidator::Verdict> serial = pool.validate(chain, 1);
+  EXPECT_EQ(rejector->threads_count(), static_cast<size_t>(1));
+  ASSERT_EQ(serial.size(), count);
+  for (size_t i = 0; i < count; ++i) {
+    const PoolValidator::Verdict expected = (0 != (i % 3)) ? PoolValidator::UserFieldViolation
+                                          : ((0 != (i % 2)) ? PoolValidator::Rejected : PoolValidator::Valid);
+    ASSERT_EQ(serial[i], expected) << i;
+  }
+
+  // Транзакции делятся между потоками, результат не зависит от их количества.
+  EXPECT_EQ(pool.validate(chain, 4), serial);
+  OddRejector parallel;
+  const ::std::vector<PoolValidator::Verdict> verdicts = pool.validate(parallel, 4);
+  EXPECT_EQ(parallel.threads_count(), static_cast<size_t>(4));
+  for (size_t i = 0; i < count; ++i) {
+    ASSERT_EQ(verdicts[i], (0 != (i % 2)) ? PoolValidator::Rejected : PoolValidator::Valid) << i;
+  }
+}
+
+TEST_F(PoolValidatorTest, Compose)
+{
+  Pool pool{PoolHash{}, 0};
+  for (int32_t i = 1; i <= 6; ++i) {
+    EXPECT_TRUE(pool.add_transaction(Transaction(make_test_address(1), make_test_address(2), Currency("RUB"), Amount(i)), true));
+  }
+
+  AmountLimit validator(3_c);
+  ::std::vector<PoolValidator::Verdict> verdicts;
+  EXPECT_FALSE(pool.compose(validator, &verdicts));
+  EXPECT_FALSE(pool.is_read_only());
+  EXPECT_EQ(verdicts, (::std::vector<PoolValidator::Verdict>{PoolValidator::Valid, PoolValidator::Valid,
+                       PoolValidator::Valid, PoolValidator::Rejected, PoolValidator::Rejected,
+                       PoolValidator::Rejected}));
+
+  // Транзакции, не прошедшие проверку, удаляются, и пул формируется.
+  ::std::vector<Transaction>& transactions = pool.transactions();
+  for (size_t i = verdicts.size(); i > 0; --i) {
+    if (PoolValidator::Valid != verdicts[i - 1]) {
+      transactions.erase(transactions.begin() + static_cast<ptrdiff_t>(i - 1));
+    }
+  }
+  EXPECT_TRUE(pool.compose(validator, &verdicts, 1));
+  EXPECT_TRUE(pool.is_read_only());
+  EXPECT_EQ(pool.transactions_count(), static_cast<size_t>(3));
+  EXPECT_EQ(verdicts.size(), static_cast<size_t>(3));
+
+  Pool copy{PoolHash{}, 0};
+  for (int32_t i = 1; i <= 3; ++i) {
+    EXPECT_TRUE(copy.add_transaction(Transaction(make_test_address(1), make_test_address(2), Currency("RUB"), Amount(i)), true));
+  }
+  EXPECT_TRUE(copy.compose());
+  EXPECT_EQ(pool.hash(), copy.hash());
+
+  // Сформированный пул не проверяется.
+  EXPECT_TRUE(pool.compose(validator, &verdicts));
+  EXPECT_TRUE(verdicts.empty());
+}
@@ -0,0 +1,180 @@
+#include "serialization_schema.h"
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace ::csdb::priv;
+
+namespace {
+
+/// Все поля целые - запись в заранее выделенную область, чтение одним блоком.
+struct Integers
+{
+  int32_t a;
+  uint64_t b;
+  int8_t c;
+
+  typedef schema<Integers,
+                 CSDB_SCHEMA_FIELD(Integers, a),
+                 CSDB_SCHEMA_FIELD(Integers, b),
+                 CSDB_SCHEMA_FIELD(Integers, c)> serialization_schema;
+
+  // Вложенный тип сериализуется через свою схему, как это делают классы csdb.
+  void put(obstream& os) const { serialization_schema::put(os, *this); }
+  bool get(ibstream& is) { return serialization_schema::get(is, *this); }
+  void get(unchecked_ibstream& is) { serialization_schema::get(is, *this); }
+  size_t serialized_size() const { return serialization_schema::serialized_size(*this); }
+
+  bool operator ==(const Integers& other) const
+  {
+    return (a == other.a) && (b == other.b) && (c == other.c);
+  }
+};
+
+/// Размер всех полей ограничен, но не все поля целые.
+struct Bounded
+{
+  bool flag;
+  ::csdb::internal::fixed_byte_array<8> bytes;
+  int64_t value;
+
+  typedef schema<Bounded,
+                 CSDB_SCHEMA_FIELD(Bounded, flag),
+                 CSDB_SCHEMA_FIELD(Bounded, bytes),
+                 CSDB_SCHEMA_FIELD(Bounded, value)> serialization_schema;
+
+  bool operator ==(const Bounded& other) const
+  {
+    return (flag == other.flag) && (bytes == other.bytes) && (value == other.value);
+  }
+};
+
+/// Размер не ограничен.
+struct Unbounded
+{
+  std::string name;
+  Integers nested;
+  std::vector<int32_t> list;
+
+  typedef schema<Unbounded,
+                 CSDB_SCHEMA_FIELD(Unbounded, name),
+                 CSDB_SCHEMA_FIELD(Unbounded, nested),
+                 CSDB_SCHEMA_FIELD(Unbounded, list)> serialization_schema;
+
+  bool operator ==(const Unbounded& other) const
+  {
+    return (name == other.name) && (nested == other.nested) && (list == other.list);
+  }
+};
+
+} // namespace
+
+static_assert(Integers::serialization_schema::max_size == 3 * MAX_INTEGRAL_ENCODED_SIZE,
+              "Invalid max_size for integral fields.");
+static_assert(Bounded::serialization_schema::max_size == 1 + 2 * MAX_INTEGRAL_ENCODED_SIZE + 8,
+              "Invalid max_size for bounded fields.");
+
+TEST(SerializationSchema, IntegersMatchFieldByField)
+{
+  const Integers src{-123456, 0xFFFFFFFFFFFFULL, -1};
+
+  obstream expected;
+  expected.put(src.a);
+  expected.put(src.b);
+  expected.put(src.c);
+
+  obstream os;
+  os.put("prefix", 6);
+  Integers::serialization_schema::put(os, src);
+  EXPECT_EQ(os.buffer().size(), 6 + Integers::serialization_schema::serialized_size(src));
+  EXPECT_EQ(::csdb::internal::byte_array(os.buffer().begin() + 6, os.buffer().end()), expected.buffer());
+
+  Integers checked{};
+  ibstream is(expected.buffer());
+  EXPECT_TRUE(Integers::serialization_schema::get(is, checked));
+  EXPECT_TRUE(is.empty());
+  EXPECT_EQ(checked, src);
+
+  Integers unchecked{};
+  unchecked_ibstream uis(expected.buffer().data(), expected.buffer().size());
+  Integers::serialization_schema::get(uis, unchecked);
+  EXPECT_EQ(uis.size(), 0u);
+  EXPECT_EQ(unchecked, src);
+}
+
+TEST(SerializationSchema, BoundedMatchFieldByField)
+{
+  Bounded src;
+  src.flag = true;
+  src.bytes.assign(reinterpret_cast<const uint8_t*>("abcde"), 5);
+  src.value = ::std::numeric_limits<int64_t>::min();
+
+  obstream expected;
+  expected.put(src.flag);
+  expected.put(src.bytes);
+  expected.put(src.value);
+
+  obstream os;
+  Bounded::serialization_schema::put(os, src);
+  EXPECT_EQ(os.buffer(), expected.buffer());
+  EXPECT_EQ(os.buffer().size(), Bounded::serialization_schema::serialized_size(src));
+
+  Bounded checked;
+  ibstream is(expected.buffer());
+  EXPECT_TRUE(Bounded::serialization_schema::get(is, checked));
+  EXPECT_EQ(checked, src);
+
+  Bounded unchecked;
+  unchecked_ibstream uis(expected.buffer().data(), expected.buffer().size());
+  Bounded::serialization_schema::get(uis, unchecked);
+  EXPECT_EQ(unchecked, src);
+}
+
+TEST(SerializationSchema, Unbounded)
+{
+  EXPECT_EQ(Unbounded::serialization_schema::max_size, 0u);
+
+  Unbounded src;
+  src.name = "name";
+  src.nested = Integers{1, 2, 3};
+  src.list = {100, -100, 100000};
+
+  obstream expected;
+  expected.put(src.name);
+  expected.put(src.nested);
+  expected.put(src.list.size());
+  for (int32_t v : src.list) {
+    expected.put(v);
+  }
+
+  obstream os;
+  Unbounded::serialization_schema::put(os, src);
+  EXPECT_EQ(os.buffer(), expected.buffer());
+  EXPECT_EQ(os.buffer().size(), Unbounded::serialization_schema::serialized_size(src));
+
+  Unbounded checked;
+  ibstream is(os.buffer());
+  EXPECT_TRUE(Unbounded::serialization_schema::get(is, checked));
+  EXPECT_EQ(checked, src);
+
+  Unbounded unchecked;
+  unchecked_ibstream uis(os.buffer().data(), os.buffer().size());
+  Unbounded::serialization_schema::get(uis, unchecked);
+  EXPECT_EQ(unchecked, src);
+}
+
+TEST(SerializationSchema, CheckedGetStopsOnError)
+{
+  const Integers src{1000, 2000, 3};
+  obstream os;
+  Integers::serialization_schema::put(os, src);
+
+  for (size_t size = 0; size < os.buffer().size(); ++size) {
+    Integers dst{};
+    ibstream is(os.buffer().data(), size);
+    EXPECT_FALSE(Integers::serialization_schema::get(is, dst)) << size;
+  }
+}
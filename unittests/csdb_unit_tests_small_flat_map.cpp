@@ -0,0 +1,132 @@
+#include "csdb/internal/small_flat_map.h"
+
+#include <map>
+#include <string>
+#include <memory>
+
+#include <gtest/gtest.h>
+
+using namespace ::csdb::internal;
+
+using test_map = small_flat_map<int, ::std::string, 3>;
+
+namespace {
+
+::std::map<int, ::std::string> to_std_map(const test_map& m)
+{
+  ::std::map<int, ::std::string> res;
+  for (const auto& it : m) {
+    res.emplace(it.first, it.second);
+  }
+  return res;
+}
+
+} // namespace
+
+TEST(SmallFlatMap, Empty)
+{
+  test_map m;
+  EXPECT_TRUE(m.empty());
+  EXPECT_EQ(m.size(), static_cast<size_t>(0));
+  EXPECT_EQ(m.capacity(), static_cast<size_t>(3));
+  EXPECT_EQ(m.begin(), m.end());
+  EXPECT_EQ(m.find(1), m.end());
+}
+
+TEST(SmallFlatMap, SortedInsert)
+{
+  test_map m;
+  EXPECT_TRUE(m.emplace(5, "5"));
+  EXPECT_TRUE(m.emplace(1, "1"));
+  EXPECT_TRUE(m.emplace(3, "3"));
+  EXPECT_FALSE(m.emplace(3, "33"));
+  EXPECT_EQ(m.capacity(), static_cast<size_t>(3));
+
+  int prev = -1;
+  for (const auto& it : m) {
+    EXPECT_LT(prev, it.first);
+    prev = it.first;
+  }
+  EXPECT_EQ(m.find(3)->second, "3");
+  EXPECT_EQ(m.count(4), static_cast<size_t>(0));
+
+  m.insert_or_assign(3, "33");
+  EXPECT_EQ(m.find(3)->second, "33");
+  EXPECT_EQ(m.size(), static_cast<size_t>(3));
+}
+
+TEST(SmallFlatMap, Grow)
+{
+  test_map m;
+  ::std::map<int, ::std::string> ref;
+  for (int i = 0; i < 20; ++i) {
+    const int key = (i * 7) % 20;
+    m.insert_or_assign(key, ::std::to_string(i));
+    ref[key] = ::std::to_string(i);
+  }
+  EXPECT_GE(m.capacity(), static_cast<size_t>(20));
+  EXPECT_EQ(to_std_map(m), ref);
+  EXPECT_TRUE(std::equal(m.begin(), m.end(), ref.begin(),
+                         [](const test_map::value_type& a, const ::std::pair<const int, ::std::string>& b) {
+                           return (a.first == b.first) && (a.second == b.second);
+                         }));
+}
+
+TEST(SmallFlatMap, SortUnique)
+{
+  test_map m;
+  ::std::map<int, ::std::string> ref;
+  const int keys[] = {5, 1, 3, 1, 5, 4};
+  for (int i = 0; i < 6; ++i) {
+    m.push_back_unordered(keys[i], ::std::to_string(i));
+    ref.emplace(keys[i], ::std::to_string(i));
+  }
+  m.sort_unique();
+  EXPECT_EQ(m.size(), static_cast<size_t>(4));
+  EXPECT_EQ(to_std_map(m), ref);
+  EXPECT_EQ(m.find(5)->second, "0");
+}
+
+TEST(SmallFlatMap, CopyAndMove)
+{
+  for (int count : {2, 10}) {
+    test_map m;
+    for (int i = 0; i < count; ++i) {
+      m.emplace(i, ::std::to_string(i));
+    }
+
+    test_map copy(m);
+    EXPECT_EQ(to_std_map(copy), to_std_map(m));
+
+    test_map moved(::std::move(copy));
+    EXPECT_EQ(to_std_map(moved), to_std_map(m));
+    EXPECT_TRUE(copy.empty());
+
+    test_map assigned;
+    assigned.emplace(100, "100");
+    assigned = m;
+    EXPECT_EQ(to_std_map(assigned), to_std_map(m));
+
+    test_map move_assigned;
+    move_assigned.emplace(100, "100");
+    move_assigned = ::std::move(assigned);
+    EXPECT_EQ(to_std_map(move_assigned), to_std_map(m));
+    EXPECT_TRUE(assigned.empty());
+  }
+}
+
+TEST(SmallFlatMap, Destruction)
+{
+  auto value = ::std::make_shared<int>(0);
+  {
+    small_flat_map<int, ::std::shared_ptr<int>, 2> m;
+    for (int i = 0; i < 5; ++i) {
+      m.emplace(i, value);
+    }
+    EXPECT_EQ(value.use_count(), 6);
+    m.clear();
+    EXPECT_EQ(value.use_count(), 1);
+    m.emplace(1, value);
+  }
+  EXPECT_EQ(value.use_count(), 1);
+}
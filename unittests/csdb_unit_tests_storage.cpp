@@ -1,9 +1,18 @@
 #include "csdb/storage.h"
 
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
 #include "csdb_unit_tests_environment.h"
 
+#include "csdb/database_leveldb.h"
+#include "csdb/pool_columns.h"
 #include "csdb/wallet.h"
 #include "csdb/internal/utils.h"
+#include "block_compression.h"
+#include "priv_crypto.h"
 
 using namespace csdb;
 
@@ -292,4 +301,480 @@ TEST_F(StorageTestEmpty, GetTransactionBySourceAndTarget)
   ::csdb::Address addr4 = ::csdb::Address::from_string("0000000000000000000000000000000000000004");
   EXPECT_FALSE(s.get_last_by_source(addr4).is_valid());
   EXPECT_FALSE(s.get_last_by_target(addr4).is_valid());
-}
\ No newline at end of file
+}
+//
+// Compression
+//
+
+TEST_F(StorageTestEmpty, Compression)
+{
+  auto make_address = [](size_t index) {
+    internal::byte_array key(::csdb::priv::crypto::public_key_size, 0xAA);
+    key[0] = static_cast<uint8_t>(index);
+    return Address::from_public_key(key);
+  };
+  auto make_pool = [&make_address](PoolHash previous, Pool::sequence_t sequence) {
+    Pool res{previous, sequence};
+    res.set_format((0 == (sequence % 2)) ? Pool::LegacyFormat : Pool::DictionaryFormat);
+    for (size_t i = 0; i < 40; ++i) {
+      const size_t n = sequence * 7 + i;
+      EXPECT_TRUE(res.add_transaction(Transaction(make_address(n % 30), make_address((n * 3 + 1) % 31 + 30),
+                                                  Currency("RUB"), Amount(static_cast<int32_t>(n + 1), 5)), true));
+    }
+    EXPECT_TRUE(res.compose());
+    return res;
+  };
+
+  auto open_db = [this]() {
+    auto res = ::std::make_shared<DatabaseLevelDB>();
+    EXPECT_TRUE(res->open(path_to_tests));
+    return ::std::shared_ptr<Database>(res);
+  };
+
+  ::std::shared_ptr<Database> db = open_db();
+  Storage s;
+  ASSERT_TRUE(s.open(Storage::OpenOptions{db}));
+  EXPECT_EQ(s.compression(), Storage::NoCompression);
+
+  // Словарь нельзя построить без пулов.
+  EXPECT_FALSE(s.train_compression_dictionary());
+
+  ::std::vector<Pool> pools;
+  PoolHash previous;
+  const Storage::Compression modes[] = {Storage::NoCompression, Storage::FastCompression,
+                                        Storage::DictionaryCompression};
+  for (Pool::sequence_t i = 0; i < 9; ++i) {
+    if (6 == i) {
+      ASSERT_TRUE(s.train_compression_dictionary());
+    }
+    s.set_compression(modes[i % 3]);
+    EXPECT_EQ(s.compression(), modes[i % 3]);
+
+    const Pool pool = make_pool(previous, i);
+    ASSERT_TRUE(s.pool_save(pool));
+    previous = pool.hash();
+    pools.push_back(pool);
+
+    internal::byte_array record;
+    ASSERT_TRUE(db->get(pool.hash().to_binary(), &record));
+    const internal::byte_array binary = pool.to_binary();
+    if (Storage::NoCompression == modes[i % 3]) {
+      // Несжатый пул хранится целиком между заголовком записи и контрольной суммой.
+      ASSERT_GT(record.size(), binary.size() + 4);
+      EXPECT_TRUE(::std::equal(binary.begin(), binary.end(), record.end() - 4 - binary.size()));
+    } else {
+      EXPECT_LT(record.size(), binary.size());
+    }
+    if (8 == i) {
+      // Со словарём запись короче, чем при сжатии каждого пула отдельно.
+      EXPECT_LT(record.size(), ::csdb::priv::lz_compress(binary.data(), binary.size()).size());
+    }
+
+    const Pool loaded = s.pool_load(pool.hash());
+    EXPECT_EQ(loaded, pool);
+    EXPECT_EQ(loaded.to_binary(), binary);
+  }
+
+  // Хеши проверяются по несжатым данным при повторном открытии; словарь сохраняется в базе.
+  s.close();
+  db.reset();
+  ASSERT_TRUE(s.open(path_to_tests));
+  EXPECT_EQ(s.size(), pools.size());
+  EXPECT_EQ(s.last_hash(), pools.back().hash());
+  for (const auto& pool : pools) {
+    EXPECT_EQ(s.pool_load(pool.hash()).to_binary(), pool.to_binary());
+    EXPECT_TRUE(s.pool_load_columns(pool.hash()).is_valid());
+    size_t cnt = 0;
+    EXPECT_EQ(s.pool_load_meta(pool.hash(), cnt).sequence(), pool.sequence());
+    EXPECT_EQ(cnt, pool.transactions_count());
+  }
+  for (size_t i = pools.back().transactions_count(); i > 0; --i) {
+    const Transaction t = pools.back().transaction(i - 1);
+    if (t.source() == make_address(3)) {
+      EXPECT_EQ(s.get_last_by_source(make_address(3)), t);
+      break;
+    }
+  }
+
+  s.set_compression(Storage::DictionaryCompression);
+  const Pool pool = make_pool(previous, pools.size());
+  ASSERT_TRUE(s.pool_save(pool));
+  s.close();
+
+  // Повреждённая сжатая запись обнаруживается при открытии.
+  db = open_db();
+  internal::byte_array record;
+  ASSERT_TRUE(db->get(pool.hash().to_binary(), &record));
+  const internal::byte_array binary = pool.to_binary();
+  EXPECT_LT(record.size(), ::csdb::priv::lz_compress(binary.data(), binary.size()).size());
+  record.resize(record.size() - 1);
+  ASSERT_TRUE(db->put(pool.hash().to_binary(), record));
+  EXPECT_FALSE(s.open(Storage::OpenOptions{db}));
+  EXPECT_EQ(s.last_error(), Storage::DataIntegrityError);
+}
+
+//
+// Batch save
+//
+
+TEST_F(StorageTestEmpty, SaveBatch)
+{
+  auto open_db = [this]() {
+    auto res = ::std::make_shared<DatabaseLevelDB>();
+    EXPECT_TRUE(res->open(path_to_tests));
+    return ::std::shared_ptr<Database>(res);
+  };
+
+  // Цепочка длиннее пачки, хешируемой при открытии за один раз.
+  ::std::vector<Pool> pools;
+  ::std::vector<internal::byte_array> binaries;
+  PoolHash previous;
+  for (Pool::sequence_t i = 0; i < 150; ++i) {
+    Pool pool{previous, i};
+    for (int j = 0; j <= static_cast<int>(i % 5); ++j) {
+      EXPECT_TRUE(pool.add_transaction(Transaction(addr1, addr2, Currency("RUB"), Amount(j + 1)), true));
+    }
+    ASSERT_TRUE(pool.compose());
+    previous = pool.hash();
+    pools.push_back(pool);
+    binaries.push_back(pool.to_binary());
+  }
+
+  Storage s;
+  EXPECT_FALSE(s.pool_save_batch(binaries));
+  EXPECT_EQ(s.last_error(), Storage::NotOpen);
+
+  ::std::shared_ptr<Database> db = open_db();
+  ASSERT_TRUE(s.open(Storage::OpenOptions{db}));
+  ASSERT_TRUE(s.pool_save_batch(::std::vector<internal::byte_array>(binaries.begin(), binaries.begin() + 100)));
+  EXPECT_EQ(s.size(), static_cast<size_t>(100));
+  EXPECT_EQ(s.last_hash(), pools[99].hash());
+  EXPECT_EQ(s.pool_load(pools[42].hash()), pools[42]);
+
+  // При ошибке не записывается ни один пул.
+  ::std::vector<internal::byte_array> rest(binaries.begin() + 100, binaries.end());
+  rest.push_back({1, 2, 3});
+  EXPECT_FALSE(s.pool_save_batch(rest));
+  EXPECT_EQ(s.last_error(), Storage::InvalidParameter);
+  rest.back() = binaries[10];
+  EXPECT_FALSE(s.pool_save_batch(rest));
+  rest.back() = binaries.back();
+  EXPECT_FALSE(s.pool_save_batch(rest));
+  EXPECT_EQ(s.last_error(), Storage::InvalidParameter);
+  EXPECT_EQ(s.size(), static_cast<size_t>(100));
+  EXPECT_FALSE(s.pool_load(pools[100].hash()).is_valid());
+
+  rest.pop_back();
+  ASSERT_TRUE(s.pool_save_batch(rest));
+  EXPECT_EQ(s.last_hash(), pools.back().hash());
+  EXPECT_TRUE(s.pool_save_batch({}));
+  s.close();
+
+  ASSERT_TRUE(s.open(Storage::OpenOptions{db}));
+  EXPECT_EQ(s.size(), pools.size());
+  EXPECT_EQ(s.last_hash(), pools.back().hash());
+  s.close();
+
+  // Запись, не совпадающая с хешем, обнаруживается при открытии.
+  Pool other{pools[120].previous_hash(), 1000};
+  EXPECT_TRUE(other.add_transaction(Transaction(addr2, addr3, Currency("RUB"), 1_c), true));
+  ASSERT_TRUE(other.compose());
+  ASSERT_TRUE(db->put(pools[120].hash().to_binary(), other.to_binary()));
+  EXPECT_FALSE(s.open(Storage::OpenOptions{db}));
+  EXPECT_EQ(s.last_error(), Storage::DataIntegrityError);
+}
+
+//
+// Record checksums
+//
+
+TEST_F(StorageTestEmpty, Checksums)
+{
+  auto open_db = [this]() {
+    auto res = ::std::make_shared<DatabaseLevelDB>();
+    EXPECT_TRUE(res->open(path_to_tests));
+    return ::std::shared_ptr<Database>(res);
+  };
+
+  ::std::shared_ptr<Database> db = open_db();
+  Storage s;
+  ASSERT_TRUE(s.open(Storage::OpenOptions{db}));
+
+  ::std::vector<Pool> pools;
+  PoolHash previous;
+  for (Pool::sequence_t i = 0; i < 10; ++i) {
+    s.set_compression((0 == (i % 2)) ? Storage::NoCompression : Storage::FastCompression);
+    Pool pool{previous, i};
+    for (int j = 0; j < 20; ++j) {
+      EXPECT_TRUE(pool.add_transaction(Transaction(addr1, addr2, Currency("RUB"), Amount(j + 1)), true));
+    }
+    ASSERT_TRUE(pool.compose());
+    ASSERT_TRUE(s.pool_save(pool));
+    previous = pool.hash();
+    pools.push_back(pool);
+  }
+  // Запись без контрольной суммы, как в хранилищах предыдущих версий.
+  Pool old{previous, pools.size()};
+  EXPECT_TRUE(old.add_transaction(Transaction(addr2, addr3, Currency("RUB"), 1_c), true));
+  ASSERT_TRUE(old.compose());
+  ASSERT_TRUE(db->put(old.hash().to_binary(), old.to_binary()));
+  pools.push_back(old);
+  s.close();
+
+  for (Storage::Verification verification : {Storage::ChecksumVerification, Storage::FullVerification}) {
+    ASSERT_TRUE(s.open(Storage::OpenOptions{db, verification}));
+    EXPECT_EQ(s.size(), pools.size());
+    EXPECT_EQ(s.last_hash(), old.hash());
+    for (const auto& pool : pools) {
+      EXPECT_EQ(s.pool_load(pool.hash()).to_binary(), pool.to_binary());
+    }
+    s.close();
+  }
+
+  // Любой изменённый байт записи обнаруживается при открытии и при чтении.
+  for (size_t i : {2, 3}) {
+    const internal::byte_array key = pools[i].hash().to_binary();
+    internal::byte_array record;
+    ASSERT_TRUE(db->get(key, &record));
+    for (size_t pos = 0; pos < record.size(); pos += 7) {
+      SCOPED_TRACE(::testing::Message() << "pool = " << i << ", pos = " << pos);
+      internal::byte_array corrupted = record;
+      corrupted[pos] ^= 0x20;
+      ASSERT_TRUE(db->put(key, corrupted));
+      EXPECT_FALSE(s.open(Storage::OpenOptions{db, Storage::ChecksumVerification}));
+      EXPECT_EQ(s.last_error(), Storage::DataIntegrityError);
+    }
+    ASSERT_TRUE(db->put(key, record));
+  }
+  ASSERT_TRUE(s.open(Storage::OpenOptions{db, Storage::ChecksumVerification}));
+  internal::byte_array record;
+  ASSERT_TRUE(db->get(pools[4].hash().to_binary(), &record));
+  record[record.size() / 2] ^= 0x01;
+  ASSERT_TRUE(db->put(pools[4].hash().to_binary(), record));
+  EXPECT_FALSE(s.pool_load(pools[4].hash()).is_valid());
+  EXPECT_EQ(s.last_error(), Storage::DataIntegrityError);
+  record[record.size() / 2] ^= 0x01;
+  ASSERT_TRUE(db->put(pools[4].hash().to_binary(), record));
+  s.close();
+
+  // Контрольная сумма не защищает от намеренной подмены: запись с верной суммой под чужим
+  // ключом обнаруживается только полной проверкой.
+  const PoolHash fake = PoolHash::calc_from_data({1, 2, 3});
+  ASSERT_TRUE(db->get(pools[9].hash().to_binary(), &record));
+  ASSERT_TRUE(db->put(fake.to_binary(), record));
+  ASSERT_TRUE(db->remove(pools[9].hash().to_binary()));
+  ASSERT_TRUE(db->get(old.hash().to_binary(), &record));
+  ASSERT_TRUE(db->remove(old.hash().to_binary()));
+
+  ASSERT_TRUE(s.open(Storage::OpenOptions{db, Storage::ChecksumVerification}));
+  EXPECT_EQ(s.last_hash(), fake);
+  s.close();
+  EXPECT_FALSE(s.open(Storage::OpenOptions{db, Storage::FullVerification}));
+  EXPECT_EQ(s.last_error(), Storage::DataIntegrityError);
+}
+
+TEST_F(StorageTestEmpty, LoadVerification)
+{
+  auto leveldb = ::std::make_shared<DatabaseLevelDB>();
+  ASSERT_TRUE(leveldb->open(path_to_tests));
+  ::std::shared_ptr<Database> db = leveldb;
+  Storage s;
+  ASSERT_TRUE(s.open(Storage::OpenOptions{db}));
+  EXPECT_EQ(s.load_verification_interval(), static_cast<size_t>(0));
+
+  Pool pool{PoolHash{}, 0};
+  EXPECT_TRUE(pool.add_transaction(Transaction(addr1, addr2, Currency("RUB"), 1_c), true));
+  ASSERT_TRUE(pool.compose());
+  ASSERT_TRUE(s.pool_save(pool));
+
+  // Запись с верной контрольной суммой под чужим ключом.
+  const PoolHash fake = PoolHash::calc_from_data({1, 2, 3});
+  internal::byte_array record;
+  ASSERT_TRUE(db->get(pool.hash().to_binary(), &record));
+  ASSERT_TRUE(db->put(fake.to_binary(), record));
+
+  Pool loaded = s.pool_load(pool.hash());
+  EXPECT_EQ(loaded.to_binary(), pool.to_binary());
+  EXPECT_EQ(loaded.hash(), pool.hash());
+  loaded = s.pool_load(fake);
+  EXPECT_TRUE(loaded.is_valid());
+  EXPECT_EQ(loaded.hash(), fake);
+  EXPECT_FALSE(loaded.verify_hash());
+  PoolColumns columns = s.pool_load_columns(fake);
+  ASSERT_TRUE(columns.is_valid());
+  EXPECT_EQ(columns.pool().hash(), fake);
+  EXPECT_FALSE(columns.pool().verify_hash());
+
+  // Проверяется каждый второй прочитанный пул.
+  s.set_load_verification_interval(2);
+  EXPECT_EQ(s.load_verification_interval(), static_cast<size_t>(2));
+  EXPECT_TRUE(s.pool_load(fake).is_valid());
+  EXPECT_FALSE(s.pool_load(fake).is_valid());
+  EXPECT_EQ(s.last_error(), Storage::DataIntegrityError);
+
+  s.set_load_verification_interval(1);
+  EXPECT_FALSE(s.pool_load(fake).is_valid());
+  EXPECT_TRUE(s.pool_load(pool.hash()).is_valid());
+  EXPECT_FALSE(s.pool_load_columns(fake).is_valid());
+  EXPECT_EQ(s.last_error(), Storage::DataIntegrityError);
+  columns = s.pool_load_columns(pool.hash());
+  ASSERT_TRUE(columns.is_valid());
+  EXPECT_EQ(columns.pool(), pool);
+
+  // Записи без контрольной суммы проверяются всегда.
+  s.set_load_verification_interval(0);
+  ASSERT_TRUE(db->put(fake.to_binary(), pool.to_binary()));
+  EXPECT_FALSE(s.pool_load(fake).is_valid());
+  ASSERT_TRUE(db->put(pool.hash().to_binary(), pool.to_binary()));
+  EXPECT_EQ(s.pool_load(pool.hash()).hash(), pool.hash());
+}
+
+TEST_F(StorageTestEmpty, IncrementalVerification)
+{
+  auto leveldb = ::std::make_shared<DatabaseLevelDB>();
+  ASSERT_TRUE(leveldb->open(path_to_tests));
+  ::std::shared_ptr<Database> db = leveldb;
+  Storage s;
+  ASSERT_TRUE(s.open(Storage::OpenOptions{db}));
+
+  ::std::vector<Pool> pools;
+  auto add_pools = [&](size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      Pool pool{pools.empty() ? PoolHash{} : pools.back().hash(), pools.size()};
+      EXPECT_TRUE(pool.add_transaction(Transaction(addr1, addr2, Currency("RUB"), Amount(static_cast<int32_t>(i + 1))),
+                                       true));
+      ASSERT_TRUE(pool.compose());
+      ASSERT_TRUE(s.pool_save(pool));
+      pools.push_back(pool);
+    }
+  };
+  auto corrupt = [&db](const PoolHash& hash) {
+    internal::byte_array record;
+    EXPECT_TRUE(db->get(hash.to_binary(), &record));
+    const internal::byte_array original = record;
+    record.back() ^= 0x01;
+    EXPECT_TRUE(db->put(hash.to_binary(), record));
+    return original;
+  };
+
+  add_pools(10);
+  s.close();
+  ASSERT_TRUE(s.open(Storage::OpenOptions{db}));
+  EXPECT_EQ(s.size(), pools.size());
+  s.close();
+
+  // Пулы, проверенные при предыдущем открытии, не проверяются повторно.
+  internal::byte_array record = corrupt(pools[3].hash());
+  ASSERT_TRUE(s.open(Storage::OpenOptions{db}));
+  EXPECT_EQ(s.size(), pools.size());
+  EXPECT_EQ(s.last_hash(), pools.back().hash());
+  s.close();
+  for (Storage::Verification verification : {Storage::ChecksumVerification, Storage::FullVerification}) {
+    EXPECT_FALSE(s.open(Storage::OpenOptions{db, verification}));
+    EXPECT_EQ(s.last_error(), Storage::DataIntegrityError);
+  }
+  ASSERT_TRUE(db->put(pools[3].hash().to_binary(), record));
+
+  // Новые пулы проверяются.
+  ASSERT_TRUE(s.open(Storage::OpenOptions{db}));
+  add_pools(5);
+  s.close();
+  record = corrupt(pools[12].hash());
+  EXPECT_FALSE(s.open(Storage::OpenOptions{db}));
+  EXPECT_EQ(s.last_error(), Storage::DataIntegrityError);
+  ASSERT_TRUE(db->put(pools[12].hash().to_binary(), record));
+  ASSERT_TRUE(s.open(Storage::OpenOptions{db}));
+  EXPECT_EQ(s.size(), pools.size());
+  s.close();
+
+  // Запись без контрольной суммы под чужим ключом и с номером в пределах границы.
+  const PoolHash fake = PoolHash::calc_from_data({1, 2, 3});
+  ASSERT_TRUE(db->put(fake.to_binary(), pools[4].to_binary()));
+  ::std::vector<uint64_t> progress;
+  EXPECT_FALSE(s.open(Storage::OpenOptions{db}, [&progress](const Storage::OpenProgress& p) {
+    progress.push_back(p.poolsProcessed);
+    return false;
+  }));
+  EXPECT_EQ(s.last_error(), Storage::DataIntegrityError);
+  // Повторная проверка после несовпадения границы не начинает прогресс заново.
+  ASSERT_EQ(progress.size(), pools.size() + 1);
+  for (size_t i = 0; i < progress.size(); ++i) {
+    EXPECT_EQ(progress[i], i + 1);
+  }
+  ASSERT_TRUE(db->remove(fake.to_binary()));
+  ASSERT_TRUE(s.open(Storage::OpenOptions{db}));
+  EXPECT_EQ(s.size(), pools.size());
+}
+
+TEST_F(StorageTestEmpty, Scrubber)
+{
+  auto leveldb = ::std::make_shared<DatabaseLevelDB>();
+  ASSERT_TRUE(leveldb->open(path_to_tests));
+  ::std::shared_ptr<Database> db = leveldb;
+  Storage s;
+  ASSERT_TRUE(s.open(Storage::OpenOptions{db}));
+
+  ::std::vector<Pool> pools;
+  PoolHash previous;
+  for (Pool::sequence_t i = 0; i < 8; ++i) {
+    if (4 == i) {
+      ASSERT_TRUE(s.train_compression_dictionary());
+      s.set_compression(Storage::DictionaryCompression);
+    }
+    Pool pool{previous, i};
+    for (int j = 0; j < 20; ++j) {
+      EXPECT_TRUE(pool.add_transaction(Transaction((0 == (j % 2)) ? addr1 : addr3, addr2, Currency("RUB"),
+                                                   Amount(j + 1)), true));
+    }
+    ASSERT_TRUE(pool.compose());
+    ASSERT_TRUE(s.pool_save(pool));
+    previous = pool.hash();
+    pools.push_back(pool);
+  }
+
+  ::std::mutex mutex;
+  ::std::vector<PoolHash> problems;
+  auto callback = [&](const PoolHash& hash, const ::std::string& message) {
+    EXPECT_FALSE(message.empty());
+    ::std::lock_guard<::std::mutex> lock(mutex);
+    problems.push_back(hash);
+  };
+  auto wait_passes = [&s](uint64_t passes) {
+    for (int i = 0; (i < 1000) && (s.scrubber_passes() < passes); ++i) {
+      ::std::this_thread::sleep_for(::std::chrono::milliseconds(10));
+    }
+    return s.scrubber_passes() >= passes;
+  };
+
+  ASSERT_TRUE(s.start_scrubber(0, callback));
+  EXPECT_FALSE(s.start_scrubber(0, callback));
+  EXPECT_EQ(s.last_error(), Storage::InvalidParameter);
+  EXPECT_TRUE(wait_passes(2));
+  s.stop_scrubber();
+  EXPECT_TRUE(problems.empty());
+
+  // Повреждённая запись и запись под чужим ключом.
+  internal::byte_array record;
+  ASSERT_TRUE(db->get(pools[2].hash().to_binary(), &record));
+  record[record.size() / 2] ^= 0x01;
+  ASSERT_TRUE(db->put(pools[2].hash().to_binary(), record));
+  const PoolHash fake = PoolHash::calc_from_data({1, 2, 3});
+  ASSERT_TRUE(db->get(pools[5].hash().to_binary(), &record));
+  ASSERT_TRUE(db->put(fake.to_binary(), record));
+
+  ASSERT_TRUE(s.start_scrubber(0, callback));
+  EXPECT_TRUE(wait_passes(1));
+  s.stop_scrubber();
+  ASSERT_FALSE(problems.empty());
+  EXPECT_NE(::std::find(problems.begin(), problems.end(), pools[2].hash()), problems.end());
+  EXPECT_NE(::std::find(problems.begin(), problems.end(), fake), problems.end());
+  EXPECT_EQ(::std::count(problems.begin(), problems.end(), pools[5].hash()), 0);
+
+  // Один проход при ограничении в 100 байт в секунду занимает много секунд.
+  ASSERT_TRUE(s.start_scrubber(100, callback));
+  ::std::this_thread::sleep_for(::std::chrono::milliseconds(300));
+  EXPECT_EQ(s.scrubber_passes(), 0);
+  s.close();
+  EXPECT_FALSE(s.start_scrubber(0, callback));
+  EXPECT_EQ(s.last_error(), Storage::NotOpen);
+}
@@ -2,6 +2,7 @@
 
 #include <cstring>
 #include <iostream>
+#include <unordered_set>
 
 #include <gtest/gtest.h>
 
@@ -87,6 +88,20 @@ TEST_F(TransactionIDTest, FromInvalidString)
   }
 }
 
+TEST_F(TransactionIDTest, StdUnorderedSet)
+{
+  /// \todo Исключить использование этого конструктора TransactionID
+  ::std::unordered_set<TransactionID> ids;
+  EXPECT_TRUE(ids.insert(TransactionID{PoolHash::calc_from_data({1,2,3}), 0}).second);
+  EXPECT_TRUE(ids.insert(TransactionID{PoolHash::calc_from_data({1,2,3}), 1}).second);
+  EXPECT_TRUE(ids.insert(TransactionID{PoolHash::calc_from_data({1,2,4}), 0}).second);
+  EXPECT_FALSE(ids.insert(TransactionID{PoolHash::calc_from_data({1,2,3}), 1}).second);
+
+  EXPECT_EQ(ids.size(), static_cast<size_t>(3));
+  EXPECT_EQ(ids.count(TransactionID{PoolHash::calc_from_data({1,2,4}), 0}), static_cast<size_t>(1));
+  EXPECT_EQ(ids.count(TransactionID{PoolHash::calc_from_data({1,2,4}), 1}), static_cast<size_t>(0));
+}
+
 TEST_F(TransactionTest, SimpleCreation)
 {
   EXPECT_FALSE(Transaction().is_valid());
@@ -215,6 +230,75 @@ TEST_F(TransactionTest, UserFieldSerialize)
   EXPECT_EQ(src, res);
 }
 
+TEST_F(TransactionTest, UserFieldIdRange)
+{
+  Transaction t(addr1, addr2, Currency("CS"), 1_c);
+  EXPECT_TRUE(t.user_field_id_range().empty());
+  EXPECT_TRUE(t.add_user_field(5, 100));
+  EXPECT_TRUE(t.add_user_field(UFID_COMMENT, "Text"));
+  EXPECT_TRUE(t.add_user_field(3, 123.456_c));
+  EXPECT_TRUE(t.add_user_field(7, 1));
+  EXPECT_TRUE(t.add_user_field(3, 1.5_c));
+
+  const UserFieldIdRange ids = t.user_field_id_range();
+  EXPECT_EQ(ids.size(), static_cast<size_t>(4));
+  EXPECT_EQ(::std::vector<user_field_id_t>(ids.begin(), ids.end()),
+            (::std::vector<user_field_id_t>{UFID_COMMENT, 3, 5, 7}));
+  EXPECT_EQ(t.user_field(3), UserField(1.5_c));
+}
+
+TEST_F(TransactionTest, UserFieldSerializeOrder)
+{
+  // Порядок сериализации не зависит от порядка добавления полей.
+  Transaction t1(addr1, addr2, Currency("CS"), 1_c);
+  Transaction t2(addr1, addr2, Currency("CS"), 1_c);
+  for (user_field_id_t id = 0; id < 8; ++id) {
+    EXPECT_TRUE(t1.add_user_field(id, static_cast<uint64_t>(id)));
+    EXPECT_TRUE(t2.add_user_field(7 - id, static_cast<uint64_t>(7 - id)));
+  }
+  EXPECT_EQ(t1.to_binary(), t2.to_binary());
+
+  Transaction res = Transaction::from_binary(t2.to_binary());
+  EXPECT_TRUE(res.is_valid());
+  EXPECT_EQ(res, t1);
+}
+
+TEST_F(TransactionTest, SerializedSize)
+{
+  using ::csdb::priv::obstream;
+  Transaction t(addr1, addr2, Currency("CS"), 123.456_c, -1_c);
+  EXPECT_EQ(obstream::serialized_size(t), t.to_binary().size());
+
+  EXPECT_TRUE(t.add_user_field(1, 100));
+  EXPECT_TRUE(t.add_user_field(2, "Text"));
+  EXPECT_TRUE(t.add_user_field(3, 123.456_c));
+  EXPECT_TRUE(t.add_user_field(1000000, ::std::string(300, 'x')));
+  EXPECT_EQ(obstream::serialized_size(t), t.to_binary().size());
+  EXPECT_EQ(obstream::serialized_size(t), t.to_byte_stream().size());
+  EXPECT_EQ(t.byte_stream_size(), t.to_byte_stream().size());
+}
+
+TEST_F(TransactionTest, ByteStreamAppend)
+{
+  const Transaction t1(addr1, addr2, Currency("CS"), 123.456_c, -1_c);
+  Transaction t2(addr2, addr3, Currency("RUB"), 1_c);
+  EXPECT_TRUE(t2.add_user_field(1, "Text"));
+
+  // Заголовок пакета, затем транзакции подряд.
+  ::csdb::internal::byte_array packet{0xAA, 0xBB};
+  t1.to_byte_stream(packet);
+  t2.to_byte_stream(packet);
+  ASSERT_EQ(packet.size(), 2 + t1.byte_stream_size() + t2.byte_stream_size());
+  EXPECT_EQ(packet[0], 0xAA);
+
+  const char* data = reinterpret_cast<const char*>(packet.data()) + 2;
+  EXPECT_EQ(Transaction::from_byte_stream(data, t1.byte_stream_size()), t1);
+  data += t1.byte_stream_size();
+  const Transaction res = Transaction::from_byte_stream(data, t2.byte_stream_size());
+  EXPECT_EQ(res, t2);
+  EXPECT_EQ(res.user_field(1), t2.user_field(1));
+}
+
 TEST_F(TransactionTest, Balance)
 {
   {